@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "harness.hpp"
+#include "parallel.hpp"
+#include "thread_pool.hpp"
+#include "coroutine.hpp"
+#include "trace.hpp"
+#include "rc.hpp"
+
+
+namespace bu::bench {
+    namespace {
+        constexpr Usize reduce_count = 1 << 20;
+        constexpr Usize sort_count   = 1 << 16;
+
+        auto random_values(Usize const count) -> Vector<long> {
+            Vector<long> values(count);
+            std::mt19937_64 random { 11 };
+            for (long& value : values) {
+                value = static_cast<long>(random() % 1'000'000);
+            }
+            return values;
+        }
+
+
+        // Four threads copy and destroy the same pointer, so every count update contends for
+        // one cache line
+        template <class P>
+        auto copy_shared_pointers_contended(State& state, P const pointer) -> void {
+            constexpr Usize thread_count = 4;
+            state.measure([&] {
+                std::vector<std::thread> threads;
+                for (Usize t = 0; t != thread_count; ++t) {
+                    threads.emplace_back([&] {
+                        for (Usize i = 0; i != state.iterations() / thread_count; ++i) {
+                            P copy = pointer;
+                            do_not_optimize(copy);
+                        }
+                    });
+                }
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+            });
+        }
+
+
+        auto fork_join_fibonacci(ThreadPool& pool, int const n) -> long {
+            if (n < 12) {
+                long a = 0, b = 1;
+                for (int i = 0; i != n; ++i) {
+                    a = std::exchange(b, a + b);
+                }
+                return a;
+            }
+            long a = 0, b = 0;
+            pool.join(
+                [&] { a = fork_join_fibonacci(pool, n - 1); },
+                [&] { b = fork_join_fibonacci(pool, n - 2); });
+            return a + b;
+        }
+
+
+        auto leaf_task(int const value) -> Task<int> {
+            co_return value;
+        }
+        // A chain of `depth` coroutines, each awaiting the next
+        auto chain_task(int const depth) -> Task<int> {
+            if (depth == 0)
+                co_return co_await leaf_task(1);
+            co_return 1 + co_await chain_task(depth - 1);
+        }
+
+        [[gnu::noinline]]
+        auto leaf_function(int const value) -> int {
+            return value;
+        }
+        [[gnu::noinline]]
+        auto chain_function(int const depth) -> int {
+            if (depth == 0)
+                return leaf_function(1);
+            return 1 + chain_function(depth - 1);
+        }
+
+        auto count_up(int const count) -> Generator<int> {
+            for (int i = 0; i != count; ++i) {
+                co_yield i;
+            }
+        }
+
+        // The iterator equivalent of `count_up`, kept opaque so that the loop is not folded away
+        struct CountUp {
+            int current;
+            int count;
+
+            [[gnu::noinline]]
+            auto next() -> Option<int> {
+                if (current == count)
+                    return nullopt;
+                return current++;
+            }
+        };
+
+        auto consume_event(trace::Event const& event) -> void {
+            do_not_optimize(event.payload);
+        }
+    }
+
+
+    auto register_concurrency_benchmarks(Registry& registry) -> void {
+        registry.add("parallel/reduce_1m/bu", [](State& state) {
+            Vector<long> const values = random_values(reduce_count);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    Span<long const> const span { values };
+                    do_not_optimize(parallel::reduce(ThreadPool::global(), span, 0L));
+                }
+            });
+        });
+        registry.add("parallel/reduce_1m/std_accumulate", [](State& state) {
+            Vector<long> const values = random_values(reduce_count);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(std::accumulate(values.begin(), values.end(), 0L));
+                }
+            });
+        });
+
+        // Both sorts include copying the input into the buffer, which is small next to the
+        // sort itself
+        registry.add("parallel/sort_64k/bu", [](State& state) {
+            Vector<long> const values = random_values(sort_count);
+            Vector<long>       buffer(sort_count);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::copy(values.begin(), values.end(), buffer.begin());
+                    parallel::sort(ThreadPool::global(), Span<long> { buffer });
+                    do_not_optimize(buffer.data());
+                }
+            });
+        });
+        registry.add("parallel/sort_64k/std_sort", [](State& state) {
+            Vector<long> const values = random_values(sort_count);
+            Vector<long>       buffer(sort_count);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::copy(values.begin(), values.end(), buffer.begin());
+                    std::sort(buffer.begin(), buffer.end());
+                    do_not_optimize(buffer.data());
+                }
+            });
+        });
+
+        registry.add("shared_ptr/copy_destroy_4_threads/bu_arc", [](State& state) {
+            copy_shared_pointers_contended(state, make_arc<int>(1));
+        });
+        registry.add("shared_ptr/copy_destroy_4_threads/std", [](State& state) {
+            copy_shared_pointers_contended(state, std::make_shared<int>(1));
+        });
+
+        registry.add("thread_pool/spawn_and_join_tiny_task", [](State& state) {
+            ThreadPool& pool = ThreadPool::global();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(pool.spawn([i] { return i; }).join().value());
+                }
+            });
+        });
+        registry.add("thread_pool/fork_join_fibonacci_24", [](State& state) {
+            ThreadPool& pool = ThreadPool::global();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    pool.run([&] { do_not_optimize(fork_join_fibonacci(pool, 24)); });
+                }
+            });
+        });
+
+        registry.add("coroutine/await_chain_16/bu_task", [](State& state) {
+            EventLoop loop;
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(loop.run_until_complete(chain_task(16)));
+                }
+            });
+        });
+        registry.add("coroutine/await_chain_16/function_calls", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(chain_function(16));
+                }
+            });
+        });
+        registry.add("coroutine/sum_1024/bu_generator", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    long sum = 0;
+                    for (int const value : count_up(1024)) {
+                        sum += value;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        });
+        registry.add("coroutine/sum_1024/iterator", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    long sum = 0;
+                    CountUp counter { 0, 1024 };
+                    for (Option<int> value = counter.next(); value; value = counter.next()) {
+                        sum += value.value();
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        });
+
+        // Draining every 1024 events keeps the ring from filling, so the drop path is not what
+        // is measured
+        registry.add("trace/record_instant/bu", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    trace::instant<"bench.instant">(i);
+                    if (i % 1024 == 1023)
+                        (void)trace::drain(consume_event);
+                }
+            });
+        });
+        registry.add("trace/record_scope/bu", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    {
+                        trace::Scope<"bench.scope"> const scope { i };
+                    }
+                    if (i % 512 == 511)
+                        (void)trace::drain(consume_event);
+                }
+            });
+        });
+    }
+}
@@ -0,0 +1,389 @@
+#include <deque>
+#include <map>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "harness.hpp"
+#include "deque.hpp"
+#include "priority_queue.hpp"
+#include "slot_map.hpp"
+#include "soa_vector.hpp"
+#include "flat_map.hpp"
+#include "btree_map.hpp"
+#include "bit_vector.hpp"
+
+
+namespace bu::bench {
+    namespace {
+        // Keys in random order, shared by the map benchmarks so that every map sees the same
+        // workload
+        auto shuffled_keys(Usize const count) -> std::vector<std::uint64_t> {
+            std::vector<std::uint64_t> keys(count);
+            std::mt19937_64 random { 42 };
+            for (std::uint64_t& key : keys) {
+                key = random();
+            }
+            return keys;
+        }
+
+
+        // A steady-state work queue: the queue holds 1024 elements and every iteration pushes
+        // one and pops one
+        template <class Q>
+        auto steady_queue(State& state) -> void {
+            Q queue;
+            for (int j = 0; j != 1024; ++j) {
+                queue.push_back(j);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    queue.push_back(static_cast<int>(i));
+                    do_not_optimize(queue.front());
+                    queue.pop_front();
+                }
+            });
+        }
+
+        template <class Q>
+        auto index_queue(State& state) -> void {
+            Q queue;
+            for (int j = 0; j != 4096; ++j) {
+                queue.push_front(j);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    long sum = 0;
+                    for (Usize j = 0; j < 4096; j += 7) {
+                        sum += queue[j];
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        auto sum_deque_segments(State& state) -> void {
+            Deque<int> queue;
+            for (int j = 0; j != 4096; ++j) {
+                queue.push_back(j);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    long sum = 0;
+                    for (Span<int const> const segment : std::as_const(queue).segments()) {
+                        for (int const element : segment) {
+                            sum += element;
+                        }
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+
+        // A timer workload: 4096 pending deadlines, every iteration fires the earliest and
+        // schedules a later one
+        template <class Q, class Push, class Pop>
+        auto timer_queue(State& state, Push const push, Pop const pop) -> void {
+            Q queue;
+            std::mt19937_64 random { 7 };
+            for (int j = 0; j != 4096; ++j) {
+                push(queue, random() % 100'000);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::uint64_t const now = pop(queue);
+                    push(queue, now + 1 + random() % 100'000);
+                }
+            });
+        }
+
+        using BuTimers  = PriorityQueue<std::uint64_t, std::greater<>>;
+        using StdTimers =
+            std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>>;
+
+
+        auto slot_map_churn(State& state) -> void {
+            SlotMap<std::uint64_t> map;
+            std::vector<SlotMapKey> keys;
+            for (std::uint64_t j = 0; j != 4096; ++j) {
+                keys.push_back(map.insert(j));
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    SlotMapKey& key = keys[i % keys.size()];
+                    do_not_optimize(map.find(key).value());
+                    (void)map.erase(key);
+                    key = map.insert(i);
+                }
+            });
+        }
+        auto unordered_map_churn(State& state) -> void {
+            std::unordered_map<std::uint64_t, std::uint64_t> map;
+            std::vector<std::uint64_t> keys;
+            std::uint64_t next_key = 0;
+            for (std::uint64_t j = 0; j != 4096; ++j) {
+                map.emplace(next_key, j);
+                keys.push_back(next_key++);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::uint64_t& key = keys[i % keys.size()];
+                    do_not_optimize(map.find(key)->second);
+                    map.erase(key);
+                    map.emplace(next_key, i);
+                    key = next_key++;
+                }
+            });
+        }
+
+
+        struct Particle {
+            float x, y, z;
+            float velocity_x, velocity_y, velocity_z;
+            float mass;
+            int   id;
+        };
+
+        constexpr Usize particle_count = 1 << 14;
+
+        auto sum_soa_column(State& state) -> void {
+            SoaVector<float, float, float, float, float, float, float, int> particles;
+            for (Usize j = 0; j != particle_count; ++j) {
+                auto const mass = static_cast<float>(j);
+                auto const id   = static_cast<int>(j);
+                particles.append(1.f, 2.f, 3.f, 0.f, 0.f, 0.f, mass, id);
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    float sum = 0;
+                    for (float const mass : particles.field<6>()) {
+                        sum += mass;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+        auto sum_aos_column(State& state) -> void {
+            Vector<Particle> particles;
+            for (Usize j = 0; j != particle_count; ++j) {
+                auto const mass = static_cast<float>(j);
+                auto const id   = static_cast<int>(j);
+                particles.append(Particle { 1.f, 2.f, 3.f, 0.f, 0.f, 0.f, mass, id });
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    float sum = 0;
+                    for (Particle const& particle : particles) {
+                        sum += particle.mass;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+
+        constexpr Usize map_size = 4096;
+
+        // Looks up every key of a map of `map_size` keys, in random order
+        template <class M, class Find>
+        auto lookup_map(State& state, M const& map, Find const find) -> void {
+            std::vector<std::uint64_t> const keys = shuffled_keys(map_size);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(find(map, keys[i % map_size]));
+                }
+            });
+        }
+
+        auto lookup_flat_map(State& state) -> void {
+            Vector<std::uint64_t> keys;
+            Vector<std::uint64_t> values;
+            for (std::uint64_t const key : shuffled_keys(map_size)) {
+                keys.append(key);
+                values.append(key);
+            }
+            FlatMap<std::uint64_t, std::uint64_t> const map { std::move(keys), std::move(values) };
+            lookup_map(state, map, [](auto const& map, std::uint64_t const key) {
+                return map.find(key).value();
+            });
+        }
+        auto lookup_btree_map(State& state) -> void {
+            BTreeMap<std::uint64_t, std::uint64_t> map;
+            for (std::uint64_t const key : shuffled_keys(map_size)) {
+                (void)map.insert(key, key);
+            }
+            lookup_map(state, map, [](auto const& map, std::uint64_t const key) {
+                return map.find(key).value();
+            });
+        }
+        auto lookup_std_map(State& state) -> void {
+            std::map<std::uint64_t, std::uint64_t> map;
+            for (std::uint64_t const key : shuffled_keys(map_size)) {
+                map.emplace(key, key);
+            }
+            lookup_map(state, map, [](auto const& map, std::uint64_t const key) {
+                return map.find(key)->second;
+            });
+        }
+        auto lookup_unordered_map(State& state) -> void {
+            std::unordered_map<std::uint64_t, std::uint64_t> map;
+            for (std::uint64_t const key : shuffled_keys(map_size)) {
+                map.emplace(key, key);
+            }
+            lookup_map(state, map, [](auto const& map, std::uint64_t const key) {
+                return map.find(key)->second;
+            });
+        }
+
+        // Builds a map of `map_size` random keys per iteration
+        template <class M, class Insert>
+        auto build_map(State& state, Insert const insert) -> void {
+            std::vector<std::uint64_t> const keys = shuffled_keys(map_size);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    M map;
+                    for (std::uint64_t const key : keys) {
+                        insert(map, key);
+                    }
+                    do_not_optimize(map);
+                }
+            });
+        }
+
+        // Sums the values of every key in a range covering a quarter of the key space
+        template <class M, class Insert, class Scan>
+        auto scan_map(State& state, Insert const insert, Scan const scan) -> void {
+            M map;
+            for (std::uint64_t const key : shuffled_keys(map_size)) {
+                insert(map, key);
+            }
+            std::uint64_t const first = maximum<std::uint64_t> / 8 * 3;
+            std::uint64_t const last  = maximum<std::uint64_t> / 8 * 5;
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(scan(map, first, last));
+                }
+            });
+        }
+
+
+        constexpr Usize bit_count = 1 << 20;
+
+        auto random_bits() -> BitVector<> {
+            BitVector<> bits(bit_count);
+            std::mt19937_64 random { 3 };
+            for (Usize j = 0; j != bit_count; ++j) {
+                if (random() % 3 == 0)
+                    bits.set(j);
+            }
+            return bits;
+        }
+    }
+
+
+    auto register_container_benchmarks(Registry& registry) -> void {
+        registry.add("deque/steady_queue/bu",         steady_queue<Deque<int>>);
+        registry.add("deque/steady_queue/std",        steady_queue<std::deque<int>>);
+        registry.add("deque/strided_index_4096/bu",   index_queue<Deque<int>>);
+        registry.add("deque/strided_index_4096/std",  index_queue<std::deque<int>>);
+        registry.add("deque/sum_segments_4096/bu",    sum_deque_segments);
+
+        registry.add("priority_queue/timers_4096/bu", [](State& state) {
+            timer_queue<BuTimers>(state,
+                [](BuTimers& queue, std::uint64_t const deadline) { queue.push(deadline); },
+                [](BuTimers& queue) { return queue.pop(); });
+        });
+        registry.add("priority_queue/timers_4096/std", [](State& state) {
+            timer_queue<StdTimers>(state,
+                [](StdTimers& queue, std::uint64_t const deadline) { queue.push(deadline); },
+                [](StdTimers& queue) {
+                    std::uint64_t const top = queue.top();
+                    queue.pop();
+                    return top;
+                });
+        });
+
+        registry.add("slot_map/find_erase_insert/bu",              slot_map_churn);
+        registry.add("slot_map/find_erase_insert/std_unordered",   unordered_map_churn);
+
+        registry.add("soa_vector/sum_one_field_16k/bu_soa",        sum_soa_column);
+        registry.add("soa_vector/sum_one_field_16k/bu_aos",        sum_aos_column);
+
+        registry.add("map/lookup_4096/bu_flat_map",                lookup_flat_map);
+        registry.add("map/lookup_4096/bu_btree_map",               lookup_btree_map);
+        registry.add("map/lookup_4096/std_map",                    lookup_std_map);
+        registry.add("map/lookup_4096/std_unordered_map",          lookup_unordered_map);
+
+        registry.add("map/build_4096/bu_flat_map", [](State& state) {
+            build_map<FlatMap<std::uint64_t, std::uint64_t>>(state,
+                [](auto& map, std::uint64_t const key) { (void)map.insert(key, key); });
+        });
+        registry.add("map/build_4096/bu_btree_map", [](State& state) {
+            build_map<BTreeMap<std::uint64_t, std::uint64_t>>(state,
+                [](auto& map, std::uint64_t const key) { (void)map.insert(key, key); });
+        });
+        registry.add("map/build_4096/std_map", [](State& state) {
+            build_map<std::map<std::uint64_t, std::uint64_t>>(state,
+                [](auto& map, std::uint64_t const key) { map.emplace(key, key); });
+        });
+
+        registry.add("map/scan_quarter_4096/bu_btree_map", [](State& state) {
+            scan_map<BTreeMap<std::uint64_t, std::uint64_t>>(state,
+                [](auto& map, std::uint64_t const key) { (void)map.insert(key, key); },
+                [](auto const& map, std::uint64_t const first, std::uint64_t const last) {
+                    std::uint64_t sum = 0;
+                    for (auto const entry : map.range(first, last)) {
+                        sum += entry.value;
+                    }
+                    return sum;
+                });
+        });
+        registry.add("map/scan_quarter_4096/std_map", [](State& state) {
+            scan_map<std::map<std::uint64_t, std::uint64_t>>(state,
+                [](auto& map, std::uint64_t const key) { map.emplace(key, key); },
+                [](auto const& map, std::uint64_t const first, std::uint64_t const last) {
+                    std::uint64_t sum = 0;
+                    auto it = map.lower_bound(first);
+                    for (; it != map.end() && it->first < last; ++it) {
+                        sum += it->second;
+                    }
+                    return sum;
+                });
+        });
+
+        registry.add("bit_vector/count_1m/bu", [](State& state) {
+            BitVector<> const bits = random_bits();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(bits.count());
+                }
+            });
+        });
+        registry.add("bit_vector/count_1m/std", [](State& state) {
+            BitVector<> const source = random_bits();
+            std::vector<bool> bits(bit_count);
+            for (Usize j = 0; j != bit_count; ++j) {
+                bits[j] = source[j];
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(std::count(bits.begin(), bits.end(), true));
+                }
+            });
+        });
+        registry.add("bit_vector/rank_select_1m/bu", [](State& state) {
+            BitVector<> const bits = random_bits();
+            RankSelect const index { bits.words() };
+            Usize const ones = bits.count();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    Usize const position = (i * 0x9E3779B97F4A7C15) % bit_count;
+                    do_not_optimize(index.rank(position));
+                    do_not_optimize(index.select(index.rank(position) % ones));
+                }
+            });
+        });
+    }
+}
@@ -0,0 +1,448 @@
+#include <any>
+#include <array>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "harness.hpp"
+#include "list.hpp"
+#include "result.hpp"
+#include "any.hpp"
+#include "memory.hpp"
+#include "rc.hpp"
+#include "array.hpp"
+#include "variant.hpp"
+
+
+namespace bu::bench {
+    namespace {
+        constexpr Usize small_count = 1024;
+
+        template <class V>
+        auto append_ints(State& state) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    V vector;
+                    for (int j = 0; j != static_cast<int>(small_count); ++j) {
+                        if constexpr (requires { vector.append(j); })
+                            vector.append(j);
+                        else
+                            vector.push_back(j);
+                    }
+                    do_not_optimize(vector.data());
+                }
+            });
+        }
+
+        template <class V>
+        auto sum_ints(State& state) -> void {
+            V vector(small_count);
+            std::iota(vector.begin(), vector.end(), 0);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(vector.data());
+                    long sum = 0;
+                    for (int const element : vector) {
+                        sum += element;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        template <class V>
+        auto copy_ints(State& state) -> void {
+            V vector(small_count);
+            std::iota(vector.begin(), vector.end(), 0);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    V copy = vector;
+                    do_not_optimize(copy.data());
+                }
+            });
+        }
+
+        template <class L>
+        auto append_and_iterate_list(State& state) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    L list;
+                    for (int j = 0; j != 256; ++j) {
+                        if constexpr (requires { list.append(j); })
+                            list.append(j);
+                        else
+                            list.push_back(j);
+                    }
+                    long sum = 0;
+                    for (int const element : list) {
+                        sum += element;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        // Every third element is empty so that the branch is not perfectly predictable
+        template <class O>
+        auto sum_options(State& state) -> void {
+            std::vector<O> options;
+            for (int j = 0; j != static_cast<int>(small_count); ++j) {
+                options.push_back(j % 3 ? O { j } : O {});
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(options.data());
+                    long sum = 0;
+                    for (O const& option : options) {
+                        sum += option.value_or(-1);
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        template <class S>
+        auto copy_string_options(State& state) -> void {
+            S const option { std::string(64, 'x') };
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    S copy = option;
+                    do_not_optimize(copy);
+                }
+            });
+        }
+
+        enum class ParseError { negative };
+
+        [[gnu::noinline]]
+        auto checked_bu(int const value) -> Result<int, ParseError> {
+            if (value < 0)
+                return Err { ParseError::negative };
+            return Ok { value * 2 };
+        }
+        [[gnu::noinline]]
+        auto checked_std(int const value) -> std::variant<int, ParseError> {
+            if (value < 0)
+                return ParseError::negative;
+            return value * 2;
+        }
+
+        auto sum_results_bu(State& state) -> void {
+            state.measure([&] {
+                long sum = 0;
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const result = checked_bu(static_cast<int>(i % 7) - 1);
+                    sum += result.is_ok() ? result.value() : 0;
+                }
+                do_not_optimize(sum);
+            });
+        }
+        auto sum_results_std(State& state) -> void {
+            state.measure([&] {
+                long sum = 0;
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const result = checked_std(static_cast<int>(i % 7) - 1);
+                    sum += result.index() == 0 ? std::get<0>(result) : 0;
+                }
+                do_not_optimize(sum);
+            });
+        }
+
+        using LargeValue = std::array<char, 64>;
+
+        template <class T>
+        auto construct_and_cast_bu_any(State& state) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    Any any { in_place_type<T> };
+                    do_not_optimize(any.cast<T>());
+                }
+            });
+        }
+        template <class T>
+        auto construct_and_cast_std_any(State& state) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::any any { std::in_place_type<T> };
+                    do_not_optimize(std::any_cast<T&>(any));
+                }
+            });
+        }
+
+        template <class P, class Make>
+        auto sum_through_pointers(State& state, Make const make) -> void {
+            std::vector<P> pointers;
+            for (int j = 0; j != static_cast<int>(small_count); ++j) {
+                pointers.push_back(make(j));
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    long sum = 0;
+                    for (P const& pointer : pointers) {
+                        sum += *pointer;
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        template <class P, class Make>
+        auto create_pointers(State& state, Make const make) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    P pointer = make(static_cast<int>(i));
+                    do_not_optimize(pointer);
+                }
+            });
+        }
+
+        template <class P>
+        auto copy_shared_pointers(State& state, P const pointer) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    P copy = pointer;
+                    do_not_optimize(copy);
+                }
+            });
+        }
+
+        // Sums a span by repeatedly dropping its first element, exercising slicing as well as
+        // access
+        template <class S>
+        auto sum_span_prefixes(State& state) -> void {
+            std::vector<int> values(small_count);
+            std::iota(values.begin(), values.end(), 0);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    S span { values.data(), values.size() };
+                    long sum = 0;
+                    while (!span.empty()) {
+                        sum += span.front();
+                        span = span.subspan(1);
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        // Adapts `bu::Span` to the interface used by `sum_span_prefixes`
+        struct BuSpanAdapter {
+            Span<int> span;
+            BuSpanAdapter(int* const data, Usize const size) : span { data, size } {}
+            BuSpanAdapter(Span<int> const span) : span { span } {}
+            auto empty() const -> bool { return span.is_empty(); }
+            auto front() const -> int { return *span.begin(); }
+            auto subspan(Usize const offset) const -> BuSpanAdapter {
+                return span.without_prefix(offset);
+            }
+        };
+
+        template <class A>
+        auto fill_and_compare_arrays(State& state) -> void {
+            A a {};
+            A b {};
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    a.fill(static_cast<int>(i));
+                    b.fill(static_cast<int>(i));
+                    do_not_optimize(a);
+                    bool const equal = a == b;
+                    do_not_optimize(equal);
+                }
+            });
+        }
+
+        auto dot_arrays_bu(State& state) -> void {
+            Array<float, 16> a {};
+            Array<float, 16> b {};
+            std::iota(a.begin(), a.end(), 1.0f);
+            std::iota(b.begin(), b.end(), 2.0f);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(a);
+                    do_not_optimize(a.dot(b));
+                }
+            });
+        }
+        auto dot_arrays_std(State& state) -> void {
+            std::array<float, 16> a {};
+            std::array<float, 16> b {};
+            std::iota(a.begin(), a.end(), 1.0f);
+            std::iota(b.begin(), b.end(), 2.0f);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(a);
+                    do_not_optimize(std::inner_product(a.begin(), a.end(), b.begin(), 0.0f));
+                }
+            });
+        }
+
+        struct Circle    { float radius; };
+        struct Square    { float side; };
+        struct Rectangle { float width; float height = 2; };
+        struct Triangle  { float base; float height = 3; };
+        struct Ellipse   { float a; float b = 4; };
+        struct Point     { float x; };
+
+        struct ShapeArea {
+            static constexpr float pi = 3.14159f;
+
+            auto operator()(Circle const& c)    const -> float { return pi * c.radius * c.radius; }
+            auto operator()(Square const& s)    const -> float { return s.side * s.side; }
+            auto operator()(Rectangle const& r) const -> float { return r.width * r.height; }
+            auto operator()(Triangle const& t)  const -> float { return 0.5f * t.base * t.height; }
+            auto operator()(Ellipse const& e)   const -> float { return pi * e.a * e.b; }
+            auto operator()(Point const&)       const -> float { return 0.0f; }
+        };
+
+        // The alternatives are chosen pseudo-randomly so that the dispatch is not predictable
+        template <template <class...> class V, class... Shapes, class Visit>
+        auto sum_shape_areas(State& state, Visit const visit) -> void {
+            V<Shapes...> (* const make_shape[])(float) {
+                [](float const x) -> V<Shapes...> { return Shapes { x }; }...
+            };
+            std::vector<V<Shapes...>> shapes;
+            std::uint32_t seed = 12345;
+            for (Usize j = 0; j != small_count; ++j) {
+                seed = seed * 1664525 + 1013904223;
+                auto const size = static_cast<float>(j % 10);
+                shapes.push_back(make_shape[(seed >> 16) % sizeof...(Shapes)](size));
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(shapes.data());
+                    float sum = 0;
+                    for (V<Shapes...> const& shape : shapes) {
+                        sum += visit(ShapeArea {}, shape);
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        }
+
+        constexpr auto bu_visit = [](auto const& f, auto const& variant) {
+            return BU visit(f, variant);
+        };
+        constexpr auto std_visit = [](auto const& f, auto const& variant) {
+            return std::visit(f, variant);
+        };
+    }
+
+
+    auto register_core_benchmarks(Registry& registry) -> void {
+        registry.add("vector/append_1024_ints/bu",  append_ints<Vector<int>>);
+        registry.add("vector/append_1024_ints/std", append_ints<std::vector<int>>);
+        registry.add("vector/sum_1024_ints/bu",     sum_ints<Vector<int>>);
+        registry.add("vector/sum_1024_ints/std",    sum_ints<std::vector<int>>);
+        registry.add("vector/copy_1024_ints/bu",    copy_ints<Vector<int>>);
+        registry.add("vector/copy_1024_ints/std",   copy_ints<std::vector<int>>);
+
+        registry.add("list/append_and_iterate_256/bu",  append_and_iterate_list<List<int>>);
+        registry.add("list/append_and_iterate_256/std", append_and_iterate_list<std::list<int>>);
+
+        registry.add("option/sum_value_or_1024/bu",    sum_options<Option<int>>);
+        registry.add("option/sum_value_or_1024/std",   sum_options<std::optional<int>>);
+        registry.add("option/copy_string/bu",          copy_string_options<Option<std::string>>);
+        registry.add("option/copy_string/std",
+            copy_string_options<std::optional<std::string>>);
+
+        registry.add("result/return_and_check/bu",     sum_results_bu);
+        registry.add("result/return_and_check/std",    sum_results_std);
+
+        registry.add("any/small/bu",                   construct_and_cast_bu_any<int>);
+        registry.add("any/small/std",                  construct_and_cast_std_any<int>);
+        registry.add("any/large/bu",                   construct_and_cast_bu_any<LargeValue>);
+        registry.add("any/large/std",                  construct_and_cast_std_any<LargeValue>);
+
+        registry.add("unique_ptr/create/bu", [](State& state) {
+            create_pointers<UniquePtr<int>>(state, [](int const value) {
+                return UniquePtr<int> { FromOwning { new int { value } } };
+            });
+        });
+        registry.add("unique_ptr/create/std", [](State& state) {
+            create_pointers<std::unique_ptr<int>>(state, [](int const value) {
+                return std::make_unique<int>(value);
+            });
+        });
+        registry.add("unique_ptr/sum_1024/bu", [](State& state) {
+            sum_through_pointers<UniquePtr<int>>(state, [](int const value) {
+                return UniquePtr<int> { FromOwning { new int { value } } };
+            });
+        });
+        registry.add("unique_ptr/sum_1024/std", [](State& state) {
+            sum_through_pointers<std::unique_ptr<int>>(state, [](int const value) {
+                return std::make_unique<int>(value);
+            });
+        });
+        registry.add("unique_ptr/buffer_64k/bu_make_unique", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const buffer = make_unique<std::byte[]>(1 << 16);
+                    do_not_optimize(buffer.get());
+                }
+            });
+        });
+        registry.add("unique_ptr/buffer_64k/bu_for_overwrite", [](State& state) {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const buffer = allocate_unique_for_overwrite<std::byte[]>(
+                        AlignedAllocator<std::byte> {}, 1 << 16);
+                    do_not_optimize(buffer.get());
+                }
+            });
+        });
+
+        registry.add("shared_ptr/copy_destroy/bu_rc", [](State& state) {
+            copy_shared_pointers(state, make_rc<int>(1));
+        });
+        registry.add("shared_ptr/copy_destroy/bu_arc", [](State& state) {
+            copy_shared_pointers(state, make_arc<int>(1));
+        });
+        registry.add("shared_ptr/copy_destroy/std", [](State& state) {
+            copy_shared_pointers(state, std::make_shared<int>(1));
+        });
+        registry.add("shared_ptr/create/bu_rc", [](State& state) {
+            create_pointers<Rc<int>>(state, [](int const value) {
+                return make_rc<int>(value);
+            });
+        });
+        registry.add("shared_ptr/create/bu_rc_weakable", [](State& state) {
+            create_pointers<Rc<int, true>>(state, [](int const value) {
+                return make_rc<int, true>(value);
+            });
+        });
+        registry.add("shared_ptr/create/std", [](State& state) {
+            create_pointers<std::shared_ptr<int>>(state, [](int const value) {
+                return std::make_shared<int>(value);
+            });
+        });
+
+        registry.add("span/sum_prefixes_1024/bu",      sum_span_prefixes<BuSpanAdapter>);
+        registry.add("span/sum_prefixes_1024/std",     sum_span_prefixes<std::span<int>>);
+
+        registry.add("array/fill_and_compare_256/bu",  fill_and_compare_arrays<Array<int, 256>>);
+        registry.add("array/fill_and_compare_256/std",
+            fill_and_compare_arrays<std::array<int, 256>>);
+        registry.add("array/dot_16_floats/bu",         dot_arrays_bu);
+        registry.add("array/dot_16_floats/std",        dot_arrays_std);
+
+        registry.add("variant/visit_3_alternatives/bu",  [](State& state) {
+            sum_shape_areas<Variant, Circle, Square, Rectangle>(state, bu_visit);
+        });
+        registry.add("variant/visit_3_alternatives/std", [](State& state) {
+            sum_shape_areas<std::variant, Circle, Square, Rectangle>(state, std_visit);
+        });
+        registry.add("variant/visit_6_alternatives/bu",  [](State& state) {
+            sum_shape_areas<Variant, Circle, Square, Rectangle, Triangle, Ellipse, Point>(
+                state, bu_visit);
+        });
+        registry.add("variant/visit_6_alternatives/std", [](State& state) {
+            sum_shape_areas<std::variant, Circle, Square, Rectangle, Triangle, Ellipse, Point>(
+                state, std_visit);
+        });
+    }
+}
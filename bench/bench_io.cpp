@@ -0,0 +1,178 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "harness.hpp"
+#include "serialize.hpp"
+#include "mapped_file.hpp"
+
+
+namespace bu::bench {
+    namespace {
+        constexpr Usize value_count = 1 << 16;
+        constexpr Usize file_size   = Usize { 1 } << 24;
+
+        auto doubles() -> Vector<double> {
+            Vector<double> values(value_count);
+            for (Usize j = 0; j != value_count; ++j) {
+                values.data()[j] = static_cast<double>(j) * 0.5;
+            }
+            return values;
+        }
+
+        // 1024 rows of 64 integers, which are serialized with an offset table
+        auto rows() -> Vector<Vector<int>> {
+            Vector<Vector<int>> rows;
+            for (int j = 0; j != 1024; ++j) {
+                Vector<int>& row = rows.append();
+                for (int k = 0; k != 64; ++k) {
+                    row.append(j + k);
+                }
+            }
+            return rows;
+        }
+
+
+        // A temporary file of `file_size` bytes, removed on destruction
+        class TemporaryFile {
+            char m_path[32] = "/tmp/bulib_bench_XXXXXX";
+        public:
+            TemporaryFile() {
+                int const fd = ::mkstemp(m_path);
+                if (fd == -1) {
+                    std::perror("mkstemp");
+                    std::exit(EXIT_FAILURE);
+                }
+                std::vector<char> block(1 << 16, 'x');
+                for (Usize written = 0; written != file_size; written += block.size()) {
+                    auto const size = static_cast<ssize_t>(block.size());
+                    if (::write(fd, block.data(), block.size()) != size) {
+                        std::perror("write");
+                        std::exit(EXIT_FAILURE);
+                    }
+                }
+                ::close(fd);
+            }
+            TemporaryFile(TemporaryFile const&) = delete;
+            auto operator=(TemporaryFile const&) -> TemporaryFile& = delete;
+            ~TemporaryFile() {
+                ::unlink(m_path);
+            }
+
+            [[nodiscard]]
+            auto path() const noexcept -> char const* {
+                return m_path;
+            }
+        };
+
+        auto sum_bytes(Span<std::byte const> const bytes) -> std::uint64_t {
+            std::uint64_t sum = 0;
+            for (std::byte const byte : bytes) {
+                sum += static_cast<std::uint64_t>(byte);
+            }
+            return sum;
+        }
+    }
+
+
+    auto register_io_benchmarks(Registry& registry) -> void {
+        registry.add("serialize/write_64k_doubles/bu", [](State& state) {
+            Vector<double> const values = doubles();
+            Vector<std::byte>    buffer;
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    buffer.clear();
+                    serialize(values, buffer);
+                    do_not_optimize(buffer.data());
+                }
+            });
+        });
+        registry.add("serialize/write_64k_doubles/memcpy", [](State& state) {
+            Vector<double> const values = doubles();
+            Vector<std::byte>    buffer(sizeof(std::uint64_t) + values.size() * sizeof(double));
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::uint64_t const size = values.size();
+                    std::memcpy(buffer.data(), &size, sizeof size);
+                    std::memcpy(
+                        buffer.data() + sizeof size, values.data(), values.size() * sizeof(double));
+                    do_not_optimize(buffer.data());
+                }
+            });
+        });
+        registry.add("serialize/read_64k_doubles/bu", [](State& state) {
+            Vector<std::byte> const bytes = serialize(doubles());
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    Vector<double> const values = deserialize<Vector<double>>(bytes);
+                    do_not_optimize(values.data());
+                }
+            });
+        });
+        registry.add("serialize/write_1024_rows/bu", [](State& state) {
+            Vector<Vector<int>> const values = rows();
+            Vector<std::byte>         buffer;
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    buffer.clear();
+                    serialize(values, buffer);
+                    do_not_optimize(buffer.data());
+                }
+            });
+        });
+        registry.add("serialize/read_1024_rows/bu", [](State& state) {
+            Vector<std::byte> const bytes = serialize(rows());
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const values = deserialize<Vector<Vector<int>>>(bytes);
+                    do_not_optimize(values.data());
+                }
+            });
+        });
+        registry.add("serialize/view_1024_rows/bu", [](State& state) {
+            Vector<std::byte> const bytes = serialize(rows());
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const view = view_serialized<Vector<Vector<int>>>(bytes);
+                    long sum = 0;
+                    for (Usize row = 0; row < view.size(); row += 31) {
+                        sum += view[row].data()[7];
+                    }
+                    do_not_optimize(sum);
+                }
+            });
+        });
+
+        registry.add("mapped_file/sum_16m/bu", [](State& state) {
+            TemporaryFile const file;
+            MapOptions const    options { .advice = MapAdvice::sequential, .prefault = true };
+            MappedFile const    mapping { file.path(), options };
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(sum_bytes(mapping.bytes()));
+                }
+            });
+        });
+        registry.add("mapped_file/sum_16m/read", [](State& state) {
+            TemporaryFile const file;
+            Vector<std::byte>   buffer(file_size);
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    int const fd = ::open(file.path(), O_RDONLY);
+                    Usize total = 0;
+                    for (;;) {
+                        ssize_t const count = ::read(fd, buffer.data() + total, file_size - total);
+                        if (count <= 0)
+                            break;
+                        total += static_cast<Usize>(count);
+                    }
+                    ::close(fd);
+                    do_not_optimize(sum_bytes(Span<std::byte const> { buffer.data(), total }));
+                }
+            });
+        });
+    }
+}
@@ -0,0 +1,199 @@
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "harness.hpp"
+#include "interner.hpp"
+#include "static_map.hpp"
+#include "hash.hpp"
+
+
+namespace bu::bench {
+    namespace {
+        constexpr char const* keywords[] {
+            "break", "case", "class", "const", "continue", "default", "else", "enum",
+            "for", "if", "import", "module", "return", "struct", "switch", "while",
+        };
+
+        using Keywords = StaticMap<
+            StaticEntry<"break",    0>,  StaticEntry<"case",     1>,
+            StaticEntry<"class",    2>,  StaticEntry<"const",    3>,
+            StaticEntry<"continue", 4>,  StaticEntry<"default",  5>,
+            StaticEntry<"else",     6>,  StaticEntry<"enum",     7>,
+            StaticEntry<"for",      8>,  StaticEntry<"if",       9>,
+            StaticEntry<"import",   10>, StaticEntry<"module",   11>,
+            StaticEntry<"return",   12>, StaticEntry<"struct",   13>,
+            StaticEntry<"switch",   14>, StaticEntry<"while",    15>
+        >;
+
+        auto view(std::string_view const text) noexcept -> StringView {
+            return StringView { text.data(), text.size() };
+        }
+
+        // Identifiers as a lexer would see them, half of them keywords
+        auto identifiers() -> std::vector<std::string> {
+            std::vector<std::string> words;
+            for (int j = 0; j != 256; ++j) {
+                if (j % 2)
+                    words.emplace_back(keywords[j / 2 % std::size(keywords)]);
+                else
+                    words.push_back("identifier_" + std::to_string(j));
+            }
+            return words;
+        }
+
+        [[gnu::noinline]]
+        auto keyword_by_strcmp(char const* const word) -> int {
+            for (int j = 0; j != static_cast<int>(std::size(keywords)); ++j) {
+                if (std::strcmp(word, keywords[j]) == 0)
+                    return j;
+            }
+            return -1;
+        }
+
+
+        template <class S>
+        auto construct_strings(State& state, char const* const text) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    S string { text };
+                    do_not_optimize(string);
+                }
+            });
+        }
+
+        template <class S>
+        auto append_characters(State& state) -> void {
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    S string;
+                    for (int j = 0; j != 100; ++j) {
+                        string += static_cast<char>('a' + j % 26);
+                    }
+                    do_not_optimize(string);
+                }
+            });
+        }
+
+        template <class S>
+        auto find_substring(State& state) -> void {
+            std::string text(4096, 'a');
+            text.replace(4000, 6, "needle");
+            S const haystack { text.c_str() };
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(haystack.find("needle"));
+                }
+            });
+        }
+
+
+        template <class F>
+        auto hash_bytes(State& state, Usize const size, F const hash) -> void {
+            std::string const text(size, 'x');
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(text.data());
+                    do_not_optimize(hash(std::string_view { text }));
+                }
+            });
+        }
+    }
+
+
+    auto register_text_benchmarks(Registry& registry) -> void {
+        static constexpr char const* long_string = "a string which does not fit inline";
+        registry.add("string/construct_short/bu", [](State& state) {
+            construct_strings<String>(state, "short");
+        });
+        registry.add("string/construct_short/std", [](State& state) {
+            construct_strings<std::string>(state, "short");
+        });
+        registry.add("string/construct_long/bu", [](State& state) {
+            construct_strings<String>(state, long_string);
+        });
+        registry.add("string/construct_long/std", [](State& state) {
+            construct_strings<std::string>(state, long_string);
+        });
+        registry.add("string/append_100_chars/bu",       append_characters<String>);
+        registry.add("string/append_100_chars/std",      append_characters<std::string>);
+        registry.add("string/find_in_4096/bu",           find_substring<String>);
+        registry.add("string/find_in_4096/std",          find_substring<std::string>);
+
+        registry.add("interner/intern_existing/bu", [](State& state) {
+            Interner interner;
+            std::vector<std::string> const words = identifiers();
+            for (std::string const& word : words) {
+                (void)interner.intern(view(word));
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::string const& word = words[i % words.size()];
+                    do_not_optimize(interner.intern(view(word)));
+                }
+            });
+        });
+        registry.add("interner/intern_existing/std_unordered_map", [](State& state) {
+            std::unordered_map<std::string, std::uint32_t> interner;
+            std::vector<std::string> const words = identifiers();
+            for (std::string const& word : words) {
+                interner.emplace(word, static_cast<std::uint32_t>(interner.size()));
+            }
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(interner.find(words[i % words.size()])->second);
+                }
+            });
+        });
+
+        registry.add("static_map/keyword_lookup/bu", [](State& state) {
+            std::vector<std::string> const words = identifiers();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    std::string const& word = words[i % words.size()];
+                    do_not_optimize(Keywords::find(view(word)).value_or(-1));
+                }
+            });
+        });
+        registry.add("static_map/keyword_lookup/strcmp_chain", [](State& state) {
+            std::vector<std::string> const words = identifiers();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    do_not_optimize(keyword_by_strcmp(words[i % words.size()].c_str()));
+                }
+            });
+        });
+        registry.add("static_map/keyword_lookup/std_unordered_map", [](State& state) {
+            std::unordered_map<std::string_view, int> map;
+            for (int j = 0; j != static_cast<int>(std::size(keywords)); ++j) {
+                map.emplace(keywords[j], j);
+            }
+            std::vector<std::string> const words = identifiers();
+            state.measure([&] {
+                for (Usize i = 0; i != state.iterations(); ++i) {
+                    auto const it = map.find(words[i % words.size()]);
+                    do_not_optimize(it == map.end() ? -1 : it->second);
+                }
+            });
+        });
+
+        registry.add("hash/16_bytes/bu_wyhash", [](State& state) {
+            hash_bytes(state, 16, [](std::string_view const text) { return wyhash(view(text)); });
+        });
+        registry.add("hash/16_bytes/bu_fnv1a", [](State& state) {
+            hash_bytes(state, 16, [](std::string_view const text) { return fnv1a(view(text)); });
+        });
+        registry.add("hash/16_bytes/std", [](State& state) {
+            hash_bytes(state, 16, std::hash<std::string_view> {});
+        });
+        registry.add("hash/4096_bytes/bu_wyhash", [](State& state) {
+            hash_bytes(state, 4096, [](std::string_view const text) { return wyhash(view(text)); });
+        });
+        registry.add("hash/4096_bytes/std", [](State& state) {
+            hash_bytes(state, 4096, std::hash<std::string_view> {});
+        });
+    }
+}
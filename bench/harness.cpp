@@ -0,0 +1,259 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BULIB_BENCH_PERF_EVENTS
+#endif
+
+#include "harness.hpp"
+
+
+namespace {
+    // Every allocation of the process goes through the replaced operator new below, so that
+    // `bu::DefaultAllocator` and the standard allocators are counted the same way
+    std::atomic<bu::Usize> allocation_count;
+    std::atomic<bu::Usize> allocated_bytes;
+
+    auto counted_allocate(std::size_t const size, std::size_t const alignment) -> void* {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        void* const memory = alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+            ? std::malloc(size ? size : 1)
+            : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (!memory)
+            throw std::bad_alloc {};
+        return memory;
+    }
+
+
+    // A hardware counter of the cache misses of the benchmark thread, disabled outside of
+    // measurements. Misses on other threads, such as thread pool workers, are not counted.
+    class CacheMissCounter {
+        int m_fd = -1;
+    public:
+        CacheMissCounter() {
+#ifdef BULIB_BENCH_PERF_EVENTS
+            perf_event_attr attributes {};
+            attributes.type           = PERF_TYPE_HARDWARE;
+            attributes.size           = sizeof attributes;
+            attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled       = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv     = 1;
+            m_fd = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+        CacheMissCounter(CacheMissCounter const&) = delete;
+        auto operator=(CacheMissCounter const&) -> CacheMissCounter& = delete;
+        ~CacheMissCounter() {
+#ifdef BULIB_BENCH_PERF_EVENTS
+            if (m_fd != -1)
+                ::close(m_fd);
+#endif
+        }
+
+        [[nodiscard]]
+        auto is_available() const noexcept -> bool {
+            return m_fd != -1;
+        }
+
+        auto start() noexcept -> void {
+#ifdef BULIB_BENCH_PERF_EVENTS
+            if (m_fd != -1) {
+                ::ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        auto stop() noexcept -> bu::Option<std::uint64_t> {
+#ifdef BULIB_BENCH_PERF_EVENTS
+            if (m_fd != -1) {
+                ::ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+                std::uint64_t count = 0;
+                if (::read(m_fd, &count, sizeof count) == sizeof count)
+                    return count;
+            }
+#endif
+            return bu::nullopt;
+        }
+    };
+
+    auto cache_miss_counter() -> CacheMissCounter& {
+        static CacheMissCounter counter;
+        return counter;
+    }
+
+
+    struct Snapshot {
+        std::chrono::steady_clock::time_point time;
+        bu::Usize                             allocations = 0;
+        bu::Usize                             bytes = 0;
+    };
+    thread_local Snapshot measurement_start;
+
+
+    auto print_json_string(std::FILE* const file, bu::StringView const string) -> void {
+        std::fputc('"', file);
+        for (char const character : string) {
+            if (character == '"' || character == '\\')
+                std::fputc('\\', file);
+            std::fputc(character, file);
+        }
+        std::fputc('"', file);
+    }
+}
+
+
+auto operator new(std::size_t const size) -> void* {
+    return counted_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+auto operator new(std::size_t const size, std::align_val_t const alignment) -> void* {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+auto operator delete(void* const memory) noexcept -> void {
+    std::free(memory);
+}
+auto operator delete(void* const memory, std::size_t) noexcept -> void {
+    std::free(memory);
+}
+auto operator delete(void* const memory, std::align_val_t) noexcept -> void {
+    std::free(memory);
+}
+auto operator delete(void* const memory, std::size_t, std::align_val_t) noexcept -> void {
+    std::free(memory);
+}
+
+
+namespace bu::bench {
+    auto State::start() -> void {
+        assert(!m_measurement);
+        cache_miss_counter().start();
+        measurement_start = Snapshot {
+            .time        = std::chrono::steady_clock::now(),
+            .allocations = allocation_count.load(std::memory_order_relaxed),
+            .bytes       = allocated_bytes.load(std::memory_order_relaxed),
+        };
+    }
+
+    auto State::stop() -> void {
+        auto const time        = std::chrono::steady_clock::now();
+        auto const allocations = allocation_count.load(std::memory_order_relaxed);
+        auto const bytes       = allocated_bytes.load(std::memory_order_relaxed);
+        m_measurement = Measurement {
+            .elapsed         = time - measurement_start.time,
+            .allocations     = allocations - measurement_start.allocations,
+            .allocated_bytes = bytes - measurement_start.bytes,
+            .cache_misses    = cache_miss_counter().stop(),
+        };
+    }
+
+
+    auto cache_misses_available() -> bool {
+        return cache_miss_counter().is_available();
+    }
+
+
+    auto run(Registry const& registry, RunOptions const& options) -> Vector<Report> {
+        constexpr Usize maximum_iterations = Usize { 1 } << 32;
+
+        Vector<Report> results;
+        for (RegisteredBenchmark const& registered : registry.benchmarks()) {
+            if (!registered.name.contains(options.filter))
+                continue;
+
+            Usize iterations = 1;
+            for (;;) {
+                State state { iterations };
+                registered.benchmark(state);
+                if (!state.measurement()) {
+                    std::fprintf(stderr, "Benchmark %.*s did not call measure\n",
+                        static_cast<int>(registered.name.size()), registered.name.data());
+                    std::exit(EXIT_FAILURE);
+                }
+                Measurement const& measurement = state.measurement().value();
+
+                auto const per_op = [&](auto const total) {
+                    return static_cast<double>(total) / static_cast<double>(iterations);
+                };
+
+                if (measurement.elapsed >= options.minimum_time
+                    || iterations >= maximum_iterations)
+                {
+                    Option<double> cache_misses_per_op;
+                    if (measurement.cache_misses)
+                        cache_misses_per_op = per_op(measurement.cache_misses.value());
+                    results.append(Report {
+                        .name                = registered.name,
+                        .iterations          = iterations,
+                        .nanoseconds_per_op  = per_op(measurement.elapsed.count()),
+                        .allocations_per_op  = per_op(measurement.allocations),
+                        .bytes_per_op        = per_op(measurement.allocated_bytes),
+                        .cache_misses_per_op = cache_misses_per_op,
+                    });
+                    break;
+                }
+
+                // Aim slightly past the minimum time, but never grow by more than 100x from a
+                // noisy short run
+                double const minimum_time  = static_cast<double>(options.minimum_time.count());
+                double const per_iteration = std::max(per_op(measurement.elapsed.count()), 1.0);
+                double const target        = 1.2 * minimum_time / per_iteration;
+                iterations = std::clamp(
+                    static_cast<Usize>(target), iterations * 2, iterations * 100);
+            }
+        }
+        return results;
+    }
+
+
+    auto print_table(Span<Report const> const results) -> void {
+        std::printf("%-52s %14s %12s %14s %14s\n",
+            "benchmark", "ns/op", "allocs/op", "bytes/op", "misses/op");
+        for (Report const& result : results) {
+            std::printf("%-52.*s %14.2f %12.2f %14.1f ",
+                static_cast<int>(result.name.size()), result.name.data(),
+                result.nanoseconds_per_op, result.allocations_per_op, result.bytes_per_op);
+            if (result.cache_misses_per_op)
+                std::printf("%14.2f\n", result.cache_misses_per_op.value());
+            else
+                std::printf("%14s\n", "-");
+        }
+    }
+
+
+    auto write_json(Span<Report const> const results, char const* const path) -> bool {
+        std::FILE* const file = std::fopen(path, "w");
+        if (!file)
+            return false;
+
+        std::fprintf(file, "{\n  \"context\": {\n");
+        std::fprintf(file, "    \"compiler\": \"%s\",\n", __VERSION__);
+        std::fprintf(file, "    \"cache_misses_available\": %s\n",
+            cache_misses_available() ? "true" : "false");
+        std::fprintf(file, "  },\n  \"benchmarks\": [");
+        for (Usize i = 0; i != results.size(); ++i) {
+            Report const& result = results.data()[i];
+            std::fprintf(file, "%s\n    { \"name\": ", i ? "," : "");
+            print_json_string(file, result.name);
+            std::fprintf(file,
+                ", \"iterations\": %zu, \"ns_per_op\": %.3f, \"allocations_per_op\": %.3f"
+                ", \"bytes_per_op\": %.3f, \"cache_misses_per_op\": ",
+                result.iterations,
+                result.nanoseconds_per_op,
+                result.allocations_per_op,
+                result.bytes_per_op);
+            if (result.cache_misses_per_op)
+                std::fprintf(file, "%.3f }", result.cache_misses_per_op.value());
+            else
+                std::fprintf(file, "null }");
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+}
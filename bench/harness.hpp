@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "string.hpp"
+
+
+namespace bu::bench {
+    // Prevents the compiler from optimizing away the computation of `value`
+    template <class T>
+    inline auto do_not_optimize(T const& value) noexcept -> void {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Forces pending writes to memory to be treated as observable
+    inline auto clobber_memory() noexcept -> void {
+        asm volatile("" : : : "memory");
+    }
+
+
+    // What one run of a benchmark body measured, in totals over all iterations
+    struct Measurement {
+        std::chrono::nanoseconds elapsed {};
+        Usize                    allocations = 0;
+        Usize                    allocated_bytes = 0;
+        Option<std::uint64_t>    cache_misses;
+    };
+
+
+    /* Description:
+     *     Passed to every benchmark. The benchmark performs its setup,
+     *     then calls `measure` exactly once with a body which runs the
+     *     operation `iterations()` times. Only the body is measured:
+     *
+     *         registry.add("vector/append/bu", [](bench::State& state) {
+     *             state.measure([&] {
+     *                 for (Usize i = 0; i != state.iterations(); ++i) { ... }
+     *             });
+     *         });
+     */
+    class [[nodiscard]] State {
+        Usize               m_iterations;
+        Option<Measurement> m_measurement;
+
+        auto start() -> void;
+        auto stop() -> void;
+    public:
+        explicit State(Usize const iterations) noexcept
+            : m_iterations { iterations } {}
+
+        [[nodiscard]]
+        auto iterations() const noexcept -> Usize {
+            return m_iterations;
+        }
+
+        template <class F>
+        auto measure(F&& body) -> void {
+            start();
+            std::forward<F>(body)();
+            stop();
+        }
+
+        [[nodiscard]]
+        auto measurement() const noexcept -> Option<Measurement const&> {
+            if (m_measurement)
+                return m_measurement.value();
+            else
+                return nullopt;
+        }
+    };
+
+
+    using Benchmark = void(*)(State&);
+
+    struct RegisteredBenchmark {
+        StringView name;
+        Benchmark  benchmark;
+    };
+
+    class [[nodiscard]] Registry {
+        Vector<RegisteredBenchmark> m_benchmarks;
+    public:
+        // `name` must outlive the registry, string literals are expected
+        auto add(StringView const name, Benchmark const benchmark) -> void {
+            m_benchmarks.append(RegisteredBenchmark { name, benchmark });
+        }
+
+        [[nodiscard]]
+        auto benchmarks() const noexcept -> Span<RegisteredBenchmark const> {
+            return Span<RegisteredBenchmark const> { m_benchmarks.data(), m_benchmarks.size() };
+        }
+    };
+
+
+    struct Report {
+        StringView            name;
+        Usize                 iterations = 0;
+        double                nanoseconds_per_op = 0;
+        double                allocations_per_op = 0;
+        double                bytes_per_op = 0;
+        Option<double>        cache_misses_per_op;
+    };
+
+    struct RunOptions {
+        StringView               filter; // Run only the benchmarks whose name contains this
+        std::chrono::nanoseconds minimum_time = std::chrono::milliseconds { 200 };
+    };
+
+    // Runs every matching benchmark, growing its iteration count until one run takes at
+    // least `options.minimum_time`
+    auto run(Registry const& registry, RunOptions const& options) -> Vector<Report>;
+
+    auto print_table(Span<Report const> results) -> void;
+
+    // Writes the results as JSON to `path`, returns false if the file could not be written
+    auto write_json(Span<Report const> results, char const* path) -> bool;
+
+    // Whether hardware cache-miss counters could be opened, they are commonly unavailable
+    // in containers
+    auto cache_misses_available() -> bool;
+
+
+    auto register_core_benchmarks(Registry& registry) -> void;
+    auto register_container_benchmarks(Registry& registry) -> void;
+    auto register_text_benchmarks(Registry& registry) -> void;
+    auto register_concurrency_benchmarks(Registry& registry) -> void;
+    auto register_io_benchmarks(Registry& registry) -> void;
+}
@@ -0,0 +1,72 @@
+#include <cstdlib>
+
+#include "harness.hpp"
+
+
+namespace {
+    auto print_usage(char const* const program) -> void {
+        std::printf(
+            "Usage: %s [--filter TEXT] [--min-time SECONDS] [--json PATH] [--list]\n"
+            "  --filter TEXT       Run only the benchmarks whose name contains TEXT\n"
+            "  --min-time SECONDS  Minimum measured time per benchmark, 0.2 by default\n"
+            "  --json PATH         Also write the results to PATH as JSON\n"
+            "  --list              List the benchmarks instead of running them\n",
+            program);
+    }
+}
+
+
+auto main(int const argc, char** const argv) -> int {
+    bu::bench::Registry registry;
+    bu::bench::register_core_benchmarks(registry);
+    bu::bench::register_container_benchmarks(registry);
+    bu::bench::register_text_benchmarks(registry);
+    bu::bench::register_concurrency_benchmarks(registry);
+    bu::bench::register_io_benchmarks(registry);
+
+    bu::bench::RunOptions options;
+    char const*           json_path = nullptr;
+    bool                  list      = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bu::StringView const argument = argv[i];
+        bool const           has_next = i + 1 < argc;
+        if (argument == "--filter" && has_next) {
+            options.filter = argv[++i];
+        }
+        else if (argument == "--min-time" && has_next) {
+            auto const nanoseconds = static_cast<std::int64_t>(std::atof(argv[++i]) * 1e9);
+            options.minimum_time   = std::chrono::nanoseconds { nanoseconds };
+        }
+        else if (argument == "--json" && has_next) {
+            json_path = argv[++i];
+        }
+        else if (argument == "--list") {
+            list = true;
+        }
+        else {
+            print_usage(argv[0]);
+            return argument == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (list) {
+        for (bu::bench::RegisteredBenchmark const& benchmark : registry.benchmarks()) {
+            std::printf("%.*s\n", static_cast<int>(benchmark.name.size()), benchmark.name.data());
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (!bu::bench::cache_misses_available())
+        std::printf("Hardware cache-miss counters are unavailable, misses/op is not reported\n");
+
+    bu::Vector<bu::bench::Report> const results = bu::bench::run(registry, options);
+    bu::Span<bu::bench::Report const> const reports { results.data(), results.size() };
+    bu::bench::print_table(reports);
+
+    if (json_path && !bu::bench::write_json(reports, json_path)) {
+        std::fprintf(stderr, "Could not write %s\n", json_path);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
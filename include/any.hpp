@@ -2,6 +2,7 @@
 
 #include "utility.hpp"
 #include "exception.hpp"
+#include "perf_fwd.hpp"
 
 
 namespace bu {
@@ -69,9 +70,12 @@ namespace bu::dtl {
                     std::move(*static_cast<T*>(from))
                 );
             };
-            table.move_assignment = [](void* from, void* to) noexcept {
-                *static_cast<T*>(to) = std::move(*static_cast<T*>(from));
-            };
+            // Left null for types that are not assignable, such as closures
+            if constexpr (std::is_move_assignable_v<T>) {
+                table.move_assignment = [](void* from, void* to) noexcept {
+                    *static_cast<T*>(to) = std::move(*static_cast<T*>(from));
+                };
+            }
         }
         if constexpr (is_copyable) {
             table.copy_constructor = [](void const* const from, void* const to) {
@@ -80,9 +84,11 @@ namespace bu::dtl {
                     *static_cast<T const*>(from)
                 );
             };
-            table.copy_assignment = [](void const* const from, void* const to) {
-                *static_cast<T*>(to) = *static_cast<T const*>(from);
-            };
+            if constexpr (std::is_copy_assignable_v<T>) {
+                table.copy_assignment = [](void const* const from, void* const to) {
+                    *static_cast<T*>(to) = *static_cast<T const*>(from);
+                };
+            }
         }
         return table;
     }();
@@ -101,10 +107,11 @@ namespace bu::dtl {
         BasicAny() noexcept
             : m_table { nullptr } {}
 
-        template <class... Args, std::constructible_from<Args&&...> T>
+        template <class T, class... Args>
         explicit BasicAny(InPlaceType<T>, Args&&... args)
             noexcept(std::is_nothrow_constructible_v<T, Args&&...>)
-            requires(alignof(T) <= alignof(std::max_align_t))
+            requires std::constructible_from<T, Args&&...>
+                  && (alignof(T) <= alignof(std::max_align_t))
             : m_table { &vtable_for<T, is_movable, is_copyable> }
         {
             std::construct_at(
@@ -237,14 +244,41 @@ namespace bu::dtl {
         auto cast() -> T& {
             return const_cast<T&>(const_cast<BasicAny const*>(this)->cast<T>());
         }
-    private:
+
+        // Precondition: `type() == typeid(T)`
         template <class T>
         auto unchecked_cast() const noexcept -> T const& {
+            assert(type() == typeid(T));
             if constexpr (fits_in_small_any_buffer<T>)
                 return *std::launder(reinterpret_cast<T const*>(m_value.small));
             else
                 return *reinterpret_cast<T const*>(m_value.big);
         }
+        template <class T>
+        auto unchecked_cast() noexcept -> T& {
+            return const_cast<T&>(const_cast<BasicAny const*>(this)->unchecked_cast<T>());
+        }
+
+        // Destroys the held value, if any, and constructs a new one in its place
+        template <class T, class... Args>
+        auto emplace(Args&&... args) -> T&
+            requires std::constructible_from<T, Args&&...>
+                  && (alignof(T) <= alignof(std::max_align_t))
+        {
+            reset();
+            T* const storage = make_storage_for<T>();
+            try {
+                std::construct_at(storage, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                if constexpr (!fits_in_small_any_buffer<T>)
+                    deallocate_dynamic_storage(m_value.big);
+                throw;
+            }
+            m_table = &vtable_for<T, is_movable, is_copyable>;
+            return *storage;
+        }
+    private:
         template <class T>
         auto make_storage_for() -> T* {
             if constexpr (fits_in_small_any_buffer<T>) {
@@ -256,6 +290,8 @@ namespace bu::dtl {
             }
         }
         static auto allocate_dynamic_storage(Usize const bytes) -> std::byte* {
+            [[maybe_unused]]
+            perf::Scope<"bu::Any::allocate_dynamic_storage", perf::hooks_enabled> const probe;
             return static_cast<std::byte*>(::operator new(bytes));
         }
         static auto deallocate_dynamic_storage(std::byte* const storage) -> void {
@@ -267,7 +303,10 @@ namespace bu::dtl {
             if (this == &other)
                 return;
 
-            if (m_table == other.m_table) { // True assignment
+            if (!m_table && !other.m_table)
+                return;
+
+            if (m_table == other.m_table && m_table->*assignment_operator) { // True assignment
                 switch (m_table->state) {
                 case AnyState::nontrivial_big:
                 {
@@ -4,6 +4,48 @@
 #include "utility.hpp"
 #include "concepts.hpp"
 #include "exception.hpp"
+#include "memory.hpp"
+
+
+namespace bu::dtl {
+    // Arrays of at most this many elements are processed with straight-line code, larger ones
+    // with loops
+    inline constexpr Usize array_unroll_limit = 16;
+
+    // Invokes `f(i)` for every `i` in `[0, count)`, as one statement per index if `count` is
+    // small enough
+    template <Usize count, class F>
+    constexpr auto unrolled_for(F&& f) -> void {
+        if constexpr (count <= array_unroll_limit) {
+            [&]<Usize... indices>(std::index_sequence<indices...>) {
+                (f(indices), ...);
+            }(std::make_index_sequence<count> {});
+        }
+        else {
+            for (Usize i = 0; i != count; ++i) {
+                f(i);
+            }
+        }
+    }
+
+    /* Description:
+     *     Reduces `buffer[0, count)` into `buffer[0]` by repeatedly
+     *     combining the first half with the second, which maps each step
+     *     onto vertical vector operations rather than a serial chain.
+     *     The order of combination differs from a left fold, which
+     *     matters for floating point addition.
+     */
+    template <Usize count, class T, class F>
+    constexpr auto reduce_halves(T* const buffer, F& f) -> void {
+        if constexpr (count > 1) {
+            constexpr Usize half = count / 2;
+            unrolled_for<half>([&](Usize const i) {
+                buffer[i] = f(buffer[i], buffer[i + (count - half)]);
+            });
+            reduce_halves<count - half>(buffer, f);
+        }
+    }
+}
 
 
 namespace bu {
@@ -94,33 +136,123 @@ namespace bu {
                 return nullopt;
         }
 
+        /* Description:
+         *     Compares the elements pairwise. Elements whose values are
+         *     equal exactly when their bytes are, such as integers, are
+         *     compared with `memcmp`. Other arithmetic elements are
+         *     compared in branchless blocks which compile to vector
+         *     comparisons.
+         */
         template <std::equality_comparable_with<T> T2> [[nodiscard]]
         constexpr auto operator==(Array<T2, extent> const& other) const
             noexcept(noexcept(std::declval<T>() != std::declval<T2>())) -> bool
+        {
+            if constexpr (std::same_as<T, T2> && std::has_unique_object_representations_v<T>) {
+                if (!std::is_constant_evaluated())
+                    return std::memcmp(m_array, other.m_array, sizeof m_array) == 0;
+            }
+            if constexpr (std::is_arithmetic_v<T> && std::is_arithmetic_v<T2>) {
+                constexpr Usize block = dtl::array_unroll_limit;
+                for (SizeType start = 0; start < extent; start += block) {
+                    SizeType const stop  = start + block < extent ? start + block : extent;
+                    bool           equal = true;
+                    for (SizeType i = start; i != stop; ++i) {
+                        equal &= m_array[i] == other.m_array[i];
+                    }
+                    if (!equal)
+                        return false;
+                }
+                return true;
+            }
+            else {
+                for (SizeType i = 0; i != extent; ++i) {
+                    if (m_array[i] != other.m_array[i])
+                        return false;
+                }
+                return true;
+            }
+        }
+
+        // Lexicographic comparison
+        template <std::three_way_comparable_with<T> T2> [[nodiscard]]
+        constexpr auto operator<=>(Array<T2, extent> const& other) const
+            noexcept(noexcept(std::declval<T>() <=> std::declval<T2>()))
+            -> std::compare_three_way_result_t<T, T2>
         {
             for (SizeType i = 0; i != extent; ++i) {
-                if (m_array[i] != other.m_array[i])
-                    return false;
+                if (auto const order = m_array[i] <=> other.m_array[i]; order != 0)
+                    return order;
             }
-            return true;
+            return std::compare_three_way_result_t<T, T2>::equivalent;
         }
 
         constexpr auto swap(Array& other)
             noexcept(noexcept(BU swap(m_array[0], m_array[0]))) -> void
             requires swappable<T>
         {
-            for (SizeType i = 0; i != extent; ++i) {
+            dtl::unrolled_for<extent>([&](SizeType const i) {
                 BU swap(m_array[i], other.m_array[i]);
-            }
+            });
         }
-        
-        constexpr auto fill(T element)
-            noexcept(std::is_nothrow_copy_constructible_v<T>) -> void
+
+        // Assigns `element` to every element, large arrays of repeated bytes, such as zeroes,
+        // are filled with `memset`
+        constexpr auto fill(T const& element)
+            noexcept(std::is_nothrow_copy_assignable_v<T>) -> void
         {
-            for (SizeType i = 0; i != extent-1; ++i) {
-                m_array[i] = element;
+            if constexpr (extent > dtl::array_unroll_limit) {
+                BU fill(m_array, m_array + extent, element);
+            }
+            else {
+                dtl::unrolled_for<extent>([&](SizeType const i) {
+                    m_array[i] = element;
+                });
             }
-            back() = std::move(element);
+        }
+
+        /* Description:
+         *     Combines all elements with `f`, which must be associative
+         *     and commutative, in the order of `bu::dtl::reduce_halves`.
+         *     `sum`, `min`, `max` and `dot` are reductions of this kind.
+         */
+        template <class F> [[nodiscard]]
+        constexpr auto reduce(F f) const -> T
+            requires std::is_invocable_r_v<T, F&, T const&, T const&> && std::copyable<T>
+        {
+            Array buffer = *this;
+            dtl::reduce_halves<extent>(buffer.m_array, f);
+            return buffer.m_array[0];
+        }
+
+        [[nodiscard]]
+        constexpr auto sum() const -> T
+            requires requires (T const& a) { { a + a } -> std::convertible_to<T>; }
+        {
+            return reduce([](T const& a, T const& b) -> T { return a + b; });
+        }
+        [[nodiscard]]
+        constexpr auto min() const -> T
+            requires std::totally_ordered<T>
+        {
+            return reduce([](T const& a, T const& b) -> T { return b < a ? b : a; });
+        }
+        [[nodiscard]]
+        constexpr auto max() const -> T
+            requires std::totally_ordered<T>
+        {
+            return reduce([](T const& a, T const& b) -> T { return a < b ? b : a; });
+        }
+
+        // The sum of the pairwise products, summed in the order of `reduce`
+        [[nodiscard]]
+        constexpr auto dot(Array const& other) const -> T
+            requires requires (T const& a) { { a + a * a } -> std::convertible_to<T>; }
+        {
+            Array buffer = *this;
+            dtl::unrolled_for<extent>([&](SizeType const i) {
+                buffer.m_array[i] = buffer.m_array[i] * other.m_array[i];
+            });
+            return buffer.sum();
         }
     };
 
@@ -165,6 +297,13 @@ namespace bu {
         constexpr auto operator!=(Array) const noexcept -> bool {
             return false;
         }
+        [[nodiscard]]
+        constexpr auto operator<=>(Array) const noexcept -> std::strong_ordering {
+            return std::strong_ordering::equal;
+        }
+        constexpr auto fill(T const&) noexcept -> void {
+            // no-op
+        }
         constexpr auto swap(Array&) noexcept -> void {
             // no-op
         }
@@ -0,0 +1,524 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "allocator.hpp"
+#include "option.hpp"
+#include "array.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+    constexpr Usize bits_per_word = 64;
+
+    [[nodiscard]]
+    constexpr auto words_for_bits(Usize const bits) noexcept -> Usize {
+        return (bits + bits_per_word - 1) / bits_per_word;
+    }
+
+    // The mask of the bits of the last word which are within a vector of `bits` bits
+    [[nodiscard]]
+    constexpr auto last_word_mask(Usize const bits) noexcept -> std::uint64_t {
+        Usize const used = bits % bits_per_word;
+        return used ? (std::uint64_t { 1 } << used) - 1 : ~std::uint64_t {};
+    }
+
+    [[nodiscard]]
+    constexpr auto count_bits(std::uint64_t const* const words, Usize const count)
+        noexcept -> Usize
+    {
+        Usize total = 0;
+        for (Usize i = 0; i != count; ++i) {
+            total += static_cast<Usize>(std::popcount(words[i]));
+        }
+        return total;
+    }
+
+    // The position of the first set bit at or after `position`, skipping a whole word per iteration
+    [[nodiscard]]
+    constexpr auto find_set_bit(
+        std::uint64_t const* const words,
+        Usize                const count,
+        Usize                const position) noexcept -> Option<Usize>
+    {
+        Usize index = position / bits_per_word;
+        if (index >= count)
+            return nullopt;
+        std::uint64_t word = words[index] & (~std::uint64_t {} << (position % bits_per_word));
+        while (word == 0) {
+            if (++index == count)
+                return nullopt;
+            word = words[index];
+        }
+        return index * bits_per_word + static_cast<Usize>(std::countr_zero(word));
+    }
+
+    // The position of the set bit of `word` which has `rank` set bits below it.
+    // Precondition: `rank < popcount(word)`
+    [[nodiscard]]
+    inline auto select_in_word(std::uint64_t word, Usize rank) noexcept -> Usize {
+#ifdef __BMI2__
+        return static_cast<Usize>(std::countr_zero(_pdep_u64(std::uint64_t { 1 } << rank, word)));
+#else
+        for (; rank != 0; --rank) {
+            word &= word - 1;
+        }
+        return static_cast<Usize>(std::countr_zero(word));
+#endif
+    }
+
+    enum class BitOperation {
+        bit_and,
+        bit_or,
+        bit_xor,
+        bit_and_not,
+    };
+
+    // `destination[i] = destination[i] operation source[i]`, two words at a time where SSE2
+    // is available
+    template <BitOperation operation>
+    constexpr auto apply_bitwise(
+        std::uint64_t*       const destination,
+        std::uint64_t const* const source,
+        Usize                const count) noexcept -> void
+    {
+        Usize i = 0;
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated()) {
+            for (; i + 2 <= count; i += 2) {
+                auto* const       target = reinterpret_cast<__m128i*>(destination + i);
+                auto const* const other  = reinterpret_cast<__m128i const*>(source + i);
+                __m128i const     a      = _mm_loadu_si128(target);
+                __m128i const     b      = _mm_loadu_si128(other);
+                __m128i result;
+                if constexpr (operation == BitOperation::bit_and)
+                    result = _mm_and_si128(a, b);
+                else if constexpr (operation == BitOperation::bit_or)
+                    result = _mm_or_si128(a, b);
+                else if constexpr (operation == BitOperation::bit_xor)
+                    result = _mm_xor_si128(a, b);
+                else
+                    result = _mm_andnot_si128(b, a);
+                _mm_storeu_si128(target, result);
+            }
+        }
+#endif
+        for (; i != count; ++i) {
+            if constexpr (operation == BitOperation::bit_and)
+                destination[i] &= source[i];
+            else if constexpr (operation == BitOperation::bit_or)
+                destination[i] |= source[i];
+            else if constexpr (operation == BitOperation::bit_xor)
+                destination[i] ^= source[i];
+            else
+                destination[i] &= ~source[i];
+        }
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     A resizable sequence of bits, packed into 64-bit words. Bits
+     *     past the end of the last word are kept zero, so counting and
+     *     searching operate on whole words, and the bulk operations
+     *     combine two bit vectors of equal size with SIMD instructions.
+     */
+    template <allocator_for<std::uint64_t> A = DefaultAllocator<std::uint64_t>>
+    class [[nodiscard]] BitVector {
+        Vector<std::uint64_t, A> m_words;
+        Usize                    m_size = 0;
+    public:
+        using AllocatorType = A;
+        using SizeType      = Usize;
+
+        BitVector() = default;
+
+        explicit BitVector(Usize const size, bool const value = false)
+            : m_words(dtl::words_for_bits(size))
+            , m_size { size }
+        {
+            if (value)
+                set_all();
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_size;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_size == 0;
+        }
+
+        // The underlying words. Bit `i` is bit `i % 64` of word `i / 64`
+        [[nodiscard]]
+        auto words() const noexcept -> Span<std::uint64_t const> {
+            return Span<std::uint64_t const> { m_words.data(), m_words.size() };
+        }
+
+        [[nodiscard]]
+        auto operator[](Usize const index) const -> bool {
+            check_index(index);
+            return (m_words.data()[index / dtl::bits_per_word] >> (index % dtl::bits_per_word)) & 1;
+        }
+
+        auto set(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] |= bit_of(index);
+        }
+        auto reset(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] &= ~bit_of(index);
+        }
+        auto flip(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] ^= bit_of(index);
+        }
+        auto assign(Usize const index, bool const value) -> void {
+            value ? set(index) : reset(index);
+        }
+
+        auto append(bool const value) -> void {
+            if (m_size % dtl::bits_per_word == 0)
+                m_words.append(std::uint64_t { 0 });
+            ++m_size;
+            if (value)
+                m_words.back() |= bit_of(m_size - 1);
+        }
+
+        // Resizes the vector to `size` bits, any new bits being zero
+        auto resize(Usize const size) -> void {
+            Usize const word_count = dtl::words_for_bits(size);
+            m_words.reserve(word_count);
+            while (m_words.size() < word_count) {
+                m_words.append(std::uint64_t { 0 });
+            }
+            while (m_words.size() > word_count) {
+                m_words.pop_back();
+            }
+            m_size = size;
+            clear_unused_bits();
+        }
+
+        auto clear() noexcept -> void {
+            m_words.clear();
+            m_size = 0;
+        }
+
+        auto set_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = ~std::uint64_t {};
+            }
+            clear_unused_bits();
+        }
+        auto reset_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = 0;
+            }
+        }
+        auto flip_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = ~word;
+            }
+            clear_unused_bits();
+        }
+
+        // The number of set bits
+        [[nodiscard]]
+        auto count() const noexcept -> Usize {
+            return dtl::count_bits(m_words.data(), m_words.size());
+        }
+        [[nodiscard]]
+        auto any() const noexcept -> bool {
+            return find_first().has_value();
+        }
+        [[nodiscard]]
+        auto none() const noexcept -> bool {
+            return !any();
+        }
+        [[nodiscard]]
+        auto all() const noexcept -> bool {
+            return count() == m_size;
+        }
+
+        // The position of the first set bit, if any
+        [[nodiscard]]
+        auto find_first() const noexcept -> Option<Usize> {
+            return dtl::find_set_bit(m_words.data(), m_words.size(), 0);
+        }
+        // The position of the first set bit after `position`, if any
+        [[nodiscard]]
+        auto find_next(Usize const position) const noexcept -> Option<Usize> {
+            return dtl::find_set_bit(m_words.data(), m_words.size(), position + 1);
+        }
+
+        // Precondition for the bulk operations: `size() == other.size()`
+        auto operator&=(BitVector const& other) noexcept -> BitVector& {
+            return apply<dtl::BitOperation::bit_and>(other);
+        }
+        auto operator|=(BitVector const& other) noexcept -> BitVector& {
+            return apply<dtl::BitOperation::bit_or>(other);
+        }
+        auto operator^=(BitVector const& other) noexcept -> BitVector& {
+            return apply<dtl::BitOperation::bit_xor>(other);
+        }
+        // Clears the bits which are set in `other`
+        auto and_not(BitVector const& other) noexcept -> BitVector& {
+            return apply<dtl::BitOperation::bit_and_not>(other);
+        }
+
+        [[nodiscard]]
+        auto operator==(BitVector const& other) const noexcept -> bool {
+            return m_size == other.m_size
+                && std::equal(m_words.begin(), m_words.end(), other.m_words.begin());
+        }
+
+        auto swap(BitVector& other) noexcept -> void {
+            m_words.swap(other.m_words);
+            BU swap(m_size, other.m_size);
+        }
+    private:
+        [[nodiscard]]
+        static auto bit_of(Usize const index) noexcept -> std::uint64_t {
+            return std::uint64_t { 1 } << (index % dtl::bits_per_word);
+        }
+
+        auto check_index(Usize const index) const -> void {
+            if (index >= m_size)
+                throw OutOfRange {};
+        }
+
+        auto clear_unused_bits() noexcept -> void {
+            if (!m_words.is_empty())
+                m_words.back() &= dtl::last_word_mask(m_size);
+        }
+
+        template <dtl::BitOperation operation>
+        auto apply(BitVector const& other) noexcept -> BitVector& {
+            assert(m_size == other.m_size);
+            dtl::apply_bitwise<operation>(m_words.data(), other.m_words.data(), m_words.size());
+            return *this;
+        }
+    };
+
+
+    /* Description:
+     *     A fixed-size sequence of `n` bits, the counterpart of
+     *     `bu::BitVector` as `bu::Array` is of `bu::Vector`. Usable in
+     *     constant expressions.
+     */
+    template <Usize n>
+    class [[nodiscard]] BitArray {
+        static_assert(n != 0, "a bu::BitArray must have at least one bit");
+
+        static constexpr Usize word_count = dtl::words_for_bits(n);
+
+        Array<std::uint64_t, word_count> m_words {};
+    public:
+        using SizeType = Usize;
+
+        BitArray() = default;
+
+        [[nodiscard]]
+        static constexpr auto size() noexcept -> Usize {
+            return n;
+        }
+
+        [[nodiscard]]
+        constexpr auto words() const noexcept -> Span<std::uint64_t const> {
+            return Span<std::uint64_t const> { m_words.data(), word_count };
+        }
+
+        [[nodiscard]]
+        constexpr auto operator[](Usize const index) const -> bool {
+            check_index(index);
+            return (m_words.data()[index / dtl::bits_per_word] >> (index % dtl::bits_per_word)) & 1;
+        }
+
+        constexpr auto set(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] |= bit_of(index);
+        }
+        constexpr auto reset(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] &= ~bit_of(index);
+        }
+        constexpr auto flip(Usize const index) -> void {
+            check_index(index);
+            m_words.data()[index / dtl::bits_per_word] ^= bit_of(index);
+        }
+        constexpr auto assign(Usize const index, bool const value) -> void {
+            value ? set(index) : reset(index);
+        }
+
+        constexpr auto set_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = ~std::uint64_t {};
+            }
+            m_words.back() &= dtl::last_word_mask(n);
+        }
+        constexpr auto reset_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = 0;
+            }
+        }
+        constexpr auto flip_all() noexcept -> void {
+            for (std::uint64_t& word : m_words) {
+                word = ~word;
+            }
+            m_words.back() &= dtl::last_word_mask(n);
+        }
+
+        [[nodiscard]]
+        constexpr auto count() const noexcept -> Usize {
+            return dtl::count_bits(m_words.data(), word_count);
+        }
+        [[nodiscard]]
+        constexpr auto any() const noexcept -> bool {
+            return find_first().has_value();
+        }
+        [[nodiscard]]
+        constexpr auto none() const noexcept -> bool {
+            return !any();
+        }
+        [[nodiscard]]
+        constexpr auto all() const noexcept -> bool {
+            return count() == n;
+        }
+
+        [[nodiscard]]
+        constexpr auto find_first() const noexcept -> Option<Usize> {
+            return dtl::find_set_bit(m_words.data(), word_count, 0);
+        }
+        [[nodiscard]]
+        constexpr auto find_next(Usize const position) const noexcept -> Option<Usize> {
+            return dtl::find_set_bit(m_words.data(), word_count, position + 1);
+        }
+
+        constexpr auto operator&=(BitArray const& other) noexcept -> BitArray& {
+            return apply<dtl::BitOperation::bit_and>(other);
+        }
+        constexpr auto operator|=(BitArray const& other) noexcept -> BitArray& {
+            return apply<dtl::BitOperation::bit_or>(other);
+        }
+        constexpr auto operator^=(BitArray const& other) noexcept -> BitArray& {
+            return apply<dtl::BitOperation::bit_xor>(other);
+        }
+        constexpr auto and_not(BitArray const& other) noexcept -> BitArray& {
+            return apply<dtl::BitOperation::bit_and_not>(other);
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(BitArray const& other) const noexcept -> bool {
+            return std::equal(m_words.begin(), m_words.end(), other.m_words.begin());
+        }
+    private:
+        [[nodiscard]]
+        static constexpr auto bit_of(Usize const index) noexcept -> std::uint64_t {
+            return std::uint64_t { 1 } << (index % dtl::bits_per_word);
+        }
+
+        static constexpr auto check_index(Usize const index) -> void {
+            if (index >= n)
+                throw OutOfRange {};
+        }
+
+        template <dtl::BitOperation operation>
+        constexpr auto apply(BitArray const& other) noexcept -> BitArray& {
+            dtl::apply_bitwise<operation>(m_words.data(), other.m_words.data(), word_count);
+            return *this;
+        }
+    };
+
+
+    /* Description:
+     *     A succinct rank and select index over the words of a bit
+     *     vector, such as `bu::BitVector::words()`. It stores the number
+     *     of set bits before every block of 512 bits, an overhead of one
+     *     eighth. `rank` then reads one count and at most eight words,
+     *     and `select` binary searches the counts before scanning a
+     *     single block.
+     *
+     *     The index refers to the words it was built from, and is
+     *     invalidated by any modification of them.
+     */
+    class [[nodiscard]] RankSelect {
+        static constexpr Usize words_per_block = 8;
+
+        Span<std::uint64_t const> m_words;
+        Vector<Usize>             m_block_ranks; // Set bits before each block, then the total
+    public:
+        explicit RankSelect(Span<std::uint64_t const> const words)
+            : m_words { words }
+        {
+            Usize const block_count = (words.size() + words_per_block - 1) / words_per_block;
+            m_block_ranks.reserve(block_count + 1);
+            Usize rank = 0;
+            for (Usize block = 0; block != block_count; ++block) {
+                m_block_ranks.append(rank);
+                Usize const first = block * words_per_block;
+                Usize const last  = std::min(first + words_per_block, words.size());
+                rank += dtl::count_bits(words.data() + first, last - first);
+            }
+            m_block_ranks.append(rank);
+        }
+
+        // The total number of set bits
+        [[nodiscard]]
+        auto count() const noexcept -> Usize {
+            return m_block_ranks.back();
+        }
+
+        // The number of set bits before `position`.
+        // Precondition: `position` is at most the number of bits
+        [[nodiscard]]
+        auto rank(Usize const position) const noexcept -> Usize {
+            Usize const word  = position / dtl::bits_per_word;
+            Usize const block = word / words_per_block;
+            assert(word <= m_words.size());
+
+            Usize rank = m_block_ranks.data()[block];
+            Usize const first = block * words_per_block;
+            rank += dtl::count_bits(m_words.data() + first, word - first);
+            if (position % dtl::bits_per_word != 0) {
+                std::uint64_t const below = m_words.data()[word] & dtl::last_word_mask(position);
+                rank += static_cast<Usize>(std::popcount(below));
+            }
+            return rank;
+        }
+
+        // The position of the set bit which has `rank` set bits before it, if there are
+        // more than `rank` set bits
+        [[nodiscard]]
+        auto select(Usize rank) const noexcept -> Option<Usize> {
+            if (rank >= count())
+                return nullopt;
+
+            // The last block which starts with at most `rank` set bits before it
+            Usize const* const ranks = m_block_ranks.data();
+            Usize const block = static_cast<Usize>(
+                std::upper_bound(ranks, ranks + m_block_ranks.size() - 1, rank) - ranks) - 1;
+            rank -= ranks[block];
+
+            for (Usize word = block * words_per_block;; ++word) {
+                std::uint64_t const value = m_words.data()[word];
+                auto const          bits  = static_cast<Usize>(std::popcount(value));
+                if (rank < bits)
+                    return word * dtl::bits_per_word + dtl::select_in_word(value, rank);
+                rank -= bits;
+            }
+        }
+    };
+}
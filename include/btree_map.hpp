@@ -0,0 +1,818 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+#include "utility.hpp"
+#include "allocator.hpp"
+#include "memory.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "flat_map.hpp"
+
+
+namespace bu::dtl {
+    /* Description:
+     *     The number of elements of the sorted array `[keys, keys + count)`
+     *     which are less than `key`, or not greater than `key` if
+     *     `or_equal`. Within a node this is exactly the position to
+     *     descend to, and counting every key is cheaper than searching:
+     *     SSE2 compares four 32-bit keys at once, and SSE4.2 two 64-bit
+     *     keys, without any data-dependent branch.
+     */
+#ifdef __SSE2__
+    // The number of 32-bit lanes in which `a` is greater than `b`
+    [[nodiscard]]
+    inline auto count_greater_epi32(__m128i const a, __m128i const b) noexcept -> Usize {
+        int const mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a, b)));
+        return static_cast<Usize>(std::popcount(static_cast<unsigned>(mask)));
+    }
+#endif
+#ifdef __SSE4_2__
+    // The number of 64-bit lanes in which `a` is greater than `b`
+    [[nodiscard]]
+    inline auto count_greater_epi64(__m128i const a, __m128i const b) noexcept -> Usize {
+        int const mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(a, b)));
+        return static_cast<Usize>(std::popcount(static_cast<unsigned>(mask)));
+    }
+#endif
+
+    template <bool or_equal, std::integral K>
+    [[nodiscard]]
+    auto count_below(K const* const keys, Usize const count, K const key) noexcept -> Usize {
+        Usize i = 0, below = 0;
+#ifdef __SSE2__
+        if constexpr (sizeof(K) == 4) {
+            // The comparison is signed, so flip the sign bit of unsigned keys
+            __m128i const flip   = _mm_set1_epi32(std::is_signed_v<K> ? 0 : minimum<std::int32_t>);
+            __m128i const needle = _mm_xor_si128(_mm_set1_epi32(static_cast<std::int32_t>(key)),
+                                                 flip);
+            for (; i + 4 <= count; i += 4) {
+                auto    const lanes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i));
+                __m128i const chunk = _mm_xor_si128(lanes, flip);
+                if constexpr (or_equal)
+                    below += 4 - count_greater_epi32(chunk, needle);
+                else
+                    below += count_greater_epi32(needle, chunk);
+            }
+        }
+#endif
+#ifdef __SSE4_2__
+        if constexpr (sizeof(K) == 8) {
+            __m128i const flip   = _mm_set1_epi64x(std::is_signed_v<K> ? 0 : minimum<std::int64_t>);
+            __m128i const needle = _mm_xor_si128(_mm_set1_epi64x(static_cast<std::int64_t>(key)),
+                                                 flip);
+            for (; i + 2 <= count; i += 2) {
+                auto    const lanes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i));
+                __m128i const chunk = _mm_xor_si128(lanes, flip);
+                if constexpr (or_equal)
+                    below += 2 - count_greater_epi64(chunk, needle);
+                else
+                    below += count_greater_epi64(needle, chunk);
+            }
+        }
+#endif
+        for (; i != count; ++i) {
+            if constexpr (or_equal)
+                below += !(key < keys[i]);
+            else
+                below += keys[i] < key;
+        }
+        return below;
+    }
+
+    // Inserts `value` at `position` of the first `count` elements of `array`, which has room
+    // for one more
+    template <class T, class U>
+    auto shift_insert(T* const array, Usize const count, Usize const position, U&& value)
+        noexcept -> void
+    {
+        if (position == count) {
+            std::construct_at(array + count, std::forward<U>(value));
+            return;
+        }
+        std::construct_at(array + count, std::move(array[count - 1]));
+        std::move_backward(array + position, array + count - 1, array + count);
+        array[position] = std::forward<U>(value);
+    }
+
+    // Removes the element at `position` of the first `count` elements of `array`
+    template <class T>
+    auto shift_erase(T* const array, Usize const count, Usize const position) noexcept -> void {
+        std::move(array + position + 1, array + count, array + position);
+        destroy(array[count - 1]);
+    }
+
+    struct BTreeNode {
+        Usize count = 0; // The number of keys
+    };
+
+    template <class K, class V, Usize capacity>
+    struct BTreeLeaf : BTreeNode {
+        BTreeLeaf* next = nullptr;
+        BTreeLeaf* prev = nullptr;
+        union { K keys[capacity]; };
+        union { V values[capacity]; };
+
+        BTreeLeaf() noexcept {}
+
+        ~BTreeLeaf() {
+            destroy(keys, keys + count);
+            destroy(values, values + count);
+        }
+
+        auto insert(Usize const position, K&& key, V&& value) noexcept -> void {
+            shift_insert(keys, count, position, std::move(key));
+            shift_insert(values, count, position, std::move(value));
+            ++count;
+        }
+
+        auto erase(Usize const position) noexcept -> void {
+            shift_erase(keys, count, position);
+            shift_erase(values, count, position);
+            --count;
+        }
+
+        // Moves the entries from `mid` onward into the empty `sibling`
+        auto split_into(BTreeLeaf& sibling, Usize const mid) noexcept -> void {
+            for (Usize i = mid; i != count; ++i) {
+                std::construct_at(sibling.keys + (i - mid), std::move(keys[i]));
+                std::construct_at(sibling.values + (i - mid), std::move(values[i]));
+            }
+            sibling.count = count - mid;
+            destroy(keys + mid, keys + count);
+            destroy(values + mid, values + count);
+            count = mid;
+        }
+    };
+
+    // Routes a key less than `keys[i]` to `children[i]`, so `keys[i]` is a lower bound of
+    // `children[i + 1]`
+    template <class K, Usize capacity>
+    struct BTreeInternal : BTreeNode {
+        union { K keys[capacity]; };
+        BTreeNode* children[capacity + 1];
+
+        BTreeInternal() noexcept {}
+
+        ~BTreeInternal() {
+            destroy(keys, keys + count);
+        }
+
+        // Inserts `key` at `position`, and `child` to its right
+        auto insert(Usize const position, K&& key, BTreeNode* const child) noexcept -> void {
+            shift_insert(keys, count, position, std::move(key));
+            shift_insert(children, count + 1, position + 1, child);
+            ++count;
+        }
+
+        // Removes the child at `position` along with one of the keys next to it
+        auto remove_child(Usize const position) noexcept -> void {
+            shift_erase(keys, count, position == 0 ? 0 : position - 1);
+            shift_erase(children, count + 1, position);
+            --count;
+        }
+
+        // Moves the keys after `mid` and the children to their right into the empty `sibling`, and
+        // returns the key at `mid`
+        auto split_into(BTreeInternal& sibling, Usize const mid) noexcept -> K {
+            K promoted = std::move(keys[mid]);
+            for (Usize i = mid + 1; i != count; ++i) {
+                std::construct_at(sibling.keys + (i - mid - 1), std::move(keys[i]));
+                sibling.children[i - mid - 1] = children[i];
+            }
+            sibling.children[count - mid - 1] = children[count];
+            sibling.count = count - mid - 1;
+            destroy(keys + mid, keys + count);
+            count = mid;
+            return promoted;
+        }
+    };
+}
+
+
+namespace bu {
+    // An entry of a `bu::BTreeMap`, as seen through an iterator
+    template <class K, class V>
+    struct BTreeEntry {
+        K const& key;
+        V&       value;
+    };
+
+    namespace dtl {
+        template <class K, class V, Usize capacity, bool is_const>
+        class BTreeIterator {
+            using Leaf = BTreeLeaf<K, V, capacity>;
+
+            Leaf* m_leaf  = nullptr;
+            Usize m_index = 0;
+        public:
+            using value_type      = BTreeEntry<K, std::conditional_t<is_const, V const, V>>;
+            using difference_type = Isize;
+
+            BTreeIterator() = default;
+
+            // Precondition: `index` is less than the number of entries of `leaf`, or `leaf` is null
+            constexpr explicit BTreeIterator(Leaf* const leaf, Usize const index) noexcept
+                : m_leaf  { leaf }
+                , m_index { index } {}
+
+            [[nodiscard]]
+            constexpr auto operator*() const noexcept -> value_type {
+                return value_type { m_leaf->keys[m_index], m_leaf->values[m_index] };
+            }
+
+            constexpr auto operator++() noexcept -> BTreeIterator& {
+                if (++m_index == m_leaf->count) {
+                    m_leaf  = m_leaf->next;
+                    m_index = 0;
+                }
+                return *this;
+            }
+            constexpr auto operator++(int) noexcept -> BTreeIterator {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            [[nodiscard]]
+            constexpr auto operator==(BTreeIterator const&) const noexcept -> bool = default;
+
+            // Enable conversion of non-const to const iterators
+            [[nodiscard]]
+            constexpr operator BTreeIterator<K, V, capacity, true>() const
+                noexcept requires (!is_const)
+            {
+                return BTreeIterator<K, V, capacity, true> { m_leaf, m_index };
+            }
+        };
+    } // namespace dtl
+
+    // The entries of a `bu::BTreeMap` within a key range, in ascending order
+    template <class It>
+    class [[nodiscard]] BTreeRange {
+        It m_begin;
+        It m_end;
+    public:
+        constexpr explicit BTreeRange(It const begin, It const end) noexcept
+            : m_begin { begin }
+            , m_end   { end } {}
+
+        [[nodiscard]] constexpr auto begin() const noexcept -> It { return m_begin; }
+        [[nodiscard]] constexpr auto end()   const noexcept -> It { return m_end; }
+    };
+
+
+    /* Description:
+     *     An ordered map implemented as a B+ tree. Every node holds its
+     *     keys in one contiguous array of about four cache lines, so a
+     *     lookup touches a handful of nodes instead of chasing a pointer
+     *     per comparison as `std::map` does. Integral keys are searched
+     *     within a node by counting with SIMD comparisons, and all other
+     *     keys by a branchless binary search.
+     *
+     *     The entries are stored in the leaves, which are linked in key
+     *     order, so iterating over a range of keys is a sequential scan.
+     *     Nodes are allocated one at a time through `A<Leaf>` and
+     *     `A<Internal>`, so they may come from a pool or an arena.
+     *
+     *     Erasure frees a node once it becomes empty, rather than
+     *     merging underfull nodes with their siblings. This keeps
+     *     erasure cheap, and under mixed insertions and erasures the
+     *     occupancy of the nodes remains high in practice.
+     */
+    template <class K, class V, template <class> class A = DefaultAllocator>
+        requires std::totally_ordered<K>
+              && std::copyable<K>
+              && nothrow_movable<K>
+              && nothrow_movable<V>
+    class [[nodiscard]] BTreeMap {
+    public:
+        // The maximum number of keys of a node
+        static constexpr Usize node_capacity = std::clamp<Usize>(256 / sizeof(K), 8, 64);
+    private:
+        using Node     = dtl::BTreeNode;
+        using Leaf     = dtl::BTreeLeaf<K, V, node_capacity>;
+        using Internal = dtl::BTreeInternal<K, node_capacity>;
+
+        static_assert(allocator_for<A<Leaf>, Leaf> && allocator_for<A<Internal>, Internal>);
+
+        // Every split at least doubles the number of leaves below the new root
+        static constexpr Usize max_height = 64;
+
+        struct PathEntry {
+            Internal* node;
+            Usize     child;
+        };
+
+        [[no_unique_address]]
+        A<Leaf>     m_leaf_allocator;
+        [[no_unique_address]]
+        A<Internal> m_internal_allocator;
+        Node*       m_root   = nullptr;
+        Leaf*       m_first  = nullptr; // The leftmost leaf
+        Usize       m_height = 0;       // The number of internal levels
+        Usize       m_size   = 0;
+    public:
+        using KeyType       = K;
+        using ValueType     = V;
+        using SizeType      = Usize;
+        using Iterator      = dtl::BTreeIterator<K, V, node_capacity, false>;
+        using Sentinel      = Iterator;
+        using ConstIterator = dtl::BTreeIterator<K, V, node_capacity, true>;
+        using ConstSentinel = ConstIterator;
+
+        BTreeMap() = default;
+
+        BTreeMap(BTreeMap const& other) requires std::copyable<V>
+            : m_leaf_allocator     { other.m_leaf_allocator }
+            , m_internal_allocator { other.m_internal_allocator }
+        {
+            Vector<K> keys;
+            Vector<V> values;
+            keys.reserve(other.m_size);
+            values.reserve(other.m_size);
+            for (auto const [key, value] : other) {
+                keys.append(key);
+                values.append(value);
+            }
+            load_sorted(keys, values);
+        }
+
+        BTreeMap(BTreeMap&& other) noexcept
+            : m_leaf_allocator     { std::move(other.m_leaf_allocator) }
+            , m_internal_allocator { std::move(other.m_internal_allocator) }
+            , m_root   { BU exchange(other.m_root, nullptr) }
+            , m_first  { BU exchange(other.m_first, nullptr) }
+            , m_height { BU exchange(other.m_height, 0) }
+            , m_size   { BU exchange(other.m_size, 0) } {}
+
+        auto operator=(BTreeMap const& other) -> BTreeMap& requires std::copyable<V> {
+            if (this != &other) {
+                BTreeMap copy = other;
+                swap(copy);
+            }
+            return *this;
+        }
+
+        auto operator=(BTreeMap&& other) noexcept -> BTreeMap& {
+            if (this != &other) {
+                this->~BTreeMap();
+                std::construct_at(this, std::move(other));
+            }
+            return *this;
+        }
+
+        ~BTreeMap() {
+            clear();
+        }
+
+        /* Description:
+         *     Builds a map from parallel arrays of keys and values, with
+         *     the keys in strictly ascending order, in linear time. The
+         *     leaves are filled to capacity, which minimizes the height
+         *     of the tree and makes range scans as dense as possible.
+         *
+         * Preconditions:
+         *     `keys.size() == values.size()`, and the keys are strictly ascending.
+         */
+        [[nodiscard]]
+        static auto from_sorted(Vector<K> keys, Vector<V> values) -> BTreeMap {
+            assert(keys.size() == values.size());
+            assert(std::adjacent_find(keys.begin(), keys.end(), [](K const& a, K const& b) {
+                return !(a < b);
+            }) == keys.end());
+            BTreeMap map;
+            map.load_sorted(keys, values);
+            return map;
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_size;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_size == 0;
+        }
+
+        auto clear() noexcept -> void {
+            if (m_root)
+                free_subtree(m_root, m_height);
+            m_root   = nullptr;
+            m_first  = nullptr;
+            m_height = 0;
+            m_size   = 0;
+        }
+
+        [[nodiscard]]
+        auto find(K const& key) const noexcept -> Option<V const&> {
+            if (Option<Location> const location = locate(key))
+                return location.value().leaf->values[location.value().index];
+            else
+                return nullopt;
+        }
+        [[nodiscard]]
+        auto find(K const& key) noexcept -> Option<V&> {
+            if (Option<Location> const location = locate(key))
+                return location.value().leaf->values[location.value().index];
+            else
+                return nullopt;
+        }
+
+        [[nodiscard]]
+        auto contains(K const& key) const noexcept -> bool {
+            return locate(key).has_value();
+        }
+
+        /* Description:
+         *     Associates `value` with `key`. If the leaf of `key` is full
+         *     it is split in half, and the split propagates upward
+         *     through any full ancestors.
+         *
+         * Return value:
+         *     The value previously associated with `key`, if any.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - K::K(K const&)
+         *     - A<Leaf>::allocate(bu::Usize)
+         *     - A<Internal>::allocate(bu::Usize)
+         *     The map is unchanged if an exception is thrown.
+         */
+        auto insert(K key, V value) -> Option<V> {
+            if (!m_root)
+                m_root = m_first = new_leaf();
+
+            PathEntry path[max_height];
+            Leaf* const leaf     = descend(key, path);
+            Usize const position = lower_bound_in(*leaf, key);
+
+            if (position != leaf->count && !(key < leaf->keys[position]))
+                return BU exchange(leaf->values[position], std::move(value));
+
+            if (leaf->count == node_capacity)
+                split_and_insert(*leaf, position, path, std::move(key), std::move(value));
+            else
+                leaf->insert(position, std::move(key), std::move(value));
+            ++m_size;
+            return nullopt;
+        }
+
+        /* Description:
+         *     Removes the entry of `key`, if any. A node which becomes
+         *     empty is freed and removed from its parent, and the root is
+         *     replaced by its only child while it has just one.
+         *
+         * Return value:
+         *     The removed value, if any.
+         */
+        auto erase(K const& key) noexcept -> Option<V> {
+            if (!m_root)
+                return nullopt;
+
+            PathEntry path[max_height];
+            Leaf* const leaf     = descend(key, path);
+            Usize const position = lower_bound_in(*leaf, key);
+
+            if (position == leaf->count || key < leaf->keys[position])
+                return nullopt;
+
+            Option<V> removed { in_place, std::move(leaf->values[position]) };
+            leaf->erase(position);
+            --m_size;
+            if (leaf->count == 0)
+                remove_empty_leaf(*leaf, path);
+            return removed;
+        }
+
+        // Iterator to the first entry whose key is not less than `key`
+        [[nodiscard]]
+        auto lower_bound(K const& key) const noexcept -> ConstIterator {
+            auto const [leaf, index] = lower_bound_location(key);
+            return ConstIterator { leaf, index };
+        }
+        [[nodiscard]]
+        auto lower_bound(K const& key) noexcept -> Iterator {
+            auto const [leaf, index] = lower_bound_location(key);
+            return Iterator { leaf, index };
+        }
+
+        // The entries whose keys are in `[first, last)`
+        [[nodiscard]]
+        auto range(K const& first, K const& last) const noexcept -> BTreeRange<ConstIterator> {
+            ConstIterator const begin = lower_bound(first);
+            return BTreeRange<ConstIterator> { begin, first < last ? lower_bound(last) : begin };
+        }
+        [[nodiscard]]
+        auto range(K const& first, K const& last) noexcept -> BTreeRange<Iterator> {
+            Iterator const begin = lower_bound(first);
+            return BTreeRange<Iterator> { begin, first < last ? lower_bound(last) : begin };
+        }
+
+        [[nodiscard]]
+        auto begin() const noexcept -> ConstIterator {
+            return ConstIterator { m_first, 0 };
+        }
+        [[nodiscard]]
+        auto begin() noexcept -> Iterator {
+            return Iterator { m_first, 0 };
+        }
+
+        [[nodiscard]] auto end() const noexcept -> ConstSentinel { return ConstSentinel {}; }
+        [[nodiscard]] auto end()       noexcept -> Sentinel      { return Sentinel {}; }
+
+        auto swap(BTreeMap& other) noexcept -> void {
+            if constexpr (AllocatorTraits<A<Leaf>>::propagate_on_swap) {
+                BU swap(m_leaf_allocator, other.m_leaf_allocator);
+                BU swap(m_internal_allocator, other.m_internal_allocator);
+            }
+            BU swap(m_root, other.m_root);
+            BU swap(m_first, other.m_first);
+            BU swap(m_height, other.m_height);
+            BU swap(m_size, other.m_size);
+        }
+    private:
+        struct Location {
+            Leaf* leaf;
+            Usize index;
+        };
+
+        // The position of the first key of `node` which is not less than `key`
+        template <class Keyed>
+        [[nodiscard]]
+        static auto lower_bound_in(Keyed const& node, K const& key) noexcept -> Usize {
+            if constexpr (std::integral<K>)
+                return dtl::count_below<false>(node.keys, node.count, key);
+            else
+                return dtl::branchless_lower_bound(node.keys, node.count, key, std::less<> {});
+        }
+
+        // The position of the child of `node` whose subtree may contain `key`
+        [[nodiscard]]
+        static auto child_index(Internal const& node, K const& key) noexcept -> Usize {
+            if constexpr (std::integral<K>)
+                return dtl::count_below<true>(node.keys, node.count, key);
+            else
+                return dtl::branchless_lower_bound(
+                    node.keys, node.count, key, [](K const& a, K const& b) { return !(b < a); });
+        }
+
+        // The leaf whose range contains `key`, recording the route in `path` if it is not null
+        [[nodiscard]]
+        auto descend(K const& key, PathEntry* const path = nullptr) const noexcept -> Leaf* {
+            Node* node = m_root;
+            for (Usize level = 0; level != m_height; ++level) {
+                Internal* const internal = static_cast<Internal*>(node);
+                Usize     const child    = child_index(*internal, key);
+                if (path)
+                    path[level] = PathEntry { internal, child };
+                node = internal->children[child];
+            }
+            return static_cast<Leaf*>(node);
+        }
+
+        [[nodiscard]]
+        auto locate(K const& key) const noexcept -> Option<Location> {
+            if (!m_root)
+                return nullopt;
+            Leaf* const leaf     = descend(key);
+            Usize const position = lower_bound_in(*leaf, key);
+            if (position != leaf->count && !(key < leaf->keys[position]))
+                return Location { leaf, position };
+            else
+                return nullopt;
+        }
+
+        [[nodiscard]]
+        auto lower_bound_location(K const& key) const noexcept -> Location {
+            if (!m_root)
+                return Location { nullptr, 0 };
+            Leaf* const leaf     = descend(key);
+            Usize const position = lower_bound_in(*leaf, key);
+            // Every key of the next leaf is at least the separator above `key`
+            if (position == leaf->count)
+                return Location { leaf->next, 0 };
+            else
+                return Location { leaf, position };
+        }
+
+        auto split_and_insert(
+            Leaf&                  leaf,
+            Usize const            position,
+            PathEntry const* const path,
+            K&&                    key,
+            V&&                    value) -> void
+        {
+            // The ancestors which split along with the leaf are the consecutive full ones above it
+            Usize full = 0;
+            while (full != m_height && path[m_height - 1 - full].node->count == node_capacity) {
+                ++full;
+            }
+            bool const grows = full == m_height;
+
+            // Everything that may throw happens before the tree is modified
+            Usize const mid       = node_capacity / 2;
+            K           separator = leaf.keys[mid];
+            Leaf* const sibling   = new_leaf();
+            Internal*   internal_siblings[max_height + 1];
+            Usize       allocated = 0;
+            try {
+                for (; allocated != full + grows; ++allocated) {
+                    internal_siblings[allocated] = new_internal();
+                }
+            }
+            catch (...) {
+                for (Usize i = 0; i != allocated; ++i) {
+                    free_internal(internal_siblings[i]);
+                }
+                free_leaf(sibling);
+                throw;
+            }
+
+            leaf.split_into(*sibling, mid);
+            if (position <= mid)
+                leaf.insert(position, std::move(key), std::move(value));
+            else
+                sibling->insert(position - mid, std::move(key), std::move(value));
+
+            sibling->next = leaf.next;
+            sibling->prev = &leaf;
+            if (leaf.next)
+                leaf.next->prev = sibling;
+            leaf.next = sibling;
+
+            // Insert the separator and the new node into the parent, splitting full parents in turn
+            Node* new_node = sibling;
+            Usize level    = m_height;
+            for (Usize i = 0; i != full; ++i) {
+                auto const [parent, child] = path[--level];
+                Internal* const parent_sibling = internal_siblings[i];
+                K promoted = parent->split_into(*parent_sibling, mid);
+                if (child <= mid)
+                    parent->insert(child, std::move(separator), new_node);
+                else
+                    parent_sibling->insert(child - mid - 1, std::move(separator), new_node);
+                separator = std::move(promoted);
+                new_node  = parent_sibling;
+            }
+
+            if (grows) {
+                Internal* const root = internal_siblings[full];
+                std::construct_at(root->keys, std::move(separator));
+                root->children[0] = m_root;
+                root->children[1] = new_node;
+                root->count       = 1;
+                m_root            = root;
+                ++m_height;
+            }
+            else {
+                auto const [parent, child] = path[level - 1];
+                parent->insert(child, std::move(separator), new_node);
+            }
+        }
+
+        auto remove_empty_leaf(Leaf& leaf, PathEntry const* const path) noexcept -> void {
+            if (leaf.prev)
+                leaf.prev->next = leaf.next;
+            else
+                m_first = leaf.next;
+            if (leaf.next)
+                leaf.next->prev = leaf.prev;
+            free_leaf(&leaf);
+
+            // Remove the leaf from its parent, along with every ancestor left without children
+            Usize level = m_height;
+            for (; level != 0; --level) {
+                auto const [parent, child] = path[level - 1];
+                if (parent->count != 0) {
+                    parent->remove_child(child);
+                    break;
+                }
+                free_internal(parent);
+            }
+            if (level == 0) {
+                m_root   = nullptr;
+                m_height = 0;
+                return;
+            }
+
+            while (m_height != 0 && static_cast<Internal*>(m_root)->count == 0) {
+                Internal* const root = static_cast<Internal*>(m_root);
+                m_root = root->children[0];
+                free_internal(root);
+                --m_height;
+            }
+        }
+
+        // Precondition: the map is empty
+        auto load_sorted(Vector<K>& keys, Vector<V>& values) -> void {
+            Usize const n = keys.size();
+            if (n == 0)
+                return;
+
+            Usize const leaf_count = (n + node_capacity - 1) / node_capacity;
+            Vector<Node*>     level;
+            Vector<K>         lows; // The smallest key of each subtree of `level`
+            Vector<Internal*> internals;
+            level.reserve(leaf_count);
+            lows.reserve(leaf_count);
+            internals.reserve(leaf_count);
+
+            try {
+                Leaf* previous = nullptr;
+                for (Usize first = 0; first < n; first += node_capacity) {
+                    Leaf* const leaf = new_leaf();
+                    leaf->prev = previous;
+                    (previous ? previous->next : m_first) = leaf;
+                    previous = leaf;
+
+                    Usize const last = std::min(first + node_capacity, n);
+                    for (Usize i = first; i != last; ++i) {
+                        std::construct_at(leaf->keys + leaf->count, std::move(keys.data()[i]));
+                        std::construct_at(leaf->values + leaf->count, std::move(values.data()[i]));
+                        ++leaf->count;
+                    }
+                    level.append(leaf);
+                    lows.append(leaf->keys[0]);
+                }
+
+                Usize height = 0;
+                while (level.size() > 1) {
+                    Usize parents = 0;
+                    for (Usize first = 0; first < level.size(); first += node_capacity + 1) {
+                        Internal* const node = internals.append(new_internal());
+                        Usize     const last = std::min(first + node_capacity + 1, level.size());
+                        node->children[0] = level.data()[first];
+                        for (Usize i = first + 1; i != last; ++i) {
+                            std::construct_at(node->keys + node->count, std::move(lows.data()[i]));
+                            node->children[++node->count] = level.data()[i];
+                        }
+                        level.data()[parents] = node;
+                        if (parents != first)
+                            lows.data()[parents] = std::move(lows.data()[first]);
+                        ++parents;
+                    }
+                    while (level.size() != parents) {
+                        level.pop_back();
+                        lows.pop_back();
+                    }
+                    ++height;
+                }
+
+                m_root   = level.front();
+                m_height = height;
+                m_size   = n;
+            }
+            catch (...) {
+                for (Leaf* leaf = m_first; leaf;) {
+                    Leaf* const next = leaf->next;
+                    free_leaf(leaf);
+                    leaf = next;
+                }
+                for (Internal* const node : internals) {
+                    free_internal(node);
+                }
+                m_first = nullptr;
+                throw;
+            }
+        }
+
+        auto free_subtree(Node* const node, Usize const height) noexcept -> void {
+            if (height == 0) {
+                free_leaf(static_cast<Leaf*>(node));
+                return;
+            }
+            Internal* const internal = static_cast<Internal*>(node);
+            for (Usize i = 0; i != internal->count + 1; ++i) {
+                free_subtree(internal->children[i], height - 1);
+            }
+            free_internal(internal);
+        }
+
+        [[nodiscard]]
+        auto new_leaf() -> Leaf* {
+            return std::construct_at(m_leaf_allocator.allocate(1));
+        }
+        [[nodiscard]]
+        auto new_internal() -> Internal* {
+            return std::construct_at(m_internal_allocator.allocate(1));
+        }
+
+        auto free_leaf(Leaf* const leaf) noexcept -> void {
+            destroy(*leaf);
+            m_leaf_allocator.deallocate(leaf, 1);
+        }
+        auto free_internal(Internal* const node) noexcept -> void {
+            destroy(*node);
+            m_internal_allocator.deallocate(node, 1);
+        }
+    };
+}
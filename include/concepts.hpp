@@ -23,6 +23,11 @@ namespace bu {
     concept bidirectional_iterator =
         iterator<It> && decrementable<It>;
 
+    // Iterators to elements stored adjacently in memory, accessible through `std::to_address`
+    template <class It>
+    concept contiguous_iterator =
+        iterator<It> && (std::is_pointer_v<It> || std::contiguous_iterator<It>);
+
     template <class Se, class It>
     concept sentinel_for = requires (It it, Se se) {
         { it != se } -> std::convertible_to<bool>;
@@ -65,4 +70,21 @@ namespace bu {
         { cc.size()     } -> std::same_as<typename C::SizeType>;
         { cc.is_empty() } -> std::same_as<bool>;
     };
+
+    // A container whose elements are stored in one array, exposed through `data()`
+    template <class C>
+    concept contiguous_container = container<C>
+        && contiguous_iterator<typename C::Iterator>
+        && requires (C c, C const cc) {
+            { c.data()  } -> std::same_as<typename C::ContainedType*>;
+            { cc.data() } -> std::same_as<typename C::ContainedType const*>;
+        };
+
+    // Any `data()` and `size()` view, such as `bu::Span`, of elements which may be copied as bytes
+    template <class R>
+    concept trivially_copyable_range = requires (R& r) {
+        { r.data() } -> std::convertible_to<void const*>;
+        { r.size() } -> std::convertible_to<Usize>;
+        requires std::is_trivially_copyable_v<std::remove_pointer_t<decltype(r.data())>>;
+    };
 }
@@ -0,0 +1,746 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <thread>
+
+#include "utility.hpp"
+#include "allocator.hpp"
+#include "exception.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+
+
+namespace bu {
+    // The unit in which coroutine frames are allocated, aligned suitably for any frame
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) CoroutineFrameBlock {
+        std::byte bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+    };
+
+    /* Description:
+     *     An allocator from which coroutine frames can be allocated. A
+     *     coroutine returning `bu::Task` or `bu::Generator` allocates its
+     *     frame from such an allocator if its parameter list starts with
+     *     `bu::allocator_arg, allocator`, or, for member coroutines,
+     *     if it does so after the implicit object parameter. A copy of
+     *     the allocator is stored alongside the frame and used to free it.
+     */
+    template <class A>
+    concept frame_allocator = allocator_for<A, CoroutineFrameBlock>
+                           && std::is_nothrow_copy_constructible_v<A>
+                           && (alignof(A) <= alignof(CoroutineFrameBlock));
+
+    using EventLoopStalled =
+        StatelessException<"event loop ran out of work before the task completed">;
+
+    template <class T = void>
+    class Task;
+
+    template <class T>
+        requires std::same_as<T, std::remove_cvref_t<T>>
+    class Generator;
+
+    class EventLoop;
+}
+
+
+namespace bu::dtl {
+    [[nodiscard]]
+    constexpr auto frame_block_count(Usize const bytes) noexcept -> Usize {
+        return (bytes + sizeof(CoroutineFrameBlock) - 1) / sizeof(CoroutineFrameBlock);
+    }
+
+    // Stored in the blocks following a frame, so that the frame can be freed without
+    // knowing the type of its allocator
+    template <class A>
+    struct FrameFooter {
+        void (*deallocate)(void* frame, Usize size) noexcept;
+        [[no_unique_address]]
+        A      allocator;
+    };
+
+    struct FrameDeallocator {
+        void (*deallocate)(void* frame, Usize size) noexcept;
+    };
+
+    template <class A>
+    [[nodiscard]]
+    auto frame_footer(void* const frame, Usize const size) noexcept -> FrameFooter<A>* {
+        return reinterpret_cast<FrameFooter<A>*>(
+            static_cast<CoroutineFrameBlock*>(frame) + frame_block_count(size));
+    }
+
+    template <class A>
+    [[nodiscard]]
+    constexpr auto frame_allocation_size(Usize const size) noexcept -> Usize {
+        return frame_block_count(size) + frame_block_count(sizeof(FrameFooter<A>));
+    }
+
+    template <frame_allocator A>
+    auto deallocate_frame(void* const frame, Usize const size) noexcept -> void {
+        FrameFooter<A>* const footer = frame_footer<A>(frame, size);
+        A allocator = footer->allocator;
+        std::destroy_at(footer);
+        auto* const blocks = static_cast<CoroutineFrameBlock*>(frame);
+        allocator.deallocate(blocks, frame_allocation_size<A>(size));
+    }
+
+    template <frame_allocator A>
+    [[nodiscard]]
+    auto allocate_frame(A const& allocator, Usize const size) -> void* {
+        A copy = allocator;
+        CoroutineFrameBlock* const frame = copy.allocate(frame_allocation_size<A>(size));
+        FrameFooter<A> footer { &deallocate_frame<A>, copy };
+        std::construct_at(frame_footer<A>(frame, size), std::move(footer));
+        return frame;
+    }
+
+    // Provides the frame allocation functions of the promise types
+    struct FramePromise {
+        static auto operator new(Usize const size) -> void* {
+            return allocate_frame(DefaultAllocator<CoroutineFrameBlock> {}, size);
+        }
+
+        template <frame_allocator A, class... Args>
+        static auto operator new(
+            Usize const size, AllocatorArg, A const& allocator, Args const&...) -> void*
+        {
+            return allocate_frame(allocator, size);
+        }
+
+        // Member coroutines receive the object as their first argument
+        template <class This, frame_allocator A, class... Args>
+        static auto operator new(
+            Usize const size, This const&, AllocatorArg, A const& allocator, Args const&...)
+            -> void*
+        {
+            return allocate_frame(allocator, size);
+        }
+
+        static auto operator delete(void* const frame, Usize const size) noexcept -> void {
+            // Every footer starts with the deallocation function
+            void* const footer = frame_footer<Unit>(frame, size);
+            reinterpret_cast<FrameDeallocator*>(footer)->deallocate(frame, size);
+        }
+    };
+
+
+    class TaskPromiseBase : public FramePromise {
+        std::coroutine_handle<> m_continuation;
+    protected:
+        std::exception_ptr      m_exception;
+    public:
+        struct FinalAwaiter {
+            auto await_ready() const noexcept -> bool {
+                return false;
+            }
+            // Symmetric transfer, so that long chains of awaits do not grow the stack
+            template <class Promise>
+            auto await_suspend(std::coroutine_handle<Promise> const coroutine) const noexcept
+                -> std::coroutine_handle<>
+            {
+                std::coroutine_handle<> const continuation = coroutine.promise().m_continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            auto await_resume() const noexcept -> void {}
+        };
+
+        auto initial_suspend() const noexcept -> std::suspend_always {
+            return {};
+        }
+        auto final_suspend() const noexcept -> FinalAwaiter {
+            return {};
+        }
+        auto unhandled_exception() noexcept -> void {
+            m_exception = std::current_exception();
+        }
+        auto set_continuation(std::coroutine_handle<> const continuation) noexcept -> void {
+            m_continuation = continuation;
+        }
+    };
+
+    template <class T>
+    class TaskPromise : public TaskPromiseBase {
+        Option<T> m_value;
+    public:
+        auto get_return_object() noexcept -> Task<T>;
+
+        template <class U = T>
+            requires std::constructible_from<T, U&&>
+        auto return_value(U&& value)
+            noexcept(std::is_nothrow_constructible_v<T, U&&>) -> void
+        {
+            m_value = Option<T> { in_place, std::forward<U>(value) };
+        }
+
+        auto result() -> T {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+            return std::move(m_value.value());
+        }
+    };
+
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase {
+    public:
+        auto get_return_object() noexcept -> Task<void>;
+
+        auto return_void() const noexcept -> void {}
+
+        auto result() const -> void {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+        }
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     A lazily started coroutine producing a `T`. The coroutine does
+     *     not run until the task is awaited or handed to an event loop,
+     *     and resumes its awaiter by symmetric transfer once it completes.
+     *     To report errors without exceptions, `T` can be a `bu::Result`,
+     *     in which case `co_return bu::Ok { x }` and `co_return bu::Err { e }`
+     *     both work.
+     *
+     * Exceptions:
+     *     An exception escaping the coroutine is rethrown to its awaiter.
+     */
+    template <class T>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = dtl::TaskPromise<T>;
+    private:
+        std::coroutine_handle<promise_type> m_coroutine;
+
+        explicit Task(std::coroutine_handle<promise_type> const coroutine) noexcept
+            : m_coroutine { coroutine } {}
+
+        friend promise_type;
+        friend EventLoop;
+
+        struct Awaiter {
+            std::coroutine_handle<promise_type> coroutine;
+
+            auto await_ready() const noexcept -> bool {
+                return coroutine.done();
+            }
+            auto await_suspend(std::coroutine_handle<> const awaiter) const noexcept
+                -> std::coroutine_handle<>
+            {
+                coroutine.promise().set_continuation(awaiter);
+                return coroutine;
+            }
+            auto await_resume() const -> T {
+                return coroutine.promise().result();
+            }
+        };
+    public:
+        using ContainedType = T;
+
+        Task() = default;
+
+        Task(Task&& other) noexcept
+            : m_coroutine { BU exchange(other.m_coroutine, nullptr) } {}
+
+        auto operator=(Task&& other) noexcept -> Task& {
+            if (this != &other) {
+                if (m_coroutine)
+                    m_coroutine.destroy();
+                m_coroutine = BU exchange(other.m_coroutine, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (m_coroutine)
+                m_coroutine.destroy();
+        }
+
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return !m_coroutine;
+        }
+        [[nodiscard]]
+        auto is_done() const noexcept -> bool {
+            return m_coroutine && m_coroutine.done();
+        }
+
+        // Precondition: `!is_empty()`, and the task has not been awaited before
+        auto operator co_await() const noexcept -> Awaiter {
+            assert(m_coroutine);
+            return Awaiter { m_coroutine };
+        }
+    };
+
+    template <class T>
+    auto dtl::TaskPromise<T>::get_return_object() noexcept -> Task<T> {
+        return Task<T> { std::coroutine_handle<TaskPromise>::from_promise(*this) };
+    }
+
+    inline auto dtl::TaskPromise<void>::get_return_object() noexcept -> Task<void> {
+        return Task<void> { std::coroutine_handle<TaskPromise>::from_promise(*this) };
+    }
+}
+
+
+namespace bu::dtl {
+    template <class T>
+    class GeneratorPromise : public FramePromise {
+        T*                 m_current = nullptr;
+        std::exception_ptr m_exception;
+
+        // Keeps a copy of a yielded value alive in the frame until the coroutine is resumed
+        struct CopyAwaiter {
+            T                 copy;
+            GeneratorPromise* promise;
+
+            auto await_ready() const noexcept -> bool {
+                return false;
+            }
+            auto await_suspend(std::coroutine_handle<>) noexcept -> void {
+                promise->m_current = std::addressof(copy);
+            }
+            auto await_resume() const noexcept -> void {}
+        };
+    public:
+        auto get_return_object() noexcept -> Generator<T>;
+
+        auto initial_suspend() const noexcept -> std::suspend_always {
+            return {};
+        }
+        auto final_suspend() const noexcept -> std::suspend_always {
+            return {};
+        }
+
+        // A yielded value is not copied, it lives in the frame until the coroutine is resumed
+        auto yield_value(T& value) noexcept -> std::suspend_always {
+            m_current = std::addressof(value);
+            return {};
+        }
+        auto yield_value(T&& value) noexcept -> std::suspend_always {
+            m_current = std::addressof(value);
+            return {};
+        }
+        auto yield_value(T const& value)
+            noexcept(std::is_nothrow_copy_constructible_v<T>) -> CopyAwaiter
+            requires std::is_copy_constructible_v<T>
+        {
+            return CopyAwaiter { value, this };
+        }
+
+        auto return_void() const noexcept -> void {}
+
+        auto unhandled_exception() noexcept -> void {
+            m_exception = std::current_exception();
+        }
+
+        [[nodiscard]]
+        auto current() const noexcept -> T& {
+            return *m_current;
+        }
+        auto rethrow_if_failed() const -> void {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+        }
+    };
+
+    struct GeneratorSentinel {};
+
+    template <class T>
+    class GeneratorIterator {
+        std::coroutine_handle<GeneratorPromise<T>> m_coroutine;
+    public:
+        using value_type      = T;
+        using difference_type = Isize;
+
+        GeneratorIterator() = default;
+
+        explicit GeneratorIterator(std::coroutine_handle<GeneratorPromise<T>> const coroutine)
+            noexcept : m_coroutine { coroutine } {}
+
+        auto operator++() -> GeneratorIterator& {
+            m_coroutine.resume();
+            m_coroutine.promise().rethrow_if_failed();
+            return *this;
+        }
+        auto operator++(int) -> void {
+            ++*this;
+        }
+
+        [[nodiscard]]
+        auto operator*() const noexcept -> T& {
+            return m_coroutine.promise().current();
+        }
+
+        [[nodiscard]]
+        auto operator==(GeneratorSentinel) const noexcept -> bool {
+            return m_coroutine.done();
+        }
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     A coroutine which lazily produces a sequence of `T` through
+     *     `co_yield`, iterable with range-for like `bu::List`. Yielded
+     *     values are referred to in place rather than copied, so the
+     *     iterator dereferences to the very object passed to `co_yield`.
+     *     The sequence can be traversed only once.
+     *
+     * Exceptions:
+     *     An exception escaping the coroutine is rethrown from `begin`
+     *     or from the increment of the iterator.
+     */
+    template <class T>
+        requires std::same_as<T, std::remove_cvref_t<T>>
+    class [[nodiscard]] Generator {
+    public:
+        using promise_type = dtl::GeneratorPromise<T>;
+    private:
+        std::coroutine_handle<promise_type> m_coroutine;
+
+        explicit Generator(std::coroutine_handle<promise_type> const coroutine) noexcept
+            : m_coroutine { coroutine } {}
+
+        friend promise_type;
+    public:
+        using ContainedType = T;
+        using Iterator      = dtl::GeneratorIterator<T>;
+        using Sentinel      = dtl::GeneratorSentinel;
+
+        Generator() = default;
+
+        Generator(Generator&& other) noexcept
+            : m_coroutine { BU exchange(other.m_coroutine, nullptr) } {}
+
+        auto operator=(Generator&& other) noexcept -> Generator& {
+            if (this != &other) {
+                if (m_coroutine)
+                    m_coroutine.destroy();
+                m_coroutine = BU exchange(other.m_coroutine, nullptr);
+            }
+            return *this;
+        }
+
+        ~Generator() {
+            if (m_coroutine)
+                m_coroutine.destroy();
+        }
+
+        // Runs the coroutine up to its first `co_yield`.
+        // Precondition: `begin` has not been called before
+        [[nodiscard]]
+        auto begin() -> Iterator {
+            assert(m_coroutine);
+            m_coroutine.resume();
+            m_coroutine.promise().rethrow_if_failed();
+            return Iterator { m_coroutine };
+        }
+        [[nodiscard]]
+        auto end() const noexcept -> Sentinel {
+            return Sentinel {};
+        }
+    };
+
+    template <class T>
+    auto dtl::GeneratorPromise<T>::get_return_object() noexcept -> Generator<T> {
+        return Generator<T> { std::coroutine_handle<GeneratorPromise>::from_promise(*this) };
+    }
+}
+
+
+namespace bu::dtl {
+    // Owns a task spawned onto an event loop, its frame destroys itself once the task completes
+    struct DetachedTask {
+        struct promise_type : FramePromise {
+            // Links in the loop's list of spawned tasks which have not completed
+            promise_type*  next     = nullptr;
+            promise_type** previous = nullptr; // The link which points to this promise
+
+            auto get_return_object() noexcept -> DetachedTask {
+                return DetachedTask { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+            auto initial_suspend() const noexcept -> std::suspend_always {
+                return {};
+            }
+            auto final_suspend() noexcept -> std::suspend_never {
+                unlink();
+                return {};
+            }
+            auto return_void() const noexcept -> void {}
+            [[noreturn]]
+            auto unhandled_exception() const noexcept -> void {
+                std::terminate(); // Unreachable, the body catches everything
+            }
+
+            auto link(promise_type*& head) noexcept -> void {
+                next     = head;
+                previous = &head;
+                if (head)
+                    head->previous = &next;
+                head = this;
+            }
+            auto unlink() noexcept -> void {
+                if (previous) {
+                    *previous = next;
+                    if (next)
+                        next->previous = previous;
+                }
+            }
+        };
+
+        std::coroutine_handle<promise_type> coroutine;
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     A single-threaded event loop which runs coroutines. Ready
+     *     coroutines are resumed in FIFO order, and coroutines waiting
+     *     on a timer are resumed once their deadline has passed, in
+     *     deadline order. When only timers remain, the thread sleeps
+     *     until the earliest deadline.
+     *
+     *     The loop is not thread-safe. Coroutines resumed by the loop
+     *     must only be resumed by the loop.
+     */
+    class [[nodiscard]] EventLoop {
+    public:
+        using Clock = std::chrono::steady_clock;
+    private:
+        struct Timer {
+            Clock::time_point       deadline;
+            Usize                   sequence; // Keeps timers with equal deadlines in FIFO order
+            std::coroutine_handle<> coroutine;
+
+            // Orders the heap so that its front is the earliest timer
+            auto operator<(Timer const& other) const noexcept -> bool {
+                if (deadline != other.deadline)
+                    return deadline > other.deadline;
+                return sequence > other.sequence;
+            }
+        };
+
+        using DetachedPromise = dtl::DetachedTask::promise_type;
+
+        Vector<std::coroutine_handle<>> m_ready;
+        Vector<std::coroutine_handle<>> m_running;
+        Vector<Timer>                   m_timers;
+        Vector<std::coroutine_handle<>> m_abandoned; // Left by a failed `run_until_complete`
+        DetachedPromise*                m_detached = nullptr; // Spawned tasks yet to complete
+        Usize                           m_timer_sequence = 0;
+        std::exception_ptr              m_exception;
+
+        struct ScheduleAwaiter {
+            EventLoop* loop;
+
+            auto await_ready() const noexcept -> bool {
+                return false;
+            }
+            auto await_suspend(std::coroutine_handle<> const coroutine) const -> void {
+                loop->post(coroutine);
+            }
+            auto await_resume() const noexcept -> void {}
+        };
+
+        struct TimerAwaiter {
+            EventLoop*        loop;
+            Clock::time_point deadline;
+
+            auto await_ready() const noexcept -> bool {
+                return deadline <= Clock::now();
+            }
+            auto await_suspend(std::coroutine_handle<> const coroutine) const -> void {
+                loop->add_timer(deadline, coroutine);
+            }
+            auto await_resume() const noexcept -> void {}
+        };
+    public:
+        EventLoop() = default;
+        EventLoop(EventLoop const&) = delete;
+        auto operator=(EventLoop const&) -> EventLoop& = delete;
+
+        ~EventLoop() {
+            while (DetachedPromise* const promise = m_detached) {
+                m_detached = promise->next;
+                std::coroutine_handle<DetachedPromise>::from_promise(*promise).destroy();
+            }
+            for (std::coroutine_handle<> const coroutine : m_abandoned) {
+                coroutine.destroy();
+            }
+        }
+
+        // Queues `coroutine` to be resumed by the loop
+        auto post(std::coroutine_handle<> const coroutine) -> void {
+            m_ready.append(coroutine);
+        }
+
+        // Suspends the awaiting coroutine and queues it behind the currently ready ones
+        [[nodiscard]]
+        auto schedule() noexcept -> ScheduleAwaiter {
+            return ScheduleAwaiter { this };
+        }
+
+        [[nodiscard]]
+        auto sleep_until(Clock::time_point const deadline) noexcept -> TimerAwaiter {
+            return TimerAwaiter { this, deadline };
+        }
+        template <class Rep, class Period> [[nodiscard]]
+        auto sleep_for(std::chrono::duration<Rep, Period> const duration) noexcept -> TimerAwaiter {
+            auto const delay = std::chrono::duration_cast<Clock::duration>(duration);
+            return TimerAwaiter { this, Clock::now() + delay };
+        }
+
+        /* Description:
+         *     Starts `task` on the loop without waiting for it. The loop
+         *     owns the task, and destroys its frame once it completes or
+         *     when the loop is destroyed.
+         *
+         * Exceptions:
+         *     If the task throws, the exception is rethrown from `run`.
+         *     If the task can not be queued, it is destroyed before the
+         *     exception is propagated.
+         */
+        auto spawn(Task<void> task) -> void {
+            std::coroutine_handle<DetachedPromise> const coroutine =
+                detach(*this, std::move(task)).coroutine;
+            try {
+                post(coroutine);
+            }
+            catch (...) {
+                coroutine.destroy();
+                throw;
+            }
+            coroutine.promise().link(m_detached);
+        }
+
+        /* Description:
+         *     Resumes coroutines until none are ready and no timers are
+         *     pending.
+         *
+         * Exceptions:
+         *     Rethrows the first exception which escaped a spawned task.
+         *     The loop can be run again afterwards.
+         */
+        auto run() -> void {
+            while (run_once()) {}
+            rethrow_if_failed();
+        }
+
+        /* Description:
+         *     Starts `task` and runs the loop until it has completed,
+         *     leaving any other work queued.
+         *
+         * Return value:
+         *     The value produced by `task`.
+         *
+         * Exceptions:
+         *     Rethrows an exception which escaped `task` or a spawned
+         *     task. Throws `bu::EventLoopStalled` if the loop runs out
+         *     of work while `task` is still suspended. If `task` has not
+         *     completed when an exception is thrown, the loop takes over
+         *     its frame, which may still be referenced by queued or
+         *     nested coroutines, and destroys it once it completes or
+         *     when the loop is destroyed. Its result is discarded.
+         */
+        template <class T>
+        auto run_until_complete(Task<T> task) -> T {
+            assert(!task.is_empty());
+            // So that abandoning the task can not throw
+            m_abandoned.reserve(m_abandoned.size() + 1);
+            post(task.m_coroutine);
+            try {
+                while (!task.is_done()) {
+                    rethrow_if_failed();
+                    if (!run_once())
+                        throw EventLoopStalled {};
+                }
+            }
+            catch (...) {
+                if (!task.is_done())
+                    m_abandoned.append(BU exchange(task.m_coroutine, nullptr));
+                throw;
+            }
+            rethrow_if_failed();
+            return task.m_coroutine.promise().result();
+        }
+
+        [[nodiscard]]
+        auto is_idle() const noexcept -> bool {
+            return m_ready.is_empty() && m_timers.is_empty();
+        }
+    private:
+        static auto detach(EventLoop& loop, Task<void> task) -> dtl::DetachedTask {
+            try {
+                co_await task;
+            }
+            catch (...) {
+                if (!loop.m_exception)
+                    loop.m_exception = std::current_exception();
+            }
+        }
+
+        auto add_timer(Clock::time_point const deadline, std::coroutine_handle<> const coroutine)
+            -> void
+        {
+            m_timers.append(Timer { deadline, m_timer_sequence++, coroutine });
+            std::push_heap(m_timers.begin(), m_timers.end());
+        }
+
+        // Moves expired timers to the ready queue, sleeping first if nothing else is ready
+        auto poll_timers() -> void {
+            if (m_timers.is_empty())
+                return;
+            if (m_ready.is_empty())
+                std::this_thread::sleep_until(m_timers.front().deadline);
+
+            Clock::time_point const now = Clock::now();
+            while (!m_timers.is_empty() && m_timers.front().deadline <= now) {
+                std::pop_heap(m_timers.begin(), m_timers.end());
+                post(m_timers.back().coroutine);
+                m_timers.pop_back();
+            }
+        }
+
+        // Resumes the coroutines which are ready, returns false if there was no work left
+        auto run_once() -> bool {
+            poll_timers();
+            if (m_ready.is_empty())
+                return !m_timers.is_empty();
+
+            // Coroutines posted while resuming wait for the next round
+            m_running.swap(m_ready);
+            for (std::coroutine_handle<> const coroutine : m_running) {
+                coroutine.resume();
+            }
+            m_running.clear();
+            destroy_completed_abandoned();
+            return true;
+        }
+
+        auto destroy_completed_abandoned() noexcept -> void {
+            for (Usize i = 0; i < m_abandoned.size();) {
+                if (m_abandoned.data()[i].done()) {
+                    m_abandoned.data()[i].destroy();
+                    m_abandoned.data()[i] = m_abandoned.back();
+                    m_abandoned.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+
+        auto rethrow_if_failed() -> void {
+            if (m_exception)
+                std::rethrow_exception(BU exchange(m_exception, nullptr));
+        }
+    };
+}
@@ -0,0 +1,534 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "allocator.hpp"
+#include "memory.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+    // Locates the element at `position` past the start of the first block of a `bu::Deque`
+    template <class T, Usize block_size>
+    struct DequeLayout {
+        T* const* map         = nullptr;
+        Usize     map_mask    = 0;
+        Usize     first_block = 0;
+
+        [[nodiscard]]
+        constexpr auto block(Usize const position) const noexcept -> T* {
+            return map[(first_block + position / block_size) & map_mask];
+        }
+        [[nodiscard]]
+        constexpr auto element(Usize const position) const noexcept -> T& {
+            return block(position)[position % block_size];
+        }
+    };
+
+    template <class T, Usize block_size>
+    class DequeIterator {
+        DequeLayout<T, block_size> m_layout;
+        Usize                      m_position = 0;
+    public:
+        using value_type      = std::remove_const_t<T>;
+        using difference_type = Isize;
+
+        DequeIterator() = default;
+
+        constexpr explicit DequeIterator(
+            DequeLayout<T, block_size> const layout,
+            Usize const                      position) noexcept
+            : m_layout   { layout }
+            , m_position { position } {}
+
+        [[nodiscard]]
+        constexpr auto operator*() const noexcept -> T& {
+            return m_layout.element(m_position);
+        }
+        [[nodiscard]]
+        constexpr auto operator->() const noexcept -> T* {
+            return &m_layout.element(m_position);
+        }
+        [[nodiscard]]
+        constexpr auto operator[](Isize const offset) const noexcept -> T& {
+            return m_layout.element(m_position + offset);
+        }
+
+        constexpr auto operator++() noexcept -> DequeIterator& {
+            ++m_position;
+            return *this;
+        }
+        constexpr auto operator++(int) noexcept -> DequeIterator {
+            auto copy = *this;
+            ++m_position;
+            return copy;
+        }
+        constexpr auto operator--() noexcept -> DequeIterator& {
+            --m_position;
+            return *this;
+        }
+        constexpr auto operator--(int) noexcept -> DequeIterator {
+            auto copy = *this;
+            --m_position;
+            return copy;
+        }
+
+        constexpr auto operator+=(Isize const offset) noexcept -> DequeIterator& {
+            m_position += offset;
+            return *this;
+        }
+        constexpr auto operator-=(Isize const offset) noexcept -> DequeIterator& {
+            m_position -= offset;
+            return *this;
+        }
+
+        [[nodiscard]]
+        friend constexpr auto operator+(DequeIterator it, Isize const offset)
+            noexcept -> DequeIterator
+        {
+            return it += offset;
+        }
+        [[nodiscard]]
+        friend constexpr auto operator+(Isize const offset, DequeIterator it)
+            noexcept -> DequeIterator
+        {
+            return it += offset;
+        }
+        [[nodiscard]]
+        friend constexpr auto operator-(DequeIterator it, Isize const offset)
+            noexcept -> DequeIterator
+        {
+            return it -= offset;
+        }
+        [[nodiscard]]
+        friend constexpr auto operator-(DequeIterator const a, DequeIterator const b)
+            noexcept -> Isize
+        {
+            return static_cast<Isize>(a.m_position - b.m_position);
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(DequeIterator const& other) const noexcept -> bool {
+            return m_position == other.m_position;
+        }
+        [[nodiscard]]
+        constexpr auto operator<=>(DequeIterator const& other) const
+            noexcept -> std::strong_ordering
+        {
+            return m_position <=> other.m_position;
+        }
+
+        // Enable conversion of non-const to const iterators
+        [[nodiscard]]
+        constexpr operator DequeIterator<T const, block_size>() const
+            noexcept requires (!std::is_const_v<T>)
+        {
+            DequeLayout<T const, block_size> const layout {
+                m_layout.map, m_layout.map_mask, m_layout.first_block
+            };
+            return DequeIterator<T const, block_size> { layout, m_position };
+        }
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     The elements of a `bu::Deque` as a sequence of contiguous
+     *     spans, one per block, in order. Only the first and the last
+     *     span may be shorter than a block.
+     */
+    template <class T, Usize block_size>
+    class [[nodiscard]] DequeSegments {
+        dtl::DequeLayout<T, block_size> m_layout;
+        Usize                           m_start = 0;
+        Usize                           m_size  = 0;
+    public:
+        class Iterator {
+            DequeSegments const* m_segments = nullptr;
+            Usize                m_offset   = 0; // The index of the current span's first element
+        public:
+            using value_type      = Span<T>;
+            using difference_type = Isize;
+
+            Iterator() = default;
+
+            constexpr explicit Iterator(DequeSegments const& segments, Usize const offset) noexcept
+                : m_segments { &segments }
+                , m_offset   { offset } {}
+
+            [[nodiscard]]
+            constexpr auto operator*() const noexcept -> Span<T> {
+                Usize const position = m_segments->m_start + m_offset;
+                Usize const in_block = block_size - position % block_size;
+                Usize const length   = std::min(in_block, m_segments->m_size - m_offset);
+                return Span<T> { &m_segments->m_layout.element(position), length };
+            }
+
+            constexpr auto operator++() noexcept -> Iterator& {
+                m_offset += (**this).size();
+                return *this;
+            }
+            constexpr auto operator++(int) noexcept -> Iterator {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            [[nodiscard]]
+            constexpr auto operator==(Iterator const& other) const noexcept -> bool {
+                return m_offset == other.m_offset;
+            }
+        };
+
+        constexpr explicit DequeSegments(
+            dtl::DequeLayout<T, block_size> const layout,
+            Usize const                           start,
+            Usize const                           size) noexcept
+            : m_layout { layout }
+            , m_start  { start }
+            , m_size   { size } {}
+
+        [[nodiscard]]
+        constexpr auto begin() const noexcept -> Iterator {
+            return Iterator { *this, 0 };
+        }
+        [[nodiscard]]
+        constexpr auto end() const noexcept -> Iterator {
+            return Iterator { *this, m_size };
+        }
+    };
+
+
+    /* Description:
+     *     A double-ended queue which stores its elements in fixed-size
+     *     blocks, allocated through `A`, and keeps a circular map of
+     *     pointers to the blocks. Pushing and popping at either end is
+     *     amortized O(1) and never moves an element, and random access
+     *     costs a shift, a mask and two loads.
+     *
+     *     A block which is emptied by popping stays in the map, and is
+     *     reused when either end of the queue reaches it again, so a
+     *     queue in a steady state does not allocate at all. Call
+     *     `shrink_to_fit` to release the unused blocks.
+     */
+    template <class T, allocator_for<T> A = DefaultAllocator<T>>
+    class [[nodiscard]] Deque {
+    public:
+        // The number of elements of a block, a power of two so that locating an element needs no
+        // division
+        static constexpr Usize block_size = std::bit_floor(std::max<Usize>(16, 4096 / sizeof(T)));
+    private:
+        static constexpr Usize initial_map_size = 4;
+
+        [[no_unique_address]]
+        A          m_allocator;
+        Vector<T*> m_map;             // Circular, with a size which is zero or a power of two
+        Usize      m_first_block = 0; // The position in `m_map` of the block of the first element
+        Usize      m_start       = 0; // The position of the first element within its block
+        Usize      m_size        = 0;
+    public:
+        using ContainedType = T;
+        using AllocatorType = A;
+        using SizeType      = Usize;
+        using Iterator      = dtl::DequeIterator<T, block_size>;
+        using Sentinel      = Iterator;
+        using ConstIterator = dtl::DequeIterator<T const, block_size>;
+        using ConstSentinel = ConstIterator;
+
+        Deque() = default;
+
+        Deque(Deque const& other)
+            : m_allocator { other.m_allocator }
+        {
+            try {
+                for (T const& element : other) {
+                    push_back(element);
+                }
+            }
+            catch (...) {
+                release();
+                throw;
+            }
+        }
+
+        Deque(Deque&& other) noexcept
+            : m_allocator   { std::move(other.m_allocator) }
+            , m_map         { std::move(other.m_map) }
+            , m_first_block { BU exchange(other.m_first_block, 0) }
+            , m_start       { BU exchange(other.m_start, 0) }
+            , m_size        { BU exchange(other.m_size, 0) } {}
+
+        auto operator=(Deque const& other) -> Deque& {
+            if (this != &other) {
+                Deque copy = other;
+                swap(copy);
+            }
+            return *this;
+        }
+
+        auto operator=(Deque&& other) noexcept -> Deque& {
+            if (this != &other) {
+                this->~Deque();
+                std::construct_at(this, std::move(other));
+            }
+            return *this;
+        }
+
+        ~Deque() {
+            release();
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_size;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_size == 0;
+        }
+
+        /* Description:
+         *     Constructs a new element at the back of the deque with
+         *     `T(std::forward<Args>(args)...)`.
+         *
+         * Return value:
+         *     Reference to the newly constructed element.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(Args&&...)
+         *     - A::allocate(bu::Usize)
+         *     The deque is unchanged if an exception is thrown.
+         */
+        template <class... Args>
+        auto push_back(Args&&... args) -> T& {
+            Usize const position = m_start + m_size;
+            T* const    block    = block_for_back(position / block_size);
+            T* const    slot     = block + position % block_size;
+            T& element = *std::construct_at(slot, std::forward<Args>(args)...);
+            ++m_size;
+            return element;
+        }
+
+        // Like `push_back`, but at the front of the deque
+        template <class... Args>
+        auto push_front(Args&&... args) -> T& {
+            if (m_start != 0) {
+                T* const slot = layout().block(0) + m_start - 1;
+                T& element = *std::construct_at(slot, std::forward<Args>(args)...);
+                --m_start;
+                ++m_size;
+                return element;
+            }
+            Usize const block_index = block_for_front();
+            T* const    slot        = m_map.data()[block_index] + block_size - 1;
+            T& element = *std::construct_at(slot, std::forward<Args>(args)...);
+            m_first_block = block_index;
+            m_start       = block_size - 1;
+            ++m_size;
+            return element;
+        }
+
+        auto pop_back() noexcept -> void {
+            assert(m_size != 0);
+            destroy(layout().element(m_start + --m_size));
+            rewind_if_empty();
+        }
+
+        auto pop_front() noexcept -> void {
+            assert(m_size != 0);
+            destroy(layout().element(m_start));
+            --m_size;
+            if (++m_start == block_size) {
+                m_start       = 0;
+                m_first_block = (m_first_block + 1) & (m_map.size() - 1);
+            }
+            rewind_if_empty();
+        }
+
+        // Destroys every element, keeping the blocks for reuse
+        auto clear() noexcept -> void {
+            while (m_size != 0) {
+                pop_back();
+            }
+        }
+
+        // Releases the blocks which hold no elements
+        auto shrink_to_fit() noexcept -> void {
+            rewind_if_empty();
+            Usize const used = used_blocks();
+            for (Usize i = used; i < m_map.size(); ++i) {
+                T*& block = m_map.data()[(m_first_block + i) & (m_map.size() - 1)];
+                if (block) {
+                    m_allocator.deallocate(block, block_size);
+                    block = nullptr;
+                }
+            }
+        }
+
+        [[nodiscard]]
+        auto front() const noexcept -> T const& {
+            assert(m_size != 0);
+            return layout().element(m_start);
+        }
+        [[nodiscard]]
+        auto front() noexcept -> T& {
+            assert(m_size != 0);
+            return layout().element(m_start);
+        }
+        [[nodiscard]]
+        auto back() const noexcept -> T const& {
+            assert(m_size != 0);
+            return layout().element(m_start + m_size - 1);
+        }
+        [[nodiscard]]
+        auto back() noexcept -> T& {
+            assert(m_size != 0);
+            return layout().element(m_start + m_size - 1);
+        }
+
+        [[nodiscard]]
+        auto operator[](Usize const index) const -> T const& {
+            if (index < m_size)
+                return layout().element(m_start + index);
+            else
+                throw OutOfRange {};
+        }
+        [[nodiscard]]
+        auto operator[](Usize const index) -> T& {
+            return const_cast<T&>(const_cast<Deque const&>(*this)[index]);
+        }
+
+        auto at(Usize const index) const noexcept -> Option<T const&> {
+            if (index < m_size)
+                return layout().element(m_start + index);
+            else
+                return nullopt;
+        }
+        auto at(Usize const index) noexcept -> Option<T&> {
+            if (index < m_size)
+                return layout().element(m_start + index);
+            else
+                return nullopt;
+        }
+
+        // The elements as contiguous runs, for consumers which process them in bulk
+        [[nodiscard]]
+        auto segments() const noexcept -> DequeSegments<T const, block_size> {
+            return DequeSegments<T const, block_size> { const_layout(), m_start, m_size };
+        }
+        [[nodiscard]]
+        auto segments() noexcept -> DequeSegments<T, block_size> {
+            return DequeSegments<T, block_size> { layout(), m_start, m_size };
+        }
+
+        [[nodiscard]]
+        auto begin() const noexcept -> ConstIterator {
+            return ConstIterator { const_layout(), m_start };
+        }
+        [[nodiscard]]
+        auto begin() noexcept -> Iterator {
+            return Iterator { layout(), m_start };
+        }
+
+        [[nodiscard]]
+        auto end() const noexcept -> ConstSentinel {
+            return ConstSentinel { const_layout(), m_start + m_size };
+        }
+        [[nodiscard]]
+        auto end() noexcept -> Sentinel {
+            return Sentinel { layout(), m_start + m_size };
+        }
+
+        auto swap(Deque& other) noexcept -> void {
+            if constexpr (AllocatorTraits<A>::propagate_on_swap) {
+                BU swap(m_allocator, other.m_allocator);
+            }
+            m_map.swap(other.m_map);
+            BU swap(m_first_block, other.m_first_block);
+            BU swap(m_start, other.m_start);
+            BU swap(m_size, other.m_size);
+        }
+    private:
+        [[nodiscard]]
+        auto layout() const noexcept -> dtl::DequeLayout<T, block_size> {
+            Usize const map_mask = m_map.size() - 1;
+            return dtl::DequeLayout<T, block_size> { m_map.data(), map_mask, m_first_block };
+        }
+        [[nodiscard]]
+        auto const_layout() const noexcept -> dtl::DequeLayout<T const, block_size> {
+            Usize const map_mask = m_map.size() - 1;
+            return dtl::DequeLayout<T const, block_size> { m_map.data(), map_mask, m_first_block };
+        }
+
+        /* Description:
+         *     Moves the positions of an empty deque back to the start of
+         *     the map. `push_front` relies on the block of the first
+         *     element being allocated whenever `m_start` is nonzero,
+         *     which `shrink_to_fit` would otherwise break by releasing
+         *     it once the deque is empty.
+         */
+        auto rewind_if_empty() noexcept -> void {
+            if (m_size == 0) {
+                m_start       = 0;
+                m_first_block = 0;
+            }
+        }
+
+        // The number of blocks which hold elements, counted from the first
+        [[nodiscard]]
+        auto used_blocks() const noexcept -> Usize {
+            return m_size ? (m_start + m_size - 1) / block_size + 1 : 0;
+        }
+
+        // The block at `index` counted from the first, allocating it or growing the map if needed
+        [[nodiscard]]
+        auto block_for_back(Usize const index) -> T* {
+            if (index >= m_map.size())
+                grow_map();
+            T*& block = m_map.data()[(m_first_block + index) & (m_map.size() - 1)];
+            if (!block)
+                block = m_allocator.allocate(block_size);
+            return block;
+        }
+
+        // The position in the map of the block before the first, allocating it or growing the
+        // map if needed
+        [[nodiscard]]
+        auto block_for_front() -> Usize {
+            if (used_blocks() == m_map.size())
+                grow_map();
+            Usize const index = (m_first_block - 1) & (m_map.size() - 1);
+            T*& block = m_map.data()[index];
+            if (!block)
+                block = m_allocator.allocate(block_size);
+            return index;
+        }
+
+        // Doubles the map, moving the block pointers so that the first block is at the start
+        auto grow_map() -> void {
+            Usize const old_size = m_map.size();
+            Vector<T*>  map(old_size ? old_size * 2 : initial_map_size);
+            for (Usize i = 0; i != old_size; ++i) {
+                map.data()[i] = m_map.data()[(m_first_block + i) & (old_size - 1)];
+            }
+            m_map.swap(map);
+            m_first_block = 0;
+        }
+
+        auto release() noexcept -> void {
+            clear();
+            for (T* const block : m_map) {
+                if (block)
+                    m_allocator.deallocate(block, block_size);
+            }
+            m_map.clear();
+        }
+    };
+}
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+    /* Description:
+     *     The position of the first element of the sorted array
+     *     `[base, base + length)` which is not less than `key`. Every
+     *     iteration halves the range and selects the next base with a
+     *     conditional move rather than a branch, so the loop runs the
+     *     same number of iterations for every key and never mispredicts.
+     */
+    template <class T, class Key, class Compare>
+    [[nodiscard]]
+    constexpr auto branchless_lower_bound(
+        T const*       base,
+        Usize          length,
+        Key const&     key,
+        Compare const& compare) -> Usize
+    {
+        if (length == 0)
+            return 0;
+        T const* const first = base;
+        while (length > 1) {
+            Usize const half = length / 2;
+            base    = compare(base[half], key) ? base + half : base;
+            length -= half;
+        }
+        return static_cast<Usize>(base - first) + compare(*base, key);
+    }
+
+    // The positions of `keys` in sorted order, keeping only the last of each group of equivalent
+    // keys
+    template <class K, class Compare>
+    [[nodiscard]]
+    auto sorted_last_occurrences(Span<K const> const keys, Compare const& compare)
+        -> Vector<Usize>
+    {
+        K const* const key = keys.data();
+        Usize    const n   = keys.size();
+
+        Vector<Usize> order(n);
+        for (Usize i = 0; i != n; ++i) {
+            order.data()[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](Usize const a, Usize const b) {
+            return compare(key[a], key[b]);
+        });
+
+        Usize kept = 0;
+        for (Usize i = 0; i != n; ++i) {
+            if (i + 1 != n && !compare(key[order.data()[i]], key[order.data()[i + 1]]))
+                continue; // Superseded by a later equivalent key
+            order.data()[kept++] = order.data()[i];
+        }
+        while (order.size() != kept) {
+            order.pop_back();
+        }
+        return order;
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     An ordered map stored as two parallel `bu::Vector`s, the keys
+     *     sorted with respect to `Compare`, and the values. Lookups are
+     *     branchless binary searches over the densely packed keys, so
+     *     for read-mostly tables this beats node-based maps on both
+     *     memory and cache misses. Inserting or erasing a single entry
+     *     shifts the entries after it, so prefer building the map in
+     *     bulk with the constructor or `extend`, which sort the input.
+     */
+    template <class K, class V, class Compare = std::less<>>
+        requires std::strict_weak_order<Compare const&, K const&, K const&>
+    class [[nodiscard]] FlatMap {
+        [[no_unique_address]]
+        Compare   m_compare;
+        Vector<K> m_keys;
+        Vector<V> m_values;
+    public:
+        using KeyType   = K;
+        using ValueType = V;
+        using SizeType  = Usize;
+
+        FlatMap() = default;
+
+        /* Description:
+         *     Builds the map from the parallel arrays `keys` and `values`
+         *     in any order, in O(n log n). If a key occurs more than once,
+         *     its last value is kept, as if the entries were inserted one
+         *     by one.
+         *
+         * Preconditions:
+         *     `keys.size() == values.size()`
+         */
+        explicit FlatMap(Vector<K> keys, Vector<V> values, Compare compare = {})
+            : m_compare { std::move(compare) }
+        {
+            assert(keys.size() == values.size());
+            auto const order = dtl::sorted_last_occurrences(Span<K const> { keys }, m_compare);
+            m_keys.reserve(order.size());
+            m_values.reserve(order.size());
+            for (Usize const i : order) {
+                m_keys.append(std::move(keys.data()[i]));
+                m_values.append(std::move(values.data()[i]));
+            }
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_keys.size();
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_keys.is_empty();
+        }
+
+        auto reserve(Usize const capacity) -> void {
+            m_keys.reserve(capacity);
+            m_values.reserve(capacity);
+        }
+
+        auto clear() noexcept -> void {
+            m_keys.clear();
+            m_values.clear();
+        }
+
+        // The position of `key` within `keys()`, if it is present
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto index_of(Key const& key) const -> Option<Usize> {
+            Usize const position = lower_bound(key);
+            if (position != size() && !m_compare(key, m_keys.data()[position]))
+                return position;
+            else
+                return nullopt;
+        }
+
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto contains(Key const& key) const -> bool {
+            return index_of(key).has_value();
+        }
+
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto find(Key const& key) const -> Option<V const&> {
+            if (Option<Usize> const position = index_of(key))
+                return m_values.data()[position.value()];
+            else
+                return nullopt;
+        }
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto find(Key const& key) -> Option<V&> {
+            if (Option<Usize> const position = index_of(key))
+                return m_values.data()[position.value()];
+            else
+                return nullopt;
+        }
+
+        /* Description:
+         *     Associates `value` with `key`, shifting the following
+         *     entries if `key` is new.
+         *
+         * Return value:
+         *     The value previously associated with `key`, if any.
+         */
+        auto insert(K key, V value) -> Option<V> {
+            Usize const position = lower_bound(key);
+            if (position != size() && !m_compare(key, m_keys.data()[position]))
+                return BU exchange(m_values.data()[position], std::move(value));
+
+            m_keys.append(std::move(key));
+            try {
+                m_values.append(std::move(value));
+            }
+            catch (...) {
+                m_keys.pop_back();
+                throw;
+            }
+            std::rotate(m_keys.begin()   + position, m_keys.end()   - 1, m_keys.end());
+            std::rotate(m_values.begin() + position, m_values.end() - 1, m_values.end());
+            return nullopt;
+        }
+
+        /* Description:
+         *     Inserts a batch of entries given as parallel arrays, in any
+         *     order. The batch is sorted and then merged with the map in
+         *     a single linear pass, which is far cheaper than inserting
+         *     the entries one by one. Equivalent keys are resolved as if
+         *     the entries were inserted one by one.
+         *
+         * Preconditions:
+         *     `keys.size() == values.size()`
+         */
+        auto extend(Vector<K> keys, Vector<V> values) -> void {
+            assert(keys.size() == values.size());
+            auto const order = dtl::sorted_last_occurrences(Span<K const> { keys }, m_compare);
+
+            Vector<K> merged_keys;
+            Vector<V> merged_values;
+            merged_keys.reserve(size() + order.size());
+            merged_values.reserve(size() + order.size());
+
+            Usize i = 0;
+            for (Usize const j : order) {
+                K& key = keys.data()[j];
+                for (; i != size() && m_compare(m_keys.data()[i], key); ++i) {
+                    merged_keys.append(std::move(m_keys.data()[i]));
+                    merged_values.append(std::move(m_values.data()[i]));
+                }
+                if (i != size() && !m_compare(key, m_keys.data()[i]))
+                    ++i; // Replaced by the batch
+                merged_keys.append(std::move(key));
+                merged_values.append(std::move(values.data()[j]));
+            }
+            for (; i != size(); ++i) {
+                merged_keys.append(std::move(m_keys.data()[i]));
+                merged_values.append(std::move(m_values.data()[i]));
+            }
+
+            m_keys.swap(merged_keys);
+            m_values.swap(merged_values);
+        }
+
+        /* Description:
+         *     Removes the entry of `key`, if any, shifting the following
+         *     entries.
+         *
+         * Return value:
+         *     The removed value, if any.
+         */
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        auto erase(Key const& key) -> Option<V> {
+            Option<Usize> const position = index_of(key);
+            if (!position)
+                return nullopt;
+
+            Usize const index = position.value();
+            Option<V> removed { in_place, std::move(m_values.data()[index]) };
+            std::move(m_keys.begin()   + index + 1, m_keys.end(),   m_keys.begin()   + index);
+            std::move(m_values.begin() + index + 1, m_values.end(), m_values.begin() + index);
+            m_keys.pop_back();
+            m_values.pop_back();
+            return removed;
+        }
+
+        // The keys in ascending order, and their values, in the same order
+        [[nodiscard]]
+        auto keys() const noexcept -> Span<K const> {
+            return Span<K const> { m_keys.data(), m_keys.size() };
+        }
+
+        [[nodiscard]]
+        auto values() const noexcept -> Span<V const> {
+            return Span<V const> { m_values.data(), m_values.size() };
+        }
+        [[nodiscard]]
+        auto values() noexcept -> Span<V> {
+            return Span<V> { m_values.data(), m_values.size() };
+        }
+    private:
+        template <class Key>
+        [[nodiscard]]
+        auto lower_bound(Key const& key) const -> Usize {
+            return dtl::branchless_lower_bound(m_keys.data(), m_keys.size(), key, m_compare);
+        }
+    };
+
+
+    /* Description:
+     *     An ordered set stored as a sorted `bu::Vector`, with the same
+     *     trade-offs as `bu::FlatMap`.
+     */
+    template <class K, class Compare = std::less<>>
+        requires std::strict_weak_order<Compare const&, K const&, K const&>
+    class [[nodiscard]] FlatSet {
+        [[no_unique_address]]
+        Compare   m_compare;
+        Vector<K> m_keys;
+    public:
+        using KeyType       = K;
+        using SizeType      = Usize;
+        using ConstIterator = K const*;
+        using ConstSentinel = ConstIterator;
+
+        FlatSet() = default;
+
+        // Builds the set from `keys` in any order, in O(n log n)
+        explicit FlatSet(Vector<K> keys, Compare compare = {})
+            : m_compare { std::move(compare) }
+            , m_keys    { std::move(keys) }
+        {
+            std::sort(m_keys.begin(), m_keys.end(), m_compare);
+            auto const equivalent = [&](K const& a, K const& b) { return !m_compare(a, b); };
+            K* const   unique_end = std::unique(m_keys.begin(), m_keys.end(), equivalent);
+            while (m_keys.end() != unique_end) {
+                m_keys.pop_back();
+            }
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_keys.size();
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_keys.is_empty();
+        }
+
+        auto reserve(Usize const capacity) -> void {
+            m_keys.reserve(capacity);
+        }
+
+        auto clear() noexcept -> void {
+            m_keys.clear();
+        }
+
+        // The position of `key` within `keys()`, if it is present
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto index_of(Key const& key) const -> Option<Usize> {
+            Usize const position = lower_bound(key);
+            if (position != size() && !m_compare(key, m_keys.data()[position]))
+                return position;
+            else
+                return nullopt;
+        }
+
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto contains(Key const& key) const -> bool {
+            return index_of(key).has_value();
+        }
+
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        [[nodiscard]]
+        auto find(Key const& key) const -> Option<K const&> {
+            if (Option<Usize> const position = index_of(key))
+                return m_keys.data()[position.value()];
+            else
+                return nullopt;
+        }
+
+        /* Description:
+         *     Inserts `key` if no equivalent key is present, shifting the
+         *     following keys.
+         *
+         * Return value:
+         *     `true` if `key` was inserted.
+         */
+        auto insert(K key) -> bool {
+            Usize const position = lower_bound(key);
+            if (position != size() && !m_compare(key, m_keys.data()[position]))
+                return false;
+            m_keys.append(std::move(key));
+            std::rotate(m_keys.begin() + position, m_keys.end() - 1, m_keys.end());
+            return true;
+        }
+
+        /* Description:
+         *     Inserts a batch of keys in any order. The batch is sorted
+         *     and then merged with the set in a single linear pass. Keys
+         *     which are already present are left unchanged.
+         */
+        auto extend(Vector<K> keys) -> void {
+            FlatSet batch { std::move(keys), m_compare };
+
+            Vector<K> merged;
+            merged.reserve(size() + batch.size());
+
+            Usize i = 0;
+            for (K& key : batch.m_keys) {
+                for (; i != size() && m_compare(m_keys.data()[i], key); ++i) {
+                    merged.append(std::move(m_keys.data()[i]));
+                }
+                if (i == size() || m_compare(key, m_keys.data()[i]))
+                    merged.append(std::move(key));
+            }
+            for (; i != size(); ++i) {
+                merged.append(std::move(m_keys.data()[i]));
+            }
+
+            m_keys.swap(merged);
+        }
+
+        // Removes the key equivalent to `key`, if any. Returns `true` if a key was removed
+        template <class Key>
+            requires std::strict_weak_order<Compare const&, K const&, Key const&>
+        auto erase(Key const& key) -> bool {
+            Option<Usize> const position = index_of(key);
+            if (!position)
+                return false;
+            Usize const index = position.value();
+            std::move(m_keys.begin() + index + 1, m_keys.end(), m_keys.begin() + index);
+            m_keys.pop_back();
+            return true;
+        }
+
+        // The keys in ascending order
+        [[nodiscard]]
+        auto keys() const noexcept -> Span<K const> {
+            return Span<K const> { m_keys.data(), m_keys.size() };
+        }
+
+        [[nodiscard]] auto begin() const noexcept -> ConstIterator { return m_keys.begin(); }
+        [[nodiscard]] auto end()   const noexcept -> ConstSentinel { return m_keys.end(); }
+    private:
+        template <class Key>
+        [[nodiscard]]
+        auto lower_bound(Key const& key) const -> Usize {
+            return dtl::branchless_lower_bound(m_keys.data(), m_keys.size(), key, m_compare);
+        }
+    };
+}
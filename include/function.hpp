@@ -0,0 +1,77 @@
+#pragma once
+
+#include "utility.hpp"
+#include "any.hpp"
+
+
+namespace bu {
+    template <class Signature>
+    class UniqueFunction;
+
+    /* Description:
+     *     A move-only, type-erased callable. The callable is stored in
+     *     the small buffer of a `bu::MoveOnlyAny`, so wrapping a closure
+     *     of at most `dtl::small_any_buffer_size` bytes does not
+     *     allocate. Unlike `std::function`, move-only closures, such as
+     *     ones capturing a `bu::UniquePtr`, can be stored.
+     */
+    template <class R, class... Args>
+    class [[nodiscard]] UniqueFunction<R(Args...)> {
+        MoveOnlyAny m_storage;
+        R        (* m_invoke)(MoveOnlyAny&, Args&&...) = nullptr;
+    public:
+        UniqueFunction() = default;
+
+        template <class F, class Stored = std::decay_t<F>>
+            requires (!std::same_as<Stored, UniqueFunction>)
+                  && std::is_invocable_r_v<R, Stored&, Args...>
+        UniqueFunction(F&& function)
+            noexcept(std::is_nothrow_constructible_v<Stored, F&&>
+                && dtl::fits_in_small_any_buffer<Stored>)
+            : m_storage { in_place_type<Stored>, std::forward<F>(function) }
+            , m_invoke  { &invoke<Stored> } {}
+
+        UniqueFunction(UniqueFunction&& other) noexcept
+            : m_storage { std::move(other.m_storage) }
+            , m_invoke  { BU exchange(other.m_invoke, nullptr) }
+        {
+            other.m_storage.reset();
+        }
+
+        auto operator=(UniqueFunction&& other) noexcept -> UniqueFunction& {
+            if (this != &other) {
+                m_storage = std::move(other.m_storage);
+                m_invoke  = BU exchange(other.m_invoke, nullptr);
+                other.m_storage.reset();
+            }
+            return *this;
+        }
+
+        auto operator()(Args... args) -> R {
+            assert(m_invoke);
+            return m_invoke(m_storage, std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_invoke == nullptr;
+        }
+        [[nodiscard]]
+        explicit operator bool() const noexcept {
+            return m_invoke != nullptr;
+        }
+
+        auto reset() noexcept -> void {
+            m_storage.reset();
+            m_invoke = nullptr;
+        }
+    private:
+        template <class Stored>
+        static auto invoke(MoveOnlyAny& storage, Args&&... args) -> R {
+            if constexpr (std::is_void_v<R>)
+                std::invoke(storage.unchecked_cast<Stored>(), std::forward<Args>(args)...);
+            else
+                return std::invoke(storage.unchecked_cast<Stored>(), std::forward<Args>(args)...);
+        }
+    };
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <bit>
+
+#include "utility.hpp"
+#include "string.hpp"
+
+
+namespace bu::dtl {
+    // Little-endian loads which are usable in constant expressions
+    constexpr auto read_u64(char const* const p) noexcept -> std::uint64_t {
+        if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+            std::uint64_t value;
+            std::memcpy(&value, p, sizeof value);
+            return value;
+        }
+        std::uint64_t value = 0;
+        for (Usize i = 0; i != 8; ++i) {
+            value |= std::uint64_t { static_cast<unsigned char>(p[i]) } << (8 * i);
+        }
+        return value;
+    }
+    constexpr auto read_u32(char const* const p) noexcept -> std::uint64_t {
+        if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+            std::uint32_t value;
+            std::memcpy(&value, p, sizeof value);
+            return value;
+        }
+        std::uint64_t value = 0;
+        for (Usize i = 0; i != 4; ++i) {
+            value |= std::uint64_t { static_cast<unsigned char>(p[i]) } << (8 * i);
+        }
+        return value;
+    }
+
+    // Multiplies `a` and `b`, leaving the low half of the product in `a` and the high half in `b`
+    constexpr auto multiply_128(std::uint64_t& a, std::uint64_t& b) noexcept -> void {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 const product = static_cast<unsigned __int128>(a) * b;
+        a = static_cast<std::uint64_t>(product);
+        b = static_cast<std::uint64_t>(product >> 64);
+#else
+        std::uint64_t const a_high = a >> 32, a_low = a & 0xffffffff;
+        std::uint64_t const b_high = b >> 32, b_low = b & 0xffffffff;
+        std::uint64_t const high_high = a_high * b_high, high_low = a_high * b_low;
+        std::uint64_t const low_high  = a_low  * b_high, low_low  = a_low  * b_low;
+        std::uint64_t const middle    = high_low + low_high;
+        std::uint64_t const carry     = middle < high_low;
+        std::uint64_t const low       = low_low + (middle << 32);
+        a = low;
+        b = high_high + (middle >> 32) + (carry << 32) + (low < low_low);
+#endif
+    }
+
+    constexpr auto wymix(std::uint64_t a, std::uint64_t b) noexcept -> std::uint64_t {
+        multiply_128(a, b);
+        return a ^ b;
+    }
+
+    // Mixes the 16 bytes at `p` into `state`
+    constexpr auto wymix_block(
+        char const*   const p,
+        std::uint64_t const secret,
+        std::uint64_t const state) noexcept -> std::uint64_t
+    {
+        return wymix(read_u64(p) ^ secret, read_u64(p + 8) ^ state);
+    }
+
+    // The splitmix64 finalizer, a bijective scrambling of all 64 bits
+    constexpr auto mix64(std::uint64_t x) noexcept -> std::uint64_t {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    // Maps `hash` to `[0, range)` by multiplication rather than division
+    constexpr auto reduce_range(std::uint64_t hash, std::uint64_t range) noexcept -> Usize {
+        multiply_128(hash, range);
+        return static_cast<Usize>(range);
+    }
+}
+
+
+namespace bu {
+    // 64-bit FNV-1a, simple and adequate for short keys
+    [[nodiscard]]
+    constexpr auto fnv1a(StringView const string) noexcept -> std::uint64_t {
+        std::uint64_t hash = 0xcbf29ce484222325;
+        for (char const character : string) {
+            hash ^= static_cast<unsigned char>(character);
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
+
+    /* Description:
+     *     The final version 4 of Wang Yi's wyhash. Bulk input is consumed
+     *     48 bytes per iteration, and short input with a couple of
+     *     overlapping loads, so it is considerably faster than FNV-1a for
+     *     anything but the shortest keys. Produces the same values at
+     *     compile time and at run time, on any byte order.
+     */
+    [[nodiscard]]
+    constexpr auto wyhash(StringView const string, std::uint64_t seed = 0)
+        noexcept -> std::uint64_t
+    {
+        constexpr std::uint64_t secret[] {
+            0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47
+        };
+
+        char const* p      = string.data();
+        Usize const length = string.size();
+        std::uint64_t a, b;
+
+        seed ^= dtl::wymix(seed ^ secret[0], secret[1]);
+        if (length <= 16) {
+            if (length >= 4) {
+                Usize const offset = (length >> 3) << 2;
+                a = (dtl::read_u32(p) << 32) | dtl::read_u32(p + offset);
+                b = (dtl::read_u32(p + length - 4) << 32) | dtl::read_u32(p + length - 4 - offset);
+            }
+            else if (length > 0) {
+                a = (std::uint64_t { static_cast<unsigned char>(p[0]) } << 16)
+                  | (std::uint64_t { static_cast<unsigned char>(p[length >> 1]) } << 8)
+                  | static_cast<unsigned char>(p[length - 1]);
+                b = 0;
+            }
+            else {
+                a = b = 0;
+            }
+        }
+        else {
+            Usize remaining = length;
+            if (remaining > 48) {
+                std::uint64_t see1 = seed, see2 = seed;
+                do {
+                    seed = dtl::wymix_block(p,      secret[1], seed);
+                    see1 = dtl::wymix_block(p + 16, secret[2], see1);
+                    see2 = dtl::wymix_block(p + 32, secret[3], see2);
+                    p         += 48;
+                    remaining -= 48;
+                } while (remaining > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (remaining > 16) {
+                seed = dtl::wymix_block(p, secret[1], seed);
+                p         += 16;
+                remaining -= 16;
+            }
+            a = dtl::read_u64(p + remaining - 16);
+            b = dtl::read_u64(p + remaining - 8);
+        }
+        a ^= secret[1];
+        b ^= seed;
+        dtl::multiply_128(a, b);
+        return dtl::wymix(a ^ secret[0] ^ length, b ^ secret[1]);
+    }
+
+    // The hashes of a literal, computed at compile time
+    template <Metastring string>
+    constexpr std::uint64_t fnv1a_of = fnv1a(StringView { string.string(), string.size() });
+
+    template <Metastring string>
+    constexpr std::uint64_t wyhash_of = wyhash(StringView { string.string(), string.size() });
+}
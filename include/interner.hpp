@@ -0,0 +1,331 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <mutex>
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "option.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+#include "string.hpp"
+#include "hash.hpp"
+
+
+namespace bu {
+    using InternerFull = StatelessException<"interner ran out of symbols">;
+
+    /* Description:
+     *     A handle to a string interned by a `bu::Interner`. Two symbols
+     *     from the same interner are equal if and only if their strings
+     *     are, so comparing and hashing symbols is an integer operation.
+     *     A default-constructed symbol refers to the empty string.
+     */
+    class [[nodiscard]] Symbol {
+        std::uint32_t m_id = 0;
+    public:
+        Symbol() = default;
+
+        constexpr explicit Symbol(std::uint32_t const id) noexcept
+            : m_id { id } {}
+
+        [[nodiscard]]
+        constexpr auto id() const noexcept -> std::uint32_t {
+            return m_id;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(Symbol const&) const noexcept -> bool = default;
+        [[nodiscard]]
+        constexpr auto operator<=>(Symbol const&) const noexcept -> std::strong_ordering = default;
+    };
+}
+
+
+template <>
+struct std::hash<bu::Symbol> {
+    [[nodiscard]]
+    constexpr auto operator()(bu::Symbol const symbol) const noexcept -> std::size_t {
+        return symbol.id();
+    }
+};
+
+
+namespace bu::dtl {
+    // Stores the interned strings in large blocks, which are never moved or freed before the
+    // interner itself
+    class [[nodiscard]] InternerArena {
+        static constexpr Usize block_size = 64 * 1024;
+
+        Vector<UniquePtr<char[]>> m_blocks;
+        char*                     m_cursor    = nullptr;
+        Usize                     m_remaining = 0;
+    public:
+        // Returns a null-terminated copy of `string`
+        auto store(StringView const string) -> StringView {
+            Usize const required = string.size() + 1;
+            if (required > m_remaining) {
+                if (required > block_size / 4) { // Give large strings a block of their own
+                    char* const block = m_blocks.append(make_unique<char[]>(required)).get();
+                    return copy_to(block, string);
+                }
+                m_cursor    = m_blocks.append(make_unique<char[]>(block_size)).get();
+                m_remaining = block_size;
+            }
+            StringView const stored = copy_to(m_cursor, string);
+            m_cursor    += required;
+            m_remaining -= required;
+            return stored;
+        }
+    private:
+        static auto copy_to(char* const destination, StringView const string)
+            noexcept -> StringView
+        {
+            if (!string.is_empty())
+                std::memcpy(destination, string.data(), string.size());
+            destination[string.size()] = '\0';
+            return StringView { destination, string.size() };
+        }
+    };
+
+    /* Description:
+     *     An open addressing table of a single shard. Each slot packs the
+     *     upper half of the hash of a string with its symbol id plus one,
+     *     so that readers can probe the table without locking, and an
+     *     empty slot reads as zero.
+     */
+    struct InternerTable {
+        UniquePtr<std::atomic<std::uint64_t>[]> slots;
+        Usize                                   mask  = 0;
+        Usize                                   count = 0; // Only accessed with the shard locked
+
+        explicit InternerTable(Usize const capacity)
+            : slots { make_unique<std::atomic<std::uint64_t>[]>(capacity) }
+            , mask  { capacity - 1 } {}
+    };
+
+    struct alignas(64) InternerShard {
+        std::mutex                       mutex;
+        std::atomic<InternerTable*>      table = nullptr;
+        // The current table and the retired ones, which readers may still probe
+        Vector<UniquePtr<InternerTable>> tables;
+        InternerArena                    arena;
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     Deduplicates strings into an arena and identifies each distinct
+     *     string by a 32-bit `bu::Symbol`.
+     *
+     *     Interning an already interned string and resolving a symbol
+     *     are lock-free. Strings are partitioned into shards by hash,
+     *     and inserting a new string locks only its shard. Tables which
+     *     are outgrown are retired rather than freed, so concurrent
+     *     readers never observe freed memory. The strings themselves are
+     *     never moved, so the views returned by `resolve` remain valid
+     *     for the lifetime of the interner.
+     */
+    class [[nodiscard]] Interner {
+        static constexpr Usize shard_bits         = 4;
+        static constexpr Usize shard_count        = Usize { 1 } << shard_bits;
+        static constexpr Usize initial_table_size = 64;
+        static constexpr Usize first_chunk_bits   = 10;
+        static constexpr Usize chunk_count        = 32 - first_chunk_bits + 1;
+
+        // Symbol `id` lives in chunk `k`, where `id + 2^first_chunk_bits` has bit width
+        // `first_chunk_bits + k + 1`
+        std::atomic<StringView*>   m_chunks[chunk_count] {};
+        std::atomic<std::uint32_t> m_size = 0;
+        dtl::InternerShard         m_shards[shard_count];
+    public:
+        Interner() {
+            for (dtl::InternerShard& shard : m_shards) {
+                auto table = make_unique<dtl::InternerTable>(initial_table_size);
+                shard.table.store(shard.tables.append(std::move(table)).get());
+            }
+            [[maybe_unused]] Symbol const empty = intern(StringView {});
+            assert(empty == Symbol {});
+        }
+
+        Interner(Interner const&) = delete;
+        auto operator=(Interner const&) -> Interner& = delete;
+
+        ~Interner() {
+            for (std::atomic<StringView*>& chunk : m_chunks) {
+                delete[] chunk.load();
+            }
+        }
+
+        // The interner used by `bu::static_symbol`
+        [[nodiscard]]
+        static auto global() -> Interner& {
+            static Interner interner;
+            return interner;
+        }
+
+        /* Description:
+         *     Returns the symbol of `string`, interning a copy of it if it
+         *     has not been interned before.
+         *
+         * Exceptions:
+         *     Throws `bu::InternerFull` if every 32-bit symbol is taken.
+         */
+        auto intern(StringView const string) -> Symbol {
+            std::uint64_t const hash  = wyhash(string);
+            dtl::InternerShard& shard = m_shards[hash >> (64 - shard_bits)];
+
+            dtl::InternerTable const& published = *shard.table.load(std::memory_order_acquire);
+            if (Option<Symbol> const symbol = find_in(published, hash, string))
+                return symbol.value();
+
+            std::scoped_lock const lock { shard.mutex };
+            dtl::InternerTable* table = shard.table.load(std::memory_order_relaxed);
+            // Another thread may have interned the string while this one waited for the lock
+            if (Option<Symbol> const symbol = find_in(*table, hash, string))
+                return symbol.value();
+
+            if ((table->count + 1) * 4 > (table->mask + 1) * 3)
+                table = grow(shard);
+
+            std::uint32_t const id = m_size.fetch_add(1, std::memory_order_relaxed);
+            if (id == maximum<std::uint32_t>) {
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                throw InternerFull {};
+            }
+            new_entry(id) = shard.arena.store(string);
+
+            // Publishing the slot with release makes the entry visible to lock-free readers
+            insert(*table, hash, id, std::memory_order_release);
+            ++table->count;
+            return Symbol { id };
+        }
+
+        // The symbol of `string`, if it has been interned
+        [[nodiscard]]
+        auto find(StringView const string) const noexcept -> Option<Symbol> {
+            std::uint64_t const hash = wyhash(string);
+            dtl::InternerShard const& shard = m_shards[hash >> (64 - shard_bits)];
+            return find_in(*shard.table.load(std::memory_order_acquire), hash, string);
+        }
+
+        // Precondition: `symbol` was produced by this interner
+        [[nodiscard]]
+        auto resolve(Symbol const symbol) const noexcept -> StringView {
+            assert(symbol.id() < size());
+            auto const [chunk, offset] = locate(symbol.id());
+            return m_chunks[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        // The number of distinct interned strings, including the empty string
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_size.load(std::memory_order_relaxed);
+        }
+    private:
+        struct Location {
+            Usize chunk;
+            Usize offset;
+        };
+
+        [[nodiscard]]
+        static constexpr auto locate(std::uint32_t const id) noexcept -> Location {
+            std::uint64_t const biased = id + (std::uint64_t { 1 } << first_chunk_bits);
+            auto          const width  = static_cast<Usize>(std::bit_width(biased));
+            Usize         const chunk  = width - first_chunk_bits - 1;
+            std::uint64_t const start  = std::uint64_t { 1 } << (width - 1);
+            return Location { chunk, static_cast<Usize>(biased - start) };
+        }
+
+        // The entry of a newly allocated `id`, installing its chunk if needed
+        [[nodiscard]]
+        auto new_entry(std::uint32_t const id) -> StringView& {
+            auto const [chunk, offset] = locate(id);
+
+            StringView* entries = m_chunks[chunk].load(std::memory_order_acquire);
+            if (!entries) {
+                // Writers of different shards may race to install the same chunk
+                StringView* const fresh = new StringView[Usize { 1 } << (first_chunk_bits + chunk)];
+                if (m_chunks[chunk].compare_exchange_strong(
+                    entries, fresh, std::memory_order_acq_rel))
+                    entries = fresh;
+                else
+                    delete[] fresh;
+            }
+            return entries[offset];
+        }
+
+        [[nodiscard]]
+        auto find_in(
+            dtl::InternerTable const& table,
+            std::uint64_t const       hash,
+            StringView const          string) const noexcept -> Option<Symbol>
+        {
+            auto const tag = static_cast<std::uint32_t>(hash >> 32);
+            Usize index = static_cast<Usize>(hash) & table.mask;
+            for (;; index = (index + 1) & table.mask) {
+                std::uint64_t const slot = table.slots[index].load(std::memory_order_acquire);
+                if (slot == 0)
+                    return nullopt;
+                if (static_cast<std::uint32_t>(slot >> 32) != tag)
+                    continue;
+                Symbol const symbol { static_cast<std::uint32_t>(slot) - 1 };
+                if (resolve(symbol) == string)
+                    return symbol;
+            }
+        }
+
+        static auto insert(
+            dtl::InternerTable& table,
+            std::uint64_t const hash,
+            std::uint32_t const id,
+            std::memory_order const order) noexcept -> void
+        {
+            std::uint64_t const slot = (hash >> 32 << 32) | (std::uint64_t { id } + 1);
+            Usize index = static_cast<Usize>(hash) & table.mask;
+            while (table.slots[index].load(std::memory_order_relaxed) != 0) {
+                index = (index + 1) & table.mask;
+            }
+            table.slots[index].store(slot, order);
+        }
+
+        // Rehashes the shard into a table twice the size and publishes it
+        // Precondition: the shard is locked
+        auto grow(dtl::InternerShard& shard) -> dtl::InternerTable* {
+            dtl::InternerTable const& old = *shard.table.load(std::memory_order_relaxed);
+            auto& table = *shard.tables.append(make_unique<dtl::InternerTable>((old.mask + 1) * 2));
+
+            for (Usize i = 0; i != old.mask + 1; ++i) {
+                std::uint64_t const slot = old.slots[i].load(std::memory_order_relaxed);
+                if (slot == 0)
+                    continue;
+                auto const id = static_cast<std::uint32_t>(slot) - 1;
+                insert(table, wyhash(resolve(Symbol { id })), id, std::memory_order_relaxed);
+            }
+            table.count = old.count;
+            shard.table.store(&table, std::memory_order_release);
+            return &table;
+        }
+    };
+
+
+    /* Description:
+     *     The symbol of `string` in `bu::Interner::global()`. The string is
+     *     interned by the first call, and later calls only check the
+     *     guard of a function-local static, like `Interner::global`. It
+     *     is safe to call from the static initializers of other
+     *     translation units, whose order relative to an inline variable
+     *     would be unspecified:
+     *
+     *         bu::Symbol const keyword = bu::static_symbol<"return">();
+     */
+    template <Metastring string>
+    [[nodiscard]]
+    auto static_symbol() -> Symbol {
+        static Symbol const symbol = Interner::global().intern(
+            StringView { string.string(), string.size() });
+        return symbol;
+    }
+}
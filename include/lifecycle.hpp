@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+
+#include "utility.hpp"
+#include "memory.hpp"
+
+
+namespace bu {
+    // The number of times each special member of a `bu::LifecycleCounter` ran
+    struct [[nodiscard]] LifecycleCounts {
+        Usize value_constructions   = 0;
+        Usize default_constructions = 0;
+        Usize copy_constructions    = 0;
+        Usize move_constructions    = 0;
+        Usize copy_assignments      = 0;
+        Usize move_assignments      = 0;
+        Usize destructions          = 0;
+
+        [[nodiscard]]
+        constexpr auto constructions() const noexcept -> Usize {
+            return value_constructions + default_constructions
+                 + copy_constructions  + move_constructions;
+        }
+        [[nodiscard]]
+        constexpr auto copies() const noexcept -> Usize {
+            return copy_constructions + copy_assignments;
+        }
+        [[nodiscard]]
+        constexpr auto moves() const noexcept -> Usize {
+            return move_constructions + move_assignments;
+        }
+        // The number of objects constructed but not yet destroyed
+        [[nodiscard]]
+        constexpr auto live() const noexcept -> Isize {
+            return static_cast<Isize>(constructions()) - static_cast<Isize>(destructions);
+        }
+
+        [[nodiscard]]
+        constexpr auto operator-(LifecycleCounts const& other) const noexcept -> LifecycleCounts {
+            return LifecycleCounts {
+                .value_constructions   = value_constructions   - other.value_constructions,
+                .default_constructions = default_constructions - other.default_constructions,
+                .copy_constructions    = copy_constructions    - other.copy_constructions,
+                .move_constructions    = move_constructions    - other.move_constructions,
+                .copy_assignments      = copy_assignments      - other.copy_assignments,
+                .move_assignments      = move_assignments      - other.move_assignments,
+                .destructions          = destructions          - other.destructions,
+            };
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(LifecycleCounts const&) const noexcept -> bool = default;
+    };
+
+
+    struct LifecycleConfig {
+        Usize size                  = sizeof(int);
+        Usize alignment             = alignof(int);
+        bool  atomic                = false; // Count in process-wide atomics, not thread-locals
+        bool  trivially_relocatable = false; // `bu::is_trivially_relocatable` for the counter
+    };
+
+
+    namespace dtl {
+        enum class LifecycleEvent : Usize {
+            value_construction,
+            default_construction,
+            copy_construction,
+            move_construction,
+            copy_assignment,
+            move_assignment,
+            destruction,
+            event_count
+        };
+
+        template <class Count>
+        struct LifecycleTally {
+            Count counts[static_cast<Usize>(LifecycleEvent::event_count)] {};
+
+            auto record(LifecycleEvent const event) noexcept -> void {
+                if constexpr (std::is_same_v<Count, Usize>)
+                    ++counts[static_cast<Usize>(event)];
+                else
+                    counts[static_cast<Usize>(event)].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            [[nodiscard]]
+            auto snapshot() const noexcept -> LifecycleCounts {
+                auto const get = [this](LifecycleEvent const event) -> Usize {
+                    return counts[static_cast<Usize>(event)];
+                };
+                return LifecycleCounts {
+                    .value_constructions   = get(LifecycleEvent::value_construction),
+                    .default_constructions = get(LifecycleEvent::default_construction),
+                    .copy_constructions    = get(LifecycleEvent::copy_construction),
+                    .move_constructions    = get(LifecycleEvent::move_construction),
+                    .copy_assignments      = get(LifecycleEvent::copy_assignment),
+                    .move_assignments      = get(LifecycleEvent::move_assignment),
+                    .destructions          = get(LifecycleEvent::destruction),
+                };
+            }
+        };
+
+        template <Usize size>
+        struct LifecyclePadding {
+            unsigned char bytes[size] {};
+        };
+        template <>
+        struct LifecyclePadding<0> {};
+    }
+
+
+    /* Description:
+     *     A probe type which counts how many times each of its special
+     *     members runs, so that tests and benchmarks can check how many
+     *     copies and moves an operation performs. Each instantiation
+     *     has its own counters, thread-local unless `config.atomic` is
+     *     set. Use a `bu::LifecycleScope` to count the events of one
+     *     operation.
+     *
+     *     The counter holds an `int`, by which it compares, and is
+     *     padded to `config.size` bytes.
+     */
+    template <LifecycleConfig config = LifecycleConfig {}>
+    class [[nodiscard]] LifecycleCounter {
+        static_assert(config.size >= sizeof(int) && config.size % config.alignment == 0);
+
+        alignas(config.alignment)
+        int m_value = 0;
+        [[no_unique_address]]
+        dtl::LifecyclePadding<config.size - sizeof(int)> m_padding;
+
+        static auto tally() noexcept -> auto& {
+            if constexpr (config.atomic) {
+                static dtl::LifecycleTally<std::atomic<Usize>> tally;
+                return tally;
+            }
+            else {
+                thread_local dtl::LifecycleTally<Usize> tally;
+                return tally;
+            }
+        }
+    public:
+        LifecycleCounter() noexcept {
+            tally().record(dtl::LifecycleEvent::default_construction);
+        }
+        explicit LifecycleCounter(int const value) noexcept
+            : m_value { value }
+        {
+            tally().record(dtl::LifecycleEvent::value_construction);
+        }
+        LifecycleCounter(LifecycleCounter const& other) noexcept
+            : m_value { other.m_value }
+        {
+            tally().record(dtl::LifecycleEvent::copy_construction);
+        }
+        LifecycleCounter(LifecycleCounter&& other) noexcept
+            : m_value { other.m_value }
+        {
+            tally().record(dtl::LifecycleEvent::move_construction);
+        }
+        auto operator=(LifecycleCounter const& other) noexcept -> LifecycleCounter& {
+            m_value = other.m_value;
+            tally().record(dtl::LifecycleEvent::copy_assignment);
+            return *this;
+        }
+        auto operator=(LifecycleCounter&& other) noexcept -> LifecycleCounter& {
+            m_value = other.m_value;
+            tally().record(dtl::LifecycleEvent::move_assignment);
+            return *this;
+        }
+        ~LifecycleCounter() {
+            tally().record(dtl::LifecycleEvent::destruction);
+        }
+
+        [[nodiscard]]
+        auto value() const noexcept -> int {
+            return m_value;
+        }
+
+        // The events counted so far, on this thread unless `config.atomic` is set
+        [[nodiscard]]
+        static auto counts() noexcept -> LifecycleCounts {
+            return tally().snapshot();
+        }
+
+        [[nodiscard]]
+        auto operator==(LifecycleCounter const& other) const noexcept -> bool {
+            return m_value == other.m_value;
+        }
+        [[nodiscard]]
+        auto operator<=>(LifecycleCounter const& other) const noexcept -> std::strong_ordering {
+            return m_value <=> other.m_value;
+        }
+    };
+
+    template <LifecycleConfig config>
+    constexpr bool is_trivially_relocatable<LifecycleCounter<config>> =
+        config.trivially_relocatable;
+
+
+    /* Description:
+     *     Snapshots the counts of `Counter` on construction, so that
+     *     `counts` returns the events since then:
+     *
+     *         bu::LifecycleScope scope;
+     *         vector.reserve(vector.capacity() * 2);
+     *         assert(scope.counts().copies() == 0);
+     */
+    template <class Counter = LifecycleCounter<>>
+    class [[nodiscard]] LifecycleScope {
+        LifecycleCounts m_start = Counter::counts();
+    public:
+        [[nodiscard]]
+        auto counts() const noexcept -> LifecycleCounts {
+            return Counter::counts() - m_start;
+        }
+
+        // Restarts counting from the current counts
+        auto reset() noexcept -> void {
+            m_start = Counter::counts();
+        }
+    };
+}
@@ -4,6 +4,7 @@
 #include "concepts.hpp"
 #include "allocator.hpp"
 #include "exception.hpp"
+#include "perf_fwd.hpp"
 
 
 namespace bu {
@@ -413,6 +414,8 @@ namespace bu {
             noexcept(std::is_nothrow_constructible_v<T, Args&&...>
                 && nothrow_alloc<A>) -> Node*
         {
+            [[maybe_unused]]
+            perf::Scope<"bu::List::make_node", perf::hooks_enabled> const probe;
             Node* const node = m_allocator.allocate(1);
             try {
                 return std::construct_at(node, std::forward<Args>(args)...);
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "memory.hpp"
+#include "span.hpp"
+
+
+namespace bu {
+    class [[nodiscard]] MappedFileError : public Exception {
+        char const* m_message;
+        int         m_error_code;
+    public:
+        constexpr MappedFileError(char const* const msg, int const error_code) noexcept
+            : m_message    { msg }
+            , m_error_code { error_code } {}
+        constexpr auto message() const noexcept -> char const* override {
+            return m_message;
+        }
+        // The `errno` value reported by the failing system call
+        [[nodiscard]]
+        constexpr auto error_code() const noexcept -> int {
+            return m_error_code;
+        }
+    };
+
+    enum class MapAccess {
+        read_only,
+        read_write,
+    };
+
+    enum class MapAdvice {
+        normal,
+        sequential,
+        random,
+        will_need,
+    };
+
+    struct MapOptions {
+        MapAccess access     = MapAccess::read_only;
+        MapAdvice advice     = MapAdvice::normal;
+        bool      prefault   = false; // Populate the page tables up front (MAP_POPULATE)
+        bool      huge_pages = false; // Request transparent huge pages (MADV_HUGEPAGE)
+    };
+}
+
+
+namespace bu::dtl {
+    struct [[nodiscard]] Unmapper {
+        Usize length = 0;
+
+        auto operator()(std::byte* const ptr) const noexcept -> void {
+            ::munmap(ptr, length);
+        }
+    };
+
+    [[nodiscard]]
+    constexpr auto madvise_flag(MapAdvice const advice) noexcept -> int {
+        switch (advice) {
+        case MapAdvice::normal:     return MADV_NORMAL;
+        case MapAdvice::sequential: return MADV_SEQUENTIAL;
+        case MapAdvice::random:     return MADV_RANDOM;
+        case MapAdvice::will_need:  return MADV_WILLNEED;
+        default:
+            BU unreachable();
+        }
+    }
+
+    class [[nodiscard]] FileDescriptor {
+        int m_fd;
+    public:
+        explicit FileDescriptor(int const fd) noexcept
+            : m_fd { fd } {}
+        FileDescriptor(FileDescriptor const&) = delete;
+        auto operator=(FileDescriptor const&) -> FileDescriptor& = delete;
+        ~FileDescriptor() {
+            if (m_fd != -1)
+                ::close(m_fd);
+        }
+        [[nodiscard]]
+        auto get() const noexcept -> int {
+            return m_fd;
+        }
+    };
+}
+
+
+namespace bu {
+    /* Description:
+     *     Maps a file into memory and exposes its contents as a span.
+     *     The mapping is shared, so several processes mapping the same
+     *     file share the same physical pages through the page cache,
+     *     and with `MapAccess::read_write` stores are written back to
+     *     the file.
+     *
+     * Exceptions:
+     *     The constructor throws `bu::MappedFileError` if the file can
+     *     not be opened, inspected, or mapped.
+     */
+    class [[nodiscard]] MappedFile {
+        UniquePtr<std::byte[], dtl::Unmapper> m_mapping;
+        MapAccess                             m_access = MapAccess::read_only;
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(char const* const path, MapOptions const options = {})
+            : m_access { options.access }
+        {
+            bool const writable   = options.access == MapAccess::read_write;
+            int  const open_flags = (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC;
+
+            dtl::FileDescriptor const file { ::open(path, open_flags) };
+            if (file.get() == -1)
+                throw MappedFileError { "could not open file", errno };
+
+            struct ::stat status {};
+            if (::fstat(file.get(), &status) == -1)
+                throw MappedFileError { "could not stat file", errno };
+
+            auto const length = static_cast<Usize>(status.st_size);
+            if (!length)
+                return; // Zero-length mappings are not permitted, leave this empty
+
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (options.prefault)
+                flags |= MAP_POPULATE;
+#endif
+            void* const address = ::mmap(
+                nullptr,
+                length,
+                writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                flags,
+                file.get(),
+                0
+            );
+            if (address == MAP_FAILED)
+                throw MappedFileError { "could not map file", errno };
+
+            m_mapping = UniquePtr<std::byte[], dtl::Unmapper> {
+                FromOwning { static_cast<std::byte*>(address) },
+                dtl::Unmapper { length }
+            };
+
+            advise(options.advice);
+#ifdef MADV_HUGEPAGE
+            if (options.huge_pages) // Only a hint, failure is not an error
+                (void)::madvise(address, length, MADV_HUGEPAGE);
+#endif
+        }
+
+        // Hints the expected access pattern to the kernel's readahead logic
+        auto advise(MapAdvice const advice) const noexcept -> void {
+            if (m_mapping)
+                (void)::madvise(m_mapping.get(), size(), dtl::madvise_flag(advice));
+        }
+
+        // Synchronously writes modified pages back to the file
+        auto flush() const -> void {
+            if (m_mapping && ::msync(m_mapping.get(), size(), MS_SYNC) == -1)
+                throw MappedFileError { "could not flush mapping", errno };
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_mapping ? m_mapping.deleter().length : 0;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return !m_mapping;
+        }
+        [[nodiscard]]
+        auto is_writable() const noexcept -> bool {
+            return m_access == MapAccess::read_write;
+        }
+
+        [[nodiscard]]
+        auto bytes() const noexcept -> Span<std::byte const> {
+            return Span<std::byte const> { m_mapping.get(), size() };
+        }
+        [[nodiscard]]
+        auto mutable_bytes() const -> Span<std::byte> {
+            if (!is_writable())
+                throw MappedFileError { "mapping is read-only", EACCES };
+            return Span<std::byte> { m_mapping.get(), size() };
+        }
+
+        /* Description:
+         *     Views the mapping as a span of `T`. The mapping is
+         *     page-aligned, so any `T` with fundamental alignment is
+         *     suitably aligned.
+         *
+         * Exceptions:
+         *     Throws `bu::BadSlice` if the size of the file is not a
+         *     multiple of `sizeof(T)`.
+         */
+        template <class T> [[nodiscard]]
+        auto as_span() const -> Span<T const>
+            requires std::is_trivially_copyable_v<T>
+        {
+            if (size() % sizeof(T) != 0)
+                throw BadSlice {};
+            auto const* const elements = reinterpret_cast<T const*>(m_mapping.get());
+            return Span<T const> { elements, size() / sizeof(T) };
+        }
+        template <class T> [[nodiscard]]
+        auto as_mutable_span() const -> Span<T>
+            requires std::is_trivially_copyable_v<T>
+        {
+            Span<std::byte> const bytes = mutable_bytes();
+            if (bytes.size() % sizeof(T) != 0)
+                throw BadSlice {};
+            return Span<T> { reinterpret_cast<T*>(bytes.data()), bytes.size() / sizeof(T) };
+        }
+    };
+}
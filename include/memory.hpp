@@ -2,6 +2,8 @@
 
 #include "utility.hpp"
 #include "concepts.hpp"
+#include "option.hpp"
+#include "allocator.hpp"
 
 
 namespace bu {
@@ -15,19 +17,293 @@ namespace bu {
     constexpr auto destroy(It begin, Se end)
         noexcept(noexcept(destroy(*begin))) -> void
     {
-        for (; begin != end; ++begin) {
-            destroy(*begin);
+        using Element = std::remove_reference_t<decltype(*begin)>;
+        if constexpr (!std::is_trivially_destructible_v<Element>) {
+            for (; begin != end; ++begin) {
+                destroy(*begin);
+            }
+        }
+    }
+
+
+    // Whether moving a `T` and destroying the source has the same effect as copying its
+    // bytes. Types may opt in by specializing this.
+    template <class T>
+    constexpr bool is_trivially_relocatable = std::is_trivially_copyable_v<T>;
+
+
+    namespace dtl {
+        template <class It>
+        using IteratedType = std::remove_cvref_t<decltype(*std::declval<It>())>;
+
+        /* Description:
+         *     Whether copying `[first, last)` to `out` may be done as one
+         *     copy of bytes: both sides are contiguous, and the elements
+         *     are of one trivially copyable type.
+         */
+        template <class It, class Se, class Out>
+        constexpr bool is_bytewise_copy = contiguous_iterator<It>
+                                       && contiguous_iterator<Out>
+                                       && std::same_as<It, Se>
+                                       && std::same_as<IteratedType<It>, IteratedType<Out>>
+                                       && std::is_trivially_copyable_v<IteratedType<Out>>;
+
+        // Whether filling `[first, last)` with a `T` whose bytes are all equal may use `memset`
+        template <class It, class Se, class T>
+        constexpr bool is_bytewise_fill = contiguous_iterator<It>
+                                       && std::same_as<It, Se>
+                                       && std::same_as<IteratedType<It>, T>
+                                       && std::is_trivially_copyable_v<T>;
+
+        template <class It, class Out>
+        auto copy_bytes(It const first, It const last, Out const out) noexcept -> Out {
+            auto const count = static_cast<Usize>(last - first);
+            if (count) {
+                Usize const bytes = count * sizeof(IteratedType<Out>);
+                std::memmove(std::to_address(out), std::to_address(first), bytes);
+            }
+            return out + static_cast<std::ptrdiff_t>(count);
+        }
+    }
+
+    /* Description:
+     *     Copy-constructs the elements of `[first, last)` into the
+     *     uninitialized storage at `out`. Contiguous ranges of trivially
+     *     copyable elements are copied with one `memmove`.
+     *
+     * Return value:
+     *     An iterator past the last constructed element.
+     *
+     * Exceptions:
+     *     If a constructor throws, the elements constructed so far are
+     *     destroyed before the exception is propagated.
+     */
+    template <iterator It, sentinel_for<It> Se, iterator Out>
+    constexpr auto uninitialized_copy(It first, Se const last, Out out) -> Out {
+        if constexpr (dtl::is_bytewise_copy<It, Se, Out>) {
+            if (!std::is_constant_evaluated())
+                return dtl::copy_bytes(first, last, out);
+        }
+        Out const start = out;
+        try {
+            for (; first != last; ++first, ++out) {
+                std::construct_at(std::addressof(*out), *first);
+            }
+        }
+        catch (...) {
+            destroy(start, out);
+            throw;
+        }
+        return out;
+    }
+
+    // Like `bu::uninitialized_copy`, but move-constructs from the source elements
+    template <iterator It, sentinel_for<It> Se, iterator Out>
+    constexpr auto uninitialized_move(It first, Se const last, Out out) -> Out {
+        if constexpr (dtl::is_bytewise_copy<It, Se, Out>) {
+            if (!std::is_constant_evaluated())
+                return dtl::copy_bytes(first, last, out);
+        }
+        Out const start = out;
+        try {
+            for (; first != last; ++first, ++out) {
+                std::construct_at(std::addressof(*out), std::move(*first));
+            }
+        }
+        catch (...) {
+            destroy(start, out);
+            throw;
+        }
+        return out;
+    }
+
+    /* Description:
+     *     Moves the elements of `[first, last)` into the uninitialized
+     *     storage at `out` and destroys the originals, leaving the
+     *     source uninitialized. Trivially relocatable elements, see
+     *     `bu::is_trivially_relocatable`, are relocated with one
+     *     `memcpy`, without invoking constructors or destructors.
+     */
+    template <class T>
+    constexpr auto uninitialized_relocate(T* first, T* const last, T* out) noexcept -> T*
+        requires is_trivially_relocatable<T> || std::is_nothrow_move_constructible_v<T>
+    {
+        if constexpr (is_trivially_relocatable<T>) {
+            if (!std::is_constant_evaluated()) {
+                auto const count = unsigned_distance(first, last);
+                if (count) {
+                    Usize const bytes = count * sizeof(T);
+                    std::memcpy(static_cast<void*>(out), static_cast<void const*>(first), bytes);
+                }
+                return out + count;
+            }
+        }
+        for (; first != last; ++first, ++out) {
+            std::construct_at(out, std::move(*first));
+            destroy(*first);
+        }
+        return out;
+    }
+
+    /* Description:
+     *     Value-initializes the uninitialized storage `[first, last)`.
+     *     Arithmetic, enumeration and pointer types, whose value
+     *     initialization is all zero bytes, are zeroed with one
+     *     `memset`.
+     */
+    template <class T>
+    constexpr auto uninitialized_value_construct(T* first, T* const last)
+        noexcept(std::is_nothrow_default_constructible_v<T>) -> void
+    {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                if (first != last) {
+                    Usize const bytes = unsigned_distance(first, last) * sizeof(T);
+                    std::memset(static_cast<void*>(first), 0, bytes);
+                }
+                return;
+            }
+        }
+        T* const start = first;
+        if constexpr (std::is_nothrow_default_constructible_v<T>) {
+            for (; first != last; ++first) {
+                std::construct_at(first);
+            }
+        }
+        else {
+            try {
+                for (; first != last; ++first) {
+                    std::construct_at(first);
+                }
+            }
+            catch (...) {
+                destroy(start, first);
+                throw;
+            }
+        }
+    }
+
+    namespace dtl {
+        // The byte which every byte of `value` equals, if there is one
+        template <class T>
+        auto repeated_byte(T const& value) noexcept -> Option<unsigned char> {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, std::addressof(value), sizeof(T));
+            for (Usize i = 1; i != sizeof(T); ++i) {
+                if (bytes[i] != bytes[0])
+                    return nullopt;
+            }
+            return bytes[0];
+        }
+    }
+
+    /* Description:
+     *     Assigns `value` to every element of `[first, last)`. When the
+     *     elements are contiguous and every byte of `value` is the same,
+     *     as for any single-byte type and for zero, the range is filled
+     *     with one `memset`.
+     */
+    template <iterator It, sentinel_for<It> Se, class T>
+    constexpr auto fill(It first, Se const last, T const& value) -> void {
+        if constexpr (dtl::is_bytewise_fill<It, Se, T>) {
+            if (!std::is_constant_evaluated()) {
+                if (Option<unsigned char> const byte = dtl::repeated_byte(value)) {
+                    if (first != last) {
+                        Usize const bytes = sizeof(T) * static_cast<Usize>(last - first);
+                        std::memset(std::to_address(first), byte.value(), bytes);
+                    }
+                    return;
+                }
+            }
+        }
+        for (; first != last; ++first) {
+            *first = value;
+        }
+    }
+
+    /* Description:
+     *     Like `bu::fill`, but copy-constructs into uninitialized
+     *     storage. If a constructor throws, the elements constructed so
+     *     far are destroyed before the exception is propagated.
+     */
+    template <iterator It, sentinel_for<It> Se, class T>
+    constexpr auto uninitialized_fill(It first, Se const last, T const& value) -> void {
+        if constexpr (dtl::is_bytewise_fill<It, Se, T>) {
+            if (!std::is_constant_evaluated()) {
+                fill(first, last, value);
+                return;
+            }
+        }
+        It const start = first;
+        try {
+            for (; first != last; ++first) {
+                std::construct_at(std::addressof(*first), value);
+            }
+        }
+        catch (...) {
+            destroy(start, first);
+            throw;
         }
     }
 
 
     template <class T>
     struct [[nodiscard]] DefaultDeleter {
-        constexpr auto operator()(std::remove_extent_t<T>* const ptr) const -> void {
+        constexpr auto operator()(std::remove_extent_t<T>* const ptr) const noexcept -> void {
             std::is_array_v<T> ? delete[] ptr : delete ptr;
         }
     };
 
+    /* Description:
+     *     Destroys and deallocates through an allocator, for objects
+     *     created by `bu::allocate_unique`. Stateless allocators take no
+     *     space, so a `bu::UniquePtr` to a single object stays pointer
+     *     sized. An array deleter additionally stores the extent, which
+     *     the allocator needs back on deallocation.
+     */
+    template <class T, allocator_for<std::remove_extent_t<T>> A>
+    class [[nodiscard]] AllocatorDeleter {
+        struct NoExtent {};
+        using Extent = std::conditional_t<std::is_unbounded_array_v<T>, Usize, NoExtent>;
+
+        [[no_unique_address]]
+        mutable A m_allocator; // Deallocation may update the state of a stateful allocator
+        [[no_unique_address]]
+        Extent    m_extent {};
+    public:
+        AllocatorDeleter() = default;
+
+        constexpr explicit AllocatorDeleter(A allocator)
+            noexcept(std::is_nothrow_move_constructible_v<A>)
+            requires (!std::is_array_v<T>)
+            : m_allocator { std::move(allocator) } {}
+
+        constexpr AllocatorDeleter(A allocator, Usize const extent)
+            noexcept(std::is_nothrow_move_constructible_v<A>)
+            requires std::is_unbounded_array_v<T>
+            : m_allocator { std::move(allocator) }
+            , m_extent    { extent } {}
+
+        constexpr auto operator()(std::remove_extent_t<T>* const ptr) const
+            noexcept(std::is_nothrow_destructible_v<std::remove_extent_t<T>>
+                  && nothrow_dealloc<A>) -> void
+        {
+            if constexpr (std::is_unbounded_array_v<T>) {
+                BU destroy(ptr, ptr + m_extent);
+                m_allocator.deallocate(ptr, m_extent);
+            }
+            else {
+                BU destroy(*ptr);
+                m_allocator.deallocate(ptr, 1);
+            }
+        }
+
+        [[nodiscard]]
+        constexpr auto allocator() const noexcept -> A const& {
+            return m_allocator;
+        }
+    };
+
     // Could be an aggregate, but clangd erroneously complained
     template <class Pointer>
         requires std::is_pointer_v<Pointer>
@@ -55,6 +331,11 @@ namespace bu {
             noexcept(std::is_nothrow_default_constructible_v<Deleter>)
             : m_pointer { owning.pointer } {}
 
+        constexpr UniquePtr(FromOwning<Pointer> const owning, Deleter deleter)
+            noexcept(std::is_nothrow_move_constructible_v<Deleter>)
+            : m_deleter { std::move(deleter) }
+            , m_pointer { owning.pointer } {}
+
         constexpr UniquePtr     (UniquePtr const&)               = delete;
         constexpr auto operator=(UniquePtr const&) -> UniquePtr& = delete;
 
@@ -121,6 +402,10 @@ namespace bu {
             return m_pointer;
         }
         [[nodiscard]]
+        constexpr auto deleter() const noexcept -> Deleter const& {
+            return m_deleter;
+        }
+        [[nodiscard]]
         constexpr auto operator[](Usize const index) const
             noexcept -> std::remove_extent_t<T>&
             requires std::is_unbounded_array_v<T>
@@ -187,4 +472,109 @@ namespace bu {
     {
         return FromOwning { new std::remove_extent_t<T>[extent] {} };
     }
+
+    // Like `bu::make_unique`, but default-initializes, so trivial types and array elements
+    // are left uninitialized
+    template <class T>
+    constexpr auto make_unique_for_overwrite() -> UniquePtr<T>
+        requires (!std::is_array_v<T>)
+    {
+        return FromOwning { new T };
+    }
+    template <class T>
+    constexpr auto make_unique_for_overwrite(Usize const extent) -> UniquePtr<T>
+        requires std::is_unbounded_array_v<T>
+    {
+        return FromOwning { new std::remove_extent_t<T>[extent] };
+    }
+
+
+    namespace dtl {
+        // Constructs `extent` elements with `construct`, destroying the constructed ones and
+        // deallocating if it throws
+        template <class T, class A, class F>
+        constexpr auto allocate_array(A& allocator, Usize const extent, F const construct) -> T* {
+            T* const ptr = allocator.allocate(extent);
+            Usize i = 0;
+            try {
+                for (; i != extent; ++i) {
+                    construct(ptr + i);
+                }
+            }
+            catch (...) {
+                BU destroy(ptr, ptr + i);
+                allocator.deallocate(ptr, extent);
+                throw;
+            }
+            return ptr;
+        }
+    }
+
+    /* Description:
+     *     Like `bu::make_unique`, but obtains the memory from `allocator`
+     *     and returns a `bu::UniquePtr` whose deleter gives it back:
+     *
+     *         auto message = bu::allocate_unique<Message>(pool_allocator, header);
+     *
+     * Exceptions:
+     *     Propagates exceptions from the allocator and the constructor,
+     *     in which case nothing is leaked.
+     */
+    template <class T, allocator_for<T> A, class... Args>
+    constexpr auto allocate_unique(A allocator, Args&&... args)
+        -> UniquePtr<T, AllocatorDeleter<T, A>>
+        requires std::is_constructible_v<T, Args&&...>
+              && (!std::is_array_v<T>)
+    {
+        T* const ptr = allocator.allocate(1);
+        try {
+            std::construct_at(ptr, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            allocator.deallocate(ptr, 1);
+            throw;
+        }
+        return { FromOwning { ptr }, AllocatorDeleter<T, A> { std::move(allocator) } };
+    }
+    // Value-initializes `extent` elements
+    template <class T, allocator_for<std::remove_extent_t<T>> A>
+    constexpr auto allocate_unique(A allocator, Usize const extent)
+        -> UniquePtr<T, AllocatorDeleter<T, A>>
+        requires std::is_unbounded_array_v<T>
+    {
+        using U = std::remove_extent_t<T>;
+        U* const ptr = dtl::allocate_array<U>(allocator, extent, [](U* const element) {
+            ::new (static_cast<void*>(element)) U();
+        });
+        return { FromOwning { ptr }, AllocatorDeleter<T, A> { std::move(allocator), extent } };
+    }
+
+    // Like `bu::allocate_unique`, but default-initializes, so trivial types and array
+    // elements are left uninitialized
+    template <class T, allocator_for<T> A>
+    constexpr auto allocate_unique_for_overwrite(A allocator)
+        -> UniquePtr<T, AllocatorDeleter<T, A>>
+        requires (!std::is_array_v<T>)
+    {
+        T* const ptr = allocator.allocate(1);
+        try {
+            ::new (static_cast<void*>(ptr)) T;
+        }
+        catch (...) {
+            allocator.deallocate(ptr, 1);
+            throw;
+        }
+        return { FromOwning { ptr }, AllocatorDeleter<T, A> { std::move(allocator) } };
+    }
+    template <class T, allocator_for<std::remove_extent_t<T>> A>
+    constexpr auto allocate_unique_for_overwrite(A allocator, Usize const extent)
+        -> UniquePtr<T, AllocatorDeleter<T, A>>
+        requires std::is_unbounded_array_v<T>
+    {
+        using U = std::remove_extent_t<T>;
+        U* const ptr = dtl::allocate_array<U>(allocator, extent, [](U* const element) {
+            ::new (static_cast<void*>(element)) U;
+        });
+        return { FromOwning { ptr }, AllocatorDeleter<T, A> { std::move(allocator), extent } };
+    }
 }
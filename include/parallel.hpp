@@ -0,0 +1,528 @@
+#pragma once
+
+#include <algorithm>
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+#include "thread_pool.hpp"
+
+
+namespace bu::dtl {
+    /* Adaptive splitting, as in Rayon: a range is split while the split
+     * budget lasts, halving the budget at each level. When a half is
+     * stolen by another worker the budget is replenished, so ranges are
+     * only split further where there are idle threads to take them.
+     */
+    struct [[nodiscard]] ParallelSplitter {
+        Usize splits;
+        Usize min_length;
+
+        [[nodiscard]]
+        constexpr auto try_split(Usize const length, bool const stolen, Usize const thread_count)
+            noexcept -> bool
+        {
+            if (length < 2 * min_length)
+                return false;
+            if (stolen) {
+                splits = std::max(splits / 2, thread_count);
+                return true;
+            }
+            if (splits == 0)
+                return false;
+            splits /= 2;
+            return true;
+        }
+    };
+
+    template <class Body>
+    auto parallel_bridge(
+        ThreadPool&      pool,
+        Usize      const begin,
+        Usize      const end,
+        ParallelSplitter splitter,
+        bool       const stolen,
+        Body&            body) -> void
+    {
+        if (!splitter.try_split(end - begin, stolen, pool.thread_count())) {
+            body(begin, end);
+            return;
+        }
+        Usize const middle = begin + (end - begin) / 2;
+        Usize const parent = pool.current_worker_index().value();
+        pool.join(
+            [&] { parallel_bridge(pool, begin, middle, splitter, false, body); },
+            [&] {
+                bool const migrated = pool.current_worker_index().value() != parent;
+                parallel_bridge(pool, middle, end, splitter, migrated, body);
+            });
+    }
+
+    /* Description:
+     *     Invokes `body(begin, end)` over disjoint subranges covering
+     *     `[0, length)`. When called from outside of the pool, the range
+     *     is first divided into one contiguous block per worker and block
+     *     `i` always starts on worker `i`. Passes over equally sized data
+     *     therefore touch the same pages from the same threads, which
+     *     keeps pages on the NUMA node of the worker that first touched
+     *     them. Work stealing balances the blocks from there.
+     */
+    template <class Body>
+    auto parallel_for_range(
+        ThreadPool&  pool,
+        Usize const  length,
+        Usize const  min_length,
+        Body&&       body) -> void
+    {
+        if (length == 0)
+            return;
+        Usize const threads = pool.thread_count();
+        if (threads == 1 || length < 2 * min_length) {
+            body(Usize { 0 }, length);
+            return;
+        }
+        ParallelSplitter const splitter { threads, min_length };
+        if (pool.current_worker_index()) {
+            parallel_bridge(pool, 0, length, splitter, false, body);
+            return;
+        }
+        pool.broadcast([&](Usize const worker) {
+            Usize const begin = length * worker / threads;
+            Usize const end   = length * (worker + 1) / threads;
+            if (begin != end)
+                parallel_bridge(pool, begin, end, splitter, false, body);
+        });
+    }
+
+    template <class T, class Leaf, class Combine>
+    auto parallel_reduce_bridge(
+        ThreadPool&      pool,
+        Usize      const begin,
+        Usize      const end,
+        ParallelSplitter splitter,
+        bool       const stolen,
+        Leaf&            leaf,
+        Combine&         combine) -> T
+    {
+        if (!splitter.try_split(end - begin, stolen, pool.thread_count()))
+            return leaf(begin, end);
+
+        Usize const middle = begin + (end - begin) / 2;
+        Usize const parent = pool.current_worker_index().value();
+        Option<T> left;
+        Option<T> right;
+        pool.join(
+            [&] {
+                left = Option<T> { in_place, parallel_reduce_bridge<T>(
+                    pool, begin, middle, splitter, false, leaf, combine) };
+            },
+            [&] {
+                bool const migrated = pool.current_worker_index().value() != parent;
+                right = Option<T> { in_place, parallel_reduce_bridge<T>(
+                    pool, middle, end, splitter, migrated, leaf, combine) };
+            });
+        return combine(std::move(left.value()), std::move(right.value()));
+    }
+
+    // Reduces `leaf(begin, end)` of non-empty subranges of `[0, length)` with `combine`, in order
+    template <class T, class Leaf, class Combine>
+    auto parallel_reduce_range(
+        ThreadPool&  pool,
+        Usize const  length,
+        Leaf&&       leaf,
+        Combine&&    combine) -> T
+    {
+        assert(length != 0);
+        Usize const threads = pool.thread_count();
+        if (threads == 1 || length < 2) {
+            return leaf(Usize { 0 }, length);
+        }
+        ParallelSplitter const splitter { threads, 1 };
+        if (pool.current_worker_index()) {
+            return parallel_reduce_bridge<T>(pool, 0, length, splitter, false, leaf, combine);
+        }
+        Vector<Option<T>> partials { threads };
+        pool.broadcast([&](Usize const worker) {
+            Usize const begin = length * worker / threads;
+            Usize const end   = length * (worker + 1) / threads;
+            if (begin != end) {
+                partials[worker] = Option<T> { in_place, parallel_reduce_bridge<T>(
+                    pool, begin, end, splitter, false, leaf, combine) };
+            }
+        });
+        // Some blocks are empty if `length < threads`, but at least one is not
+        Usize first = 0;
+        while (!partials[first]) {
+            ++first;
+        }
+        T result = std::move(partials[first].value());
+        for (Usize i = first + 1; i != threads; ++i) {
+            if (partials[i])
+                result = combine(std::move(result), std::move(partials[i].value()));
+        }
+        return result;
+    }
+
+    // Number of blocks used by the multi-pass algorithms
+    [[nodiscard]]
+    inline auto parallel_block_count(
+        ThreadPool const& pool,
+        Usize      const  length,
+        Usize      const  min_block) noexcept -> Usize
+    {
+        Usize const by_size = length / min_block;
+        Usize const wanted  = pool.thread_count() * 4;
+        return std::max<Usize>(1, std::min(by_size, wanted));
+    }
+
+    inline constexpr Usize parallel_sort_cutoff      = 2048;
+    inline constexpr Usize parallel_partition_cutoff = 4096;
+    inline constexpr Usize parallel_scan_cutoff      = 4096;
+
+    template <class T, class Compare>
+    auto parallel_quicksort(
+        ThreadPool& pool,
+        T*          first,
+        T*          last,
+        Compare&    compare,
+        Usize       depth_budget) -> void
+    {
+        while (static_cast<Usize>(last - first) > parallel_sort_cutoff && depth_budget != 0) {
+            --depth_budget;
+
+            // Median of three moved to the front, then a three-way partition around it
+            T* const middle = first + (last - first) / 2;
+            T* const back   = last - 1;
+            if (compare(*middle, *first)) BU swap(*middle, *first);
+            if (compare(*back,   *first)) BU swap(*back,   *first);
+            if (compare(*back,  *middle)) BU swap(*back,  *middle);
+            BU swap(*first, *middle);
+
+            T const& pivot = *first;
+            T* const less_end  = std::partition(first + 1, last,
+                [&](T const& x) { return compare(x, pivot); });
+            T* const equal_end = std::partition(less_end, last,
+                [&](T const& x) { return !compare(pivot, x); });
+
+            // Move the pivot to the end of the less-than run
+            if (less_end - 1 != first)
+                BU swap(*first, *(less_end - 1));
+
+            T* const left_last   = less_end - 1;
+            T* const right_first = equal_end;
+            pool.join(
+                [&] { parallel_quicksort(pool, first, left_last, compare, depth_budget); },
+                [&] { parallel_quicksort(pool, right_first, last, compare, depth_budget); });
+            return;
+        }
+        std::sort(first, last, compare);
+    }
+
+    struct PartitionRun {
+        Usize start;  // Index of the first element of the run
+        Usize offset; // Sum of the lengths of the preceding runs
+        Usize length;
+    };
+
+    // Collects `[begin, end) ∩ [lower, upper)` into `runs`
+    inline auto append_partition_run(
+        Vector<PartitionRun>& runs,
+        Usize&                total,
+        Usize const           begin,
+        Usize const           end,
+        Usize const           lower,
+        Usize const           upper) -> void
+    {
+        Usize const start = std::max(begin, lower);
+        Usize const stop  = std::min(end, upper);
+        if (start < stop) {
+            runs.append(PartitionRun { start, total, stop - start });
+            total += stop - start;
+        }
+    }
+
+    [[nodiscard]]
+    inline auto find_partition_run(Vector<PartitionRun> const& runs, Usize const offset)
+        noexcept -> Usize
+    {
+        auto const it = std::upper_bound(runs.begin(), runs.end(), offset,
+            [](Usize const value, PartitionRun const& run) { return value < run.offset; });
+        return static_cast<Usize>(it - runs.begin()) - 1;
+    }
+}
+
+
+namespace bu::parallel {
+    template <class T, std::invocable<T&> F>
+    auto for_each(ThreadPool& pool, Span<T> const elements, F&& function) -> void {
+        dtl::parallel_for_range(pool, elements.size(), 1, [&](Usize const begin, Usize const end) {
+            for (Usize i = begin; i != end; ++i) {
+                std::invoke(function, elements.data()[i]);
+            }
+        });
+    }
+
+    /* Description:
+     *     Stores `function(input[i])` into `output[i]` for every `i`.
+     *
+     * Exceptions:
+     *     Throws `bu::OutOfRange` if `output` is shorter than `input`.
+     */
+    template <class T, class U, std::invocable<T&> F>
+        requires std::is_assignable_v<U&, std::invoke_result_t<F&, T&>>
+    auto transform(
+        ThreadPool&   pool,
+        Span<T> const input,
+        Span<U> const output,
+        F&&           function) -> void
+    {
+        if (output.size() < input.size())
+            throw OutOfRange {};
+        dtl::parallel_for_range(pool, input.size(), 1, [&](Usize const begin, Usize const end) {
+            for (Usize i = begin; i != end; ++i) {
+                output.data()[i] = std::invoke(function, input.data()[i]);
+            }
+        });
+    }
+
+    // Writes `value` to every element, see `bu::dtl::parallel_for_range` on first-touch placement
+    template <class T>
+    auto fill(ThreadPool& pool, Span<T> const elements, T const& value) -> void {
+        dtl::parallel_for_range(pool, elements.size(), 1, [&](Usize const begin, Usize const end) {
+            std::fill(elements.data() + begin, elements.data() + end, value);
+        });
+    }
+
+    /* Description:
+     *     Combines `init` with every element using `operation`, which
+     *     must be associative. Elements are combined in order, but the
+     *     grouping is unspecified.
+     */
+    template <class T, class Operation = std::plus<>>
+        requires std::is_convertible_v<
+            std::invoke_result_t<Operation&, std::remove_const_t<T>, T&>, std::remove_const_t<T>>
+    [[nodiscard]]
+    auto reduce(
+        ThreadPool&                 pool,
+        Span<T>               const elements,
+        std::remove_const_t<T>      init,
+        Operation                   operation = {}) -> std::remove_const_t<T>
+    {
+        using Value = std::remove_const_t<T>;
+        if (elements.is_empty())
+            return init;
+
+        Value total = dtl::parallel_reduce_range<Value>(pool, elements.size(),
+            [&](Usize const begin, Usize const end) {
+                Value accumulator = elements.data()[begin];
+                for (Usize i = begin + 1; i != end; ++i) {
+                    accumulator = std::invoke(
+                        operation, std::move(accumulator), elements.data()[i]);
+                }
+                return accumulator;
+            },
+            [&](Value a, Value b) -> Value {
+                return std::invoke(operation, std::move(a), std::move(b));
+            });
+        return std::invoke(operation, std::move(init), std::move(total));
+    }
+
+    /* Description:
+     *     Stores the inclusive prefix combination of `input` under the
+     *     associative `operation` into `output`, which may be `input`
+     *     itself. Runs in two parallel passes over the data: one
+     *     reducing each block, and one scanning each block seeded with
+     *     the combination of the preceding blocks.
+     *
+     * Exceptions:
+     *     Throws `bu::OutOfRange` if `output` is shorter than `input`.
+     */
+    template <class T, class U, class Operation = std::plus<>>
+    auto inclusive_scan(
+        ThreadPool&   pool,
+        Span<T> const input,
+        Span<U> const output,
+        Operation     operation = {}) -> void
+    {
+        if (output.size() < input.size())
+            throw OutOfRange {};
+
+        Usize const length = input.size();
+        auto const scan_block = [&](Usize const begin, Usize const end, Option<U> carry) {
+            for (Usize i = begin; i != end; ++i) {
+                if (carry)
+                    carry = Option<U> { in_place,
+                        std::invoke(operation, std::move(carry.value()), input.data()[i]) };
+                else
+                    carry = Option<U> { in_place, input.data()[i] };
+                output.data()[i] = carry.value();
+            }
+        };
+
+        if (pool.thread_count() == 1 || length < dtl::parallel_scan_cutoff) {
+            scan_block(0, length, nullopt);
+            return;
+        }
+
+        Usize const blocks = dtl::parallel_block_count(pool, length, dtl::parallel_scan_cutoff / 2);
+        auto const block_begin = [&](Usize const block) { return length * block / blocks; };
+
+        Vector<Option<U>> sums { blocks };
+        dtl::parallel_for_range(pool, blocks, 1, [&](Usize const first, Usize const last) {
+            for (Usize block = first; block != last; ++block) {
+                Usize const begin = block_begin(block);
+                Usize const end   = block_begin(block + 1);
+                U sum = input.data()[begin];
+                for (Usize i = begin + 1; i != end; ++i) {
+                    sum = std::invoke(operation, std::move(sum), input.data()[i]);
+                }
+                sums[block] = Option<U> { in_place, std::move(sum) };
+            }
+        });
+
+        // Exclusive prefix of the block sums, serially, there are only a few
+        Vector<Option<U>> carries { blocks };
+        for (Usize block = 1; block != blocks; ++block) {
+            if (carries[block - 1])
+                carries[block] = Option<U> { in_place,
+                    std::invoke(operation, carries[block - 1].value(), sums[block - 1].value()) };
+            else
+                carries[block] = sums[block - 1];
+        }
+
+        dtl::parallel_for_range(pool, blocks, 1, [&](Usize const first, Usize const last) {
+            for (Usize block = first; block != last; ++block) {
+                scan_block(block_begin(block), block_begin(block + 1), carries[block]);
+            }
+        });
+    }
+
+    /* Description:
+     *     Sorts the elements with respect to `compare`. The sort is not
+     *     stable. Ranges are partitioned around a median-of-three pivot
+     *     and both sides are sorted in parallel; a recursion depth limit
+     *     bounds the worst case by falling back to `std::sort`.
+     */
+    template <class T, class Compare = std::less<>>
+        requires std::strict_weak_order<Compare&, T&, T&>
+    auto sort(ThreadPool& pool, Span<T> const elements, Compare compare = {}) -> void {
+        Usize depth_budget = 0;
+        for (Usize n = elements.size(); n > 1; n /= 2) {
+            depth_budget += 2;
+        }
+        T* const first = elements.data();
+        T* const last  = first + elements.size();
+        if (pool.thread_count() == 1 || elements.size() <= dtl::parallel_sort_cutoff) {
+            std::sort(first, last, compare);
+            return;
+        }
+        pool.run([&] { dtl::parallel_quicksort(pool, first, last, compare, depth_budget); });
+    }
+
+    /* Description:
+     *     Reorders the elements so that those satisfying `predicate`
+     *     precede those that do not. The partition is not stable.
+     *     Blocks are partitioned in parallel, after which the elements
+     *     left on the wrong side of the final partition point are
+     *     swapped pairwise in parallel.
+     *
+     * Return value:
+     *     The number of elements satisfying `predicate`.
+     */
+    template <class T, std::predicate<T&> Predicate>
+    auto partition(ThreadPool& pool, Span<T> const elements, Predicate predicate) -> Usize {
+        T* const    data   = elements.data();
+        Usize const length = elements.size();
+
+        if (pool.thread_count() == 1 || length < dtl::parallel_partition_cutoff) {
+            T* const point = std::partition(data, data + length, std::ref(predicate));
+            return static_cast<Usize>(point - data);
+        }
+
+        Usize const blocks =
+            dtl::parallel_block_count(pool, length, dtl::parallel_partition_cutoff / 2);
+        auto const block_begin = [&](Usize const block) { return length * block / blocks; };
+
+        Vector<Usize> true_counts { blocks };
+        dtl::parallel_for_range(pool, blocks, 1, [&](Usize const first, Usize const last) {
+            for (Usize block = first; block != last; ++block) {
+                T* const begin = data + block_begin(block);
+                T* const end   = data + block_begin(block + 1);
+                T* const point = std::partition(begin, end, std::ref(predicate));
+                true_counts[block] = static_cast<Usize>(point - begin);
+            }
+        });
+
+        Usize partition_point = 0;
+        for (Usize const count : true_counts) {
+            partition_point += count;
+        }
+
+        // Runs of false elements before the partition point and of true elements after it
+        Vector<dtl::PartitionRun> misplaced_false;
+        Vector<dtl::PartitionRun> misplaced_true;
+        Usize false_total = 0;
+        Usize true_total  = 0;
+        for (Usize block = 0; block != blocks; ++block) {
+            Usize const begin = block_begin(block);
+            Usize const split = begin + true_counts[block];
+            Usize const end   = block_begin(block + 1);
+            dtl::append_partition_run(
+                misplaced_false, false_total, split, end, 0, partition_point);
+            dtl::append_partition_run(
+                misplaced_true, true_total, begin, split, partition_point, length);
+        }
+        assert(false_total == true_total);
+
+        dtl::parallel_for_range(pool, false_total, 1024, [&](Usize const begin, Usize const end) {
+            Usize a = dtl::find_partition_run(misplaced_false, begin);
+            Usize b = dtl::find_partition_run(misplaced_true,  begin);
+            for (Usize i = begin; i != end; ++i) {
+                while (i >= misplaced_false[a].offset + misplaced_false[a].length) ++a;
+                while (i >= misplaced_true[b].offset  + misplaced_true[b].length)  ++b;
+                BU swap(
+                    data[misplaced_false[a].start + (i - misplaced_false[a].offset)],
+                    data[misplaced_true[b].start  + (i - misplaced_true[b].offset)]);
+            }
+        });
+        return partition_point;
+    }
+
+
+    // Overloads using `bu::ThreadPool::global()`
+
+    template <class T, std::invocable<T&> F>
+    auto for_each(Span<T> const elements, F&& function) -> void {
+        parallel::for_each(ThreadPool::global(), elements, std::forward<F>(function));
+    }
+    template <class T, class U, std::invocable<T&> F>
+    auto transform(Span<T> const input, Span<U> const output, F&& function) -> void {
+        parallel::transform(ThreadPool::global(), input, output, std::forward<F>(function));
+    }
+    template <class T>
+    auto fill(Span<T> const elements, T const& value) -> void {
+        parallel::fill(ThreadPool::global(), elements, value);
+    }
+    template <class T, class Operation = std::plus<>> [[nodiscard]]
+    auto reduce(Span<T> const elements, std::remove_const_t<T> init, Operation operation = {})
+        -> std::remove_const_t<T>
+    {
+        auto& pool = ThreadPool::global();
+        return parallel::reduce(pool, elements, std::move(init), std::move(operation));
+    }
+    template <class T, class U, class Operation = std::plus<>>
+    auto inclusive_scan(Span<T> const input, Span<U> const output, Operation operation = {})
+        -> void
+    {
+        parallel::inclusive_scan(ThreadPool::global(), input, output, std::move(operation));
+    }
+    template <class T, class Compare = std::less<>>
+    auto sort(Span<T> const elements, Compare compare = {}) -> void {
+        parallel::sort(ThreadPool::global(), elements, std::move(compare));
+    }
+    template <class T, std::predicate<T&> Predicate>
+    auto partition(Span<T> const elements, Predicate predicate) -> Usize {
+        return parallel::partition(ThreadPool::global(), elements, std::move(predicate));
+    }
+}
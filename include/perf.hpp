@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BU_PERF_EVENTS_AVAILABLE
+#endif
+
+#include "utility.hpp"
+#include "perf_fwd.hpp"
+
+
+namespace bu::perf {
+    enum class Event : Usize {
+        cycles,
+        instructions,
+        cache_misses,
+        branch_misses,
+        event_count
+    };
+
+    inline constexpr Usize event_count  = static_cast<Usize>(Event::event_count);
+    // Histogram buckets, bucket `b` counts samples of [2^(b-1), 2^b) cycles
+    inline constexpr Usize bucket_count = 64;
+}
+
+
+namespace bu::perf::dtl {
+    struct Sample {
+        std::uint64_t values[event_count] {};
+    };
+
+    [[nodiscard]]
+    inline auto read_timestamp() noexcept -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        auto const now = std::chrono::steady_clock::now();
+        return static_cast<std::uint64_t>(now.time_since_epoch().count());
+#endif
+    }
+
+    /* Description:
+     *     The hardware counters of the calling thread, opened as one
+     *     `perf_event_open` group so that a single `read` returns all of
+     *     them consistently. If the group cannot be opened, as in most
+     *     containers and under restrictive `perf_event_paranoid`
+     *     settings, only the timestamp counter is available and it
+     *     stands in for cycles.
+     */
+    class [[nodiscard]] CounterGroup {
+        int  m_fds[event_count];
+        bool m_hardware = false;
+    public:
+        CounterGroup() noexcept {
+            std::fill(m_fds, m_fds + event_count, -1);
+#ifdef BU_PERF_EVENTS_AVAILABLE
+            constexpr std::uint64_t configs[event_count] {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES,
+            };
+            for (Usize i = 0; i != event_count; ++i) {
+                perf_event_attr attributes {};
+                attributes.type           = PERF_TYPE_HARDWARE;
+                attributes.size           = sizeof attributes;
+                attributes.config         = configs[i];
+                attributes.read_format    = PERF_FORMAT_GROUP;
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv     = 1;
+                int  const leader = i ? m_fds[0] : -1;
+                long const fd     = ::syscall(SYS_perf_event_open, &attributes, 0, -1, leader, 0);
+                m_fds[i] = static_cast<int>(fd);
+                if (m_fds[i] == -1) {
+                    close_all();
+                    return;
+                }
+            }
+            m_hardware = true;
+#endif
+        }
+        CounterGroup(CounterGroup const&) = delete;
+        auto operator=(CounterGroup const&) -> CounterGroup& = delete;
+        ~CounterGroup() {
+            close_all();
+        }
+
+        [[nodiscard]]
+        auto is_hardware() const noexcept -> bool {
+            return m_hardware;
+        }
+
+        [[nodiscard]]
+        auto read() const noexcept -> Sample {
+            Sample sample;
+#ifdef BU_PERF_EVENTS_AVAILABLE
+            if (m_hardware) {
+                // The number of events, then their values in group order
+                std::uint64_t buffer[1 + event_count];
+                if (::read(m_fds[0], buffer, sizeof buffer) == sizeof buffer) {
+                    std::memcpy(sample.values, buffer + 1, sizeof sample.values);
+                    return sample;
+                }
+            }
+#endif
+            sample.values[static_cast<Usize>(Event::cycles)] = read_timestamp();
+            return sample;
+        }
+    private:
+        auto close_all() noexcept -> void {
+#ifdef BU_PERF_EVENTS_AVAILABLE
+            for (int& fd : m_fds) {
+                if (fd != -1)
+                    ::close(fd);
+                fd = -1;
+            }
+#endif
+        }
+    };
+
+    [[nodiscard]]
+    inline auto counter_group() noexcept -> CounterGroup const& {
+        thread_local CounterGroup const group;
+        return group;
+    }
+}
+
+
+namespace bu::perf {
+    class Histogram;
+
+    namespace dtl {
+        inline auto register_histogram(char const* name) noexcept -> Histogram*;
+    }
+
+    /* Description:
+     *     The samples of one probe site on one thread. Only the owning
+     *     thread writes, with plain loads and stores of relaxed atomics,
+     *     so recording needs no read-modify-write and readers on other
+     *     threads never block it. Histograms are never freed, so that
+     *     the samples of exited threads remain reportable.
+     */
+    class [[nodiscard]] Histogram {
+        std::atomic<std::uint64_t> m_count = 0;
+        std::atomic<std::uint64_t> m_totals[event_count] {};
+        std::atomic<std::uint64_t> m_buckets[bucket_count] {};
+        char const*                m_name;
+        bool                       m_hardware;
+        Histogram*                 m_next = nullptr;
+
+        static auto bump(std::atomic<std::uint64_t>& counter, std::uint64_t const amount)
+            noexcept -> void
+        {
+            std::uint64_t const value = counter.load(std::memory_order_relaxed) + amount;
+            counter.store(value, std::memory_order_relaxed);
+        }
+
+        friend auto dtl::register_histogram(char const*) noexcept -> Histogram*;
+        template <class F>
+        friend auto for_each_histogram(F&&) -> void;
+    public:
+        explicit Histogram(char const* const name, bool const hardware) noexcept
+            : m_name     { name }
+            , m_hardware { hardware } {}
+
+        auto record(dtl::Sample const& start, dtl::Sample const& end) noexcept -> void {
+            bump(m_count, 1);
+            for (Usize i = 0; i != event_count; ++i) {
+                bump(m_totals[i], end.values[i] - start.values[i]);
+            }
+            constexpr auto      index  = static_cast<Usize>(Event::cycles);
+            std::uint64_t const cycles = end.values[index] - start.values[index];
+            bump(m_buckets[std::min<Usize>(std::bit_width(cycles), bucket_count - 1)], 1);
+        }
+
+        [[nodiscard]]
+        auto name() const noexcept -> char const* {
+            return m_name;
+        }
+        // Whether the samples come from hardware counters rather than the timestamp counter alone
+        [[nodiscard]]
+        auto is_hardware() const noexcept -> bool {
+            return m_hardware;
+        }
+        [[nodiscard]]
+        auto count() const noexcept -> std::uint64_t {
+            return m_count.load(std::memory_order_relaxed);
+        }
+        [[nodiscard]]
+        auto total(Event const event) const noexcept -> std::uint64_t {
+            return m_totals[static_cast<Usize>(event)].load(std::memory_order_relaxed);
+        }
+        [[nodiscard]]
+        auto bucket(Usize const index) const noexcept -> std::uint64_t {
+            return m_buckets[index].load(std::memory_order_relaxed);
+        }
+    };
+
+
+    namespace dtl {
+        inline std::atomic<Histogram*> histogram_list = nullptr;
+
+        // Creates a histogram for the calling thread and publishes it to `for_each_histogram`
+        inline auto register_histogram(char const* const name) noexcept -> Histogram* {
+            bool const  hardware  = counter_group().is_hardware();
+            auto* const histogram = new (std::nothrow) Histogram { name, hardware };
+            if (histogram) {
+                histogram->m_next = histogram_list.load(std::memory_order_relaxed);
+                while (!histogram_list.compare_exchange_weak(
+                    histogram->m_next,
+                    histogram,
+                    std::memory_order_release,
+                    std::memory_order_relaxed)) {}
+            }
+            return histogram;
+        }
+    }
+
+    // Invokes `f` with every histogram of every thread, including exited ones
+    template <class F>
+    auto for_each_histogram(F&& f) -> void {
+        for (Histogram const* histogram = dtl::histogram_list.load(std::memory_order_acquire);
+            histogram; histogram = histogram->m_next)
+        {
+            f(*histogram);
+        }
+    }
+
+
+    // The samples of one probe site merged over all threads
+    struct [[nodiscard]] Summary {
+        std::uint64_t count = 0;
+        std::uint64_t hardware_count = 0; // How many samples come from hardware counters
+        std::uint64_t totals[event_count] {};
+        std::uint64_t buckets[bucket_count] {};
+
+        [[nodiscard]]
+        auto mean(Event const event) const noexcept -> double {
+            if (count == 0)
+                return 0;
+            auto const total = static_cast<double>(totals[static_cast<Usize>(event)]);
+            return total / static_cast<double>(count);
+        }
+
+        // An upper bound of the cycles of the `quantile` of samples, such as 0.99
+        [[nodiscard]]
+        auto cycles_quantile(double const quantile) const noexcept -> std::uint64_t {
+            auto const     target = static_cast<std::uint64_t>(
+                quantile * static_cast<double>(count));
+            std::uint64_t  seen   = 0;
+            for (Usize b = 0; b != bucket_count; ++b) {
+                seen += buckets[b];
+                if (seen > target)
+                    return (std::uint64_t { 1 } << b) - 1;
+            }
+            return maximum<std::uint64_t>;
+        }
+    };
+
+    // Merges the histograms of every thread for the probe site `name`
+    [[nodiscard]]
+    inline auto summarize(char const* const name) -> Summary {
+        Summary summary;
+        for_each_histogram([&](Histogram const& histogram) {
+            if (std::strcmp(histogram.name(), name) != 0)
+                return;
+            std::uint64_t const count = histogram.count();
+            summary.count += count;
+            if (histogram.is_hardware())
+                summary.hardware_count += count;
+            for (Usize i = 0; i != event_count; ++i) {
+                summary.totals[i] += histogram.total(static_cast<Event>(i));
+            }
+            for (Usize b = 0; b != bucket_count; ++b) {
+                summary.buckets[b] += histogram.bucket(b);
+            }
+        });
+        return summary;
+    }
+
+
+    /* Description:
+     *     Measures the cycles, instructions, cache misses and branch
+     *     mispredictions between its construction and destruction, and
+     *     adds them to the calling thread's histogram for `name`:
+     *
+     *         {
+     *             bu::perf::Scope<"parser.parse_line"> const probe;
+     *             parse_line(line);
+     *         }
+     *
+     *     When `enabled` is false the probe is an empty type and costs
+     *     nothing. The probes inside the library pass
+     *     `bu::perf::hooks_enabled`, and the library's headers include
+     *     only perf_fwd.hpp unless `BU_PERF_HOOKS` is 1. Each
+     *     measurement reads the counter group with one system call at
+     *     either end, so probes suit operations of at least a few
+     *     microseconds, such as allocations and reallocations, rather
+     *     than element access.
+     */
+    template <Metastring name, bool enabled>
+    class [[nodiscard]] Scope {
+        dtl::Sample m_start;
+    public:
+        constexpr Scope() noexcept {
+            if (!std::is_constant_evaluated())
+                m_start = dtl::counter_group().read();
+        }
+        Scope(Scope const&) = delete;
+        auto operator=(Scope const&) -> Scope& = delete;
+        constexpr ~Scope() {
+            if (!std::is_constant_evaluated()) {
+                dtl::Sample const end = dtl::counter_group().read();
+                if (Histogram* const histogram = site())
+                    histogram->record(m_start, end);
+            }
+        }
+    private:
+        static auto site() noexcept -> Histogram* {
+            thread_local Histogram* const histogram = dtl::register_histogram(name.string());
+            return histogram;
+        }
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "utility.hpp"
+
+
+// Define to 1 to enable the `bu::perf::Scope` probes inside the library's containers and allocators
+#ifndef BU_PERF_HOOKS
+#define BU_PERF_HOOKS 0
+#endif
+
+
+namespace bu::perf {
+    // Whether the probes inside the library are enabled, see `BU_PERF_HOOKS`
+    inline constexpr bool hooks_enabled = BU_PERF_HOOKS;
+
+    // Defined in perf.hpp, which is only included here when the library's probes are enabled
+    template <Metastring name, bool enabled = true>
+    class Scope;
+
+    template <Metastring name>
+    class [[nodiscard]] Scope<name, false> {
+    public:
+        constexpr Scope() noexcept {}
+        Scope(Scope const&) = delete;
+        auto operator=(Scope const&) -> Scope& = delete;
+    };
+}
+
+
+#if BU_PERF_HOOKS
+#include "perf.hpp"
+#endif
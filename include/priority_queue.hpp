@@ -0,0 +1,482 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+
+#include "utility.hpp"
+#include "allocator.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+    /* Description:
+     *     Observes the element moves of the heap algorithms below.
+     *     Tracked queues use it to keep handles up to date:
+     *     - `take(i)`: the element at `i` is lifted out
+     *     - `move(i, j)`: the element at `i` moved to `j`
+     *     - `put(i)`: the lifted element is placed at `i`
+     */
+    struct HeapUntracked {
+        constexpr auto take(Usize) noexcept -> void {}
+        constexpr auto move(Usize, Usize) noexcept -> void {}
+        constexpr auto put(Usize) noexcept -> void {}
+    };
+
+    // Moves the element at `index` towards the root while it compares greater than its parent
+    template <Usize arity, class T, class Compare, class Observer>
+    constexpr auto heap_sift_up(
+        T*       const  heap,
+        Usize           index,
+        Compare  const& compare,
+        Observer&       observer) -> void
+    {
+        T value = std::move(heap[index]);
+        observer.take(index);
+        while (index != 0) {
+            Usize const parent = (index - 1) / arity;
+            if (!compare(heap[parent], value))
+                break;
+            heap[index] = std::move(heap[parent]);
+            observer.move(parent, index);
+            index = parent;
+        }
+        heap[index] = std::move(value);
+        observer.put(index);
+    }
+
+    // Moves the element at `index` towards the leaves while it compares less than its
+    // greatest child
+    template <Usize arity, class T, class Compare, class Observer>
+    constexpr auto heap_sift_down(
+        T*       const  heap,
+        Usize    const  size,
+        Usize           index,
+        Compare  const& compare,
+        Observer&       observer) -> void
+    {
+        T value = std::move(heap[index]);
+        observer.take(index);
+        for (;;) {
+            Usize const first = index * arity + 1;
+            if (first >= size)
+                break;
+            Usize const last = std::min(first + arity, size);
+            Usize       best = first;
+            for (Usize child = first + 1; child < last; ++child) {
+                if (compare(heap[best], heap[child]))
+                    best = child;
+            }
+            if (!compare(value, heap[best]))
+                break;
+            heap[index] = std::move(heap[best]);
+            observer.move(best, index);
+            index = best;
+        }
+        heap[index] = std::move(value);
+        observer.put(index);
+    }
+
+    // Floyd's bottom-up heap construction, O(size)
+    template <Usize arity, class T, class Compare, class Observer>
+    constexpr auto make_heap(
+        T*       const  heap,
+        Usize    const  size,
+        Compare  const& compare,
+        Observer&       observer) -> void
+    {
+        if (size < 2)
+            return;
+        for (Usize index = (size - 2) / arity + 1; index-- != 0;) {
+            heap_sift_down<arity>(heap, size, index, compare, observer);
+        }
+    }
+
+    // Removes the element at `index`, keeping the heap property
+    template <Usize arity, class T, class Compare, class Observer>
+    constexpr auto heap_erase(
+        T*       const  heap,
+        Usize    const  size,
+        Usize    const  index,
+        Compare  const& compare,
+        Observer&       observer) -> T
+    {
+        T removed = std::move(heap[index]);
+        if (index != size - 1) {
+            heap[index] = std::move(heap[size - 1]);
+            observer.move(size - 1, index);
+            if (index != 0 && compare(heap[(index - 1) / arity], heap[index]))
+                heap_sift_up<arity>(heap, index, compare, observer);
+            else
+                heap_sift_down<arity>(heap, size - 1, index, compare, observer);
+        }
+        return removed;
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     A priority queue stored as an implicit `arity`-ary heap in a
+     *     `bu::Vector`. `top` is the greatest element according to
+     *     `Compare`, so `std::greater<>` gives a min-queue.
+     *
+     *     The default arity of 4 halves the height of a binary heap
+     *     and keeps the children of a node within one cache line for
+     *     small elements, which makes `pop` cheaper at the expense of
+     *     a few more comparisons per level.
+     */
+    template <
+        class T,
+        class Compare = std::less<>,
+        Usize arity = 4,
+        allocator_for<T> A = DefaultAllocator<T>
+    >
+    class [[nodiscard]] PriorityQueue {
+        static_assert(arity >= 2);
+
+        Vector<T, A> m_heap;
+        [[no_unique_address]]
+        Compare      m_compare;
+    public:
+        using ContainedType = T;
+        using AllocatorType = A;
+        using SizeType      = Usize;
+
+        PriorityQueue() = default;
+
+        constexpr explicit PriorityQueue(Compare compare)
+            : m_compare { std::move(compare) } {}
+
+        // Builds the queue from copies of `values` in O(n)
+        constexpr explicit PriorityQueue(Span<T const> const values, Compare compare = Compare {})
+            : m_compare { std::move(compare) }
+        {
+            m_heap.extend(values);
+            heapify();
+        }
+
+        // Builds the queue from `values` in O(n), without copying them
+        constexpr explicit PriorityQueue(Vector<T, A>&& values, Compare compare = Compare {})
+            : m_heap    { std::move(values) }
+            , m_compare { std::move(compare) }
+        {
+            heapify();
+        }
+
+        [[nodiscard]]
+        constexpr auto size() const noexcept -> Usize {
+            return m_heap.size();
+        }
+        [[nodiscard]]
+        constexpr auto is_empty() const noexcept -> bool {
+            return m_heap.is_empty();
+        }
+
+        constexpr auto reserve(Usize const capacity) -> void {
+            m_heap.reserve(capacity);
+        }
+
+        // The greatest element
+        [[nodiscard]]
+        constexpr auto top() const noexcept -> T const& {
+            assert(!is_empty());
+            return m_heap.front();
+        }
+
+        /* Description:
+         *     Constructs a new element with `T(std::forward<Args>(args)...)`
+         *     and moves it to its place in the heap.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(Args&&...)
+         *     - A::allocate(bu::Usize)
+         */
+        template <class... Args>
+        constexpr auto push(Args&&... args) -> void {
+            m_heap.append(std::forward<Args>(args)...);
+            dtl::HeapUntracked observer;
+            dtl::heap_sift_up<arity>(m_heap.data(), m_heap.size() - 1, m_compare, observer);
+        }
+
+        // Removes and returns the greatest element
+        constexpr auto pop() -> T {
+            assert(!is_empty());
+            dtl::HeapUntracked observer;
+            T top = dtl::heap_erase<arity>(m_heap.data(), m_heap.size(), 0, m_compare, observer);
+            m_heap.pop_back();
+            return top;
+        }
+
+        // Removes the greatest element if there is one
+        constexpr auto try_pop() -> Option<T> {
+            if (is_empty())
+                return nullopt;
+            return pop();
+        }
+
+        /* Description:
+         *     Removes the `count` greatest elements, or every element
+         *     if there are fewer, and appends them to `output` from the
+         *     greatest down.
+         *
+         * Return value:
+         *     The number of elements removed.
+         */
+        template <allocator_for<T> B>
+        constexpr auto pop_many(Usize count, Vector<T, B>& output) -> Usize {
+            count = std::min(count, size());
+            for (Usize i = 0; i != count; ++i) {
+                output.append(pop());
+            }
+            return count;
+        }
+
+        constexpr auto clear() noexcept -> void {
+            m_heap.clear();
+        }
+
+        // The elements in heap order
+        [[nodiscard]]
+        constexpr auto values() const noexcept -> Span<T const> {
+            return Span<T const> { m_heap.data(), m_heap.size() };
+        }
+
+        constexpr auto swap(PriorityQueue& other) noexcept -> void {
+            m_heap.swap(other.m_heap);
+            BU swap(m_compare, other.m_compare);
+        }
+    private:
+        constexpr auto heapify() -> void {
+            dtl::HeapUntracked observer;
+            dtl::make_heap<arity>(m_heap.data(), m_heap.size(), m_compare, observer);
+        }
+    };
+
+
+    // Identifies an element of a `bu::TrackedPriorityQueue` for as long as it is in the queue
+    struct PriorityQueueHandle {
+        Usize index = 0;
+
+        [[nodiscard]]
+        constexpr auto operator==(PriorityQueueHandle const&) const noexcept -> bool = default;
+    };
+
+
+    /* Description:
+     *     A `bu::PriorityQueue` which hands out a handle for every
+     *     pushed element, through which the element can be read,
+     *     reprioritized or removed in O(log n). The heap keeps, for
+     *     every position, the handle of the element there, and for
+     *     every handle, the position of its element.
+     *
+     *     Handles of removed elements are reused by later pushes.
+     */
+    template <
+        class T,
+        class Compare = std::less<>,
+        Usize arity = 4,
+        allocator_for<T> A = DefaultAllocator<T>
+    >
+    class [[nodiscard]] TrackedPriorityQueue {
+        static_assert(arity >= 2);
+
+        static constexpr Usize removed = static_cast<Usize>(-1);
+
+        Vector<T, A> m_heap;
+        Vector<Usize> m_handles;      // The handle of the element at each heap position
+        Vector<Usize> m_positions;    // The heap position of each handle's element, or `removed`
+        Vector<Usize> m_free_handles;
+        [[no_unique_address]]
+        Compare       m_compare;
+
+        struct Observer {
+            TrackedPriorityQueue* queue;
+            Usize                 handle = 0;
+
+            constexpr auto take(Usize const index) noexcept -> void {
+                handle = queue->m_handles.data()[index];
+            }
+            constexpr auto move(Usize const from, Usize const to) noexcept -> void {
+                Usize const moved = queue->m_handles.data()[from];
+                queue->m_handles.data()[to] = moved;
+                queue->m_positions.data()[moved] = to;
+            }
+            constexpr auto put(Usize const index) noexcept -> void {
+                queue->m_handles.data()[index] = handle;
+                queue->m_positions.data()[handle] = index;
+            }
+        };
+    public:
+        using ContainedType = T;
+        using AllocatorType = A;
+        using SizeType      = Usize;
+        using Handle        = PriorityQueueHandle;
+
+        TrackedPriorityQueue() = default;
+
+        constexpr explicit TrackedPriorityQueue(Compare compare)
+            : m_compare { std::move(compare) } {}
+
+        [[nodiscard]]
+        constexpr auto size() const noexcept -> Usize {
+            return m_heap.size();
+        }
+        [[nodiscard]]
+        constexpr auto is_empty() const noexcept -> bool {
+            return m_heap.is_empty();
+        }
+
+        // Whether the element of `handle` is still in the queue
+        [[nodiscard]]
+        constexpr auto contains(Handle const handle) const noexcept -> bool {
+            return handle.index < m_positions.size() && m_positions.data()[handle.index] != removed;
+        }
+
+        [[nodiscard]]
+        constexpr auto top() const noexcept -> T const& {
+            assert(!is_empty());
+            return m_heap.front();
+        }
+        [[nodiscard]]
+        constexpr auto top_handle() const noexcept -> Handle {
+            assert(!is_empty());
+            return Handle { m_handles.front() };
+        }
+
+        [[nodiscard]]
+        constexpr auto operator[](Handle const handle) const noexcept -> T const& {
+            assert(contains(handle));
+            return m_heap.data()[m_positions.data()[handle.index]];
+        }
+
+        /* Description:
+         *     Constructs a new element with `T(std::forward<Args>(args)...)`
+         *     and moves it to its place in the heap.
+         *
+         * Return value:
+         *     The handle of the new element.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(Args&&...)
+         *     - A::allocate(bu::Usize)
+         *     The queue is unchanged if an exception is thrown.
+         */
+        template <class... Args>
+        constexpr auto push(Args&&... args) -> Handle {
+            // Make room first so that the queue is unchanged if an exception is thrown
+            bool const new_handle = m_free_handles.is_empty();
+            reserve_for(m_handles, m_handles.size() + 1);
+            if (new_handle) {
+                reserve_for(m_positions, m_positions.size() + 1);
+                reserve_for(m_free_handles, m_positions.size() + 1);
+            }
+            m_heap.append(std::forward<Args>(args)...);
+
+            Usize handle;
+            if (new_handle) {
+                handle = m_positions.size();
+                m_positions.append(removed);
+            }
+            else {
+                handle = m_free_handles.back();
+                m_free_handles.pop_back();
+            }
+            m_handles.append(handle);
+            m_positions.data()[handle] = m_heap.size() - 1;
+
+            Observer observer { this };
+            dtl::heap_sift_up<arity>(m_heap.data(), m_heap.size() - 1, m_compare, observer);
+            return Handle { handle };
+        }
+
+        // Removes and returns the greatest element
+        constexpr auto pop() -> T {
+            assert(!is_empty());
+            return erase_at(0);
+        }
+
+        // Removes and returns the element of `handle`
+        constexpr auto erase(Handle const handle) -> T {
+            assert(contains(handle));
+            return erase_at(m_positions.data()[handle.index]);
+        }
+
+        /* Description:
+         *     Replaces the element of `handle` with `value`, which must
+         *     not compare less than the current one, and moves it
+         *     towards the top. The name follows the min-heap convention
+         *     of Dijkstra's algorithm, where the queue is ordered by
+         *     `std::greater<>` and a decreased key rises.
+         */
+        constexpr auto decrease_key(Handle const handle, T value) -> void {
+            assert(contains(handle));
+            Usize const position = m_positions.data()[handle.index];
+            assert(!m_compare(value, m_heap.data()[position]));
+            m_heap.data()[position] = std::move(value);
+            Observer observer { this };
+            dtl::heap_sift_up<arity>(m_heap.data(), position, m_compare, observer);
+        }
+
+        // Replaces the element of `handle` with `value`, moving it up or down as needed
+        constexpr auto update(Handle const handle, T value) -> void {
+            assert(contains(handle));
+            Usize const position = m_positions.data()[handle.index];
+            bool const  rises    = m_compare(m_heap.data()[position], value);
+            m_heap.data()[position] = std::move(value);
+            Observer observer { this };
+            if (rises)
+                dtl::heap_sift_up<arity>(m_heap.data(), position, m_compare, observer);
+            else
+                dtl::heap_sift_down<arity>(
+                    m_heap.data(), m_heap.size(), position, m_compare, observer);
+        }
+
+        /* Description:
+         *     Removes the `count` greatest elements, or every element
+         *     if there are fewer, and appends them to `output` from the
+         *     greatest down. Their handles are invalidated.
+         *
+         * Return value:
+         *     The number of elements removed.
+         */
+        template <allocator_for<T> B>
+        constexpr auto pop_many(Usize count, Vector<T, B>& output) -> Usize {
+            count = std::min(count, size());
+            for (Usize i = 0; i != count; ++i) {
+                output.append(pop());
+            }
+            return count;
+        }
+
+        // Removes every element and invalidates every handle
+        constexpr auto clear() noexcept -> void {
+            m_heap.clear();
+            m_handles.clear();
+            m_positions.clear();
+            m_free_handles.clear();
+        }
+    private:
+        constexpr auto erase_at(Usize const position) -> T {
+            Usize const handle = m_handles.data()[position];
+            Observer    observer { this };
+            T element = dtl::heap_erase<arity>(
+                m_heap.data(), m_heap.size(), position, m_compare, observer);
+            m_heap.pop_back();
+            m_handles.pop_back();
+            m_positions.data()[handle] = removed;
+            m_free_handles.append(handle); // Cannot throw, there is room for every handle
+            return element;
+        }
+
+        // Makes room for `count` elements, growing geometrically like `bu::Vector::append`
+        template <class U>
+        static constexpr auto reserve_for(Vector<U>& vector, Usize const count) -> void {
+            if (count > vector.capacity())
+                vector.reserve(std::max(count, vector.capacity() * 2));
+        }
+    };
+}
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <atomic>
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "allocator.hpp"
+#include "memory.hpp"
+
+
+namespace bu::dtl {
+    // A reference count which is a plain integer, or an atomic one when `atomic` is true
+    template <bool atomic>
+    class [[nodiscard]] RefCount {
+        std::conditional_t<atomic, std::atomic<Usize>, Usize> m_count;
+    public:
+        constexpr explicit RefCount(Usize const initial) noexcept
+            : m_count { initial } {}
+
+        constexpr auto increment() noexcept -> void {
+            if constexpr (atomic) {
+                // A new reference is made from an existing one, so nothing needs to be ordered
+                m_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                ++m_count;
+            }
+        }
+
+        // Returns true if this released the last reference
+        [[nodiscard]]
+        constexpr auto decrement() noexcept -> bool {
+            if constexpr (atomic) {
+                // Every release happens before the destruction performed by the last one
+                return m_count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+            else {
+                return --m_count == 0;
+            }
+        }
+
+        // Increments the count unless it is zero, returns whether it did
+        [[nodiscard]]
+        constexpr auto increment_if_nonzero() noexcept -> bool {
+            if constexpr (atomic) {
+                Usize count = m_count.load(std::memory_order_relaxed);
+                do {
+                    if (count == 0)
+                        return false;
+                } while (!m_count.compare_exchange_weak(
+                    count, count + 1, std::memory_order_acquire, std::memory_order_relaxed));
+                return true;
+            }
+            else {
+                if (m_count == 0)
+                    return false;
+                ++m_count;
+                return true;
+            }
+        }
+
+        [[nodiscard]]
+        constexpr auto load() const noexcept -> Usize {
+            if constexpr (atomic)
+                return m_count.load(std::memory_order_relaxed);
+            else
+                return m_count;
+        }
+    };
+
+    enum class RcAction {
+        destroy_value,
+        deallocate,
+    };
+
+    struct RcNoWeakCount {
+        constexpr explicit RcNoWeakCount(Usize) noexcept {}
+    };
+
+    /* Description:
+     *     The header of the single allocation made by `bu::make_rc` and
+     *     `bu::make_arc`. `manage` knows the allocator and the value
+     *     type, so that the pointers need not, and the allocator itself
+     *     is stored after the value where only `manage` looks for it.
+     *     The weak count, if enabled, holds one extra reference on
+     *     behalf of all strong references, so the block outlives the
+     *     value for as long as weak references remain.
+     */
+    template <bool atomic, bool weakable>
+    struct RcHeader;
+
+    template <bool atomic, bool weakable>
+    using RcManager = void (*)(RcHeader<atomic, weakable>*, RcAction) noexcept;
+
+    template <bool atomic, bool weakable>
+    struct RcHeader {
+        RefCount<atomic> strong { 1 };
+        [[no_unique_address]]
+        std::conditional_t<weakable, RefCount<atomic>, RcNoWeakCount> weak { 1 };
+        RcManager<atomic, weakable> manage;
+    };
+
+    template <class T, bool atomic, bool weakable>
+    struct RcBox {
+        RcHeader<atomic, weakable> header;
+        union {
+            T value; // Destroyed by `manage`, possibly before the box is deallocated
+        };
+
+        template <class... Args>
+        explicit RcBox(RcManager<atomic, weakable> const manage, Args&&... args)
+            : header { .manage = manage }
+            , value  ( std::forward<Args>(args)... ) {}
+
+        RcBox(RcBox const&) = delete;
+        auto operator=(RcBox const&) -> RcBox& = delete;
+        ~RcBox() {}
+    };
+
+    // The allocation behind a box, which also holds the allocator the box was obtained from
+    template <class T, bool atomic, bool weakable, class Stored>
+    struct RcAllocation {
+        // First, so that a pointer to the box is a pointer to the allocation
+        RcBox<T, atomic, weakable> box;
+        [[no_unique_address]]
+        Stored allocator;
+
+        template <class... Args>
+        explicit RcAllocation(
+            Stored const&                     allocator,
+            RcManager<atomic, weakable> const manage,
+            Args&&...                         args)
+            : box       ( manage, std::forward<Args>(args)... )
+            , allocator { allocator } {}
+    };
+
+    // An allocator from which the allocation can be obtained and freed given a copy of `Stored`
+    template <class Stored, class Rebound>
+    concept rc_allocator = allocator<Rebound>
+                        && std::is_nothrow_copy_constructible_v<Stored>
+                        && (std::is_nothrow_constructible_v<Rebound, Stored const&>
+                            || (std::is_empty_v<Stored>
+                                && std::is_nothrow_default_constructible_v<Rebound>));
+
+    // Converts `allocator` to `Rebound`, or default-constructs a stateless one with no conversion
+    template <class Rebound, class Stored>
+    [[nodiscard]]
+    auto rebind_rc_allocator(Stored const& allocator) noexcept -> Rebound {
+        if constexpr (std::is_nothrow_constructible_v<Rebound, Stored const&>)
+            return Rebound(allocator);
+        else
+            return Rebound {};
+    }
+
+    template <class T, bool atomic, bool weakable, template <class> class A, class Stored>
+    auto manage_rc_box(RcHeader<atomic, weakable>* const header, RcAction const action)
+        noexcept -> void
+    {
+        using Allocation = RcAllocation<T, atomic, weakable, Stored>;
+        auto* const allocation = reinterpret_cast<Allocation*>(header);
+        if (action == RcAction::destroy_value) {
+            std::destroy_at(&allocation->box.value);
+        }
+        else {
+            A<Allocation> allocator = rebind_rc_allocator<A<Allocation>>(allocation->allocator);
+            BU destroy(*allocation);
+            allocator.deallocate(allocation, 1);
+        }
+    }
+
+    template <class T, bool atomic, bool weakable>
+    class WeakPtr;
+
+    template <class T, bool atomic, bool weakable>
+    class CountedPtr;
+
+    template <
+        class T,
+        bool atomic,
+        bool weakable,
+        template <class> class A,
+        class Stored,
+        class... Args
+    >
+    auto make_counted(Stored const& allocator, Args&&... args) -> CountedPtr<T, atomic, weakable>;
+
+
+    template <class T, bool atomic, bool weakable>
+    class [[nodiscard]] CountedPtr {
+        using Box    = RcBox<T, atomic, weakable>;
+        using Header = RcHeader<atomic, weakable>;
+
+        Box* m_box = nullptr;
+
+        constexpr explicit CountedPtr(Box* const box) noexcept
+            : m_box { box } {}
+
+        template <
+            class U,
+            bool atomic_count,
+            bool weak_count,
+            template <class> class A,
+            class Stored,
+            class... Args
+        >
+        friend auto make_counted(Stored const&, Args&&...)
+            -> CountedPtr<U, atomic_count, weak_count>;
+        friend class WeakPtr<T, atomic, weakable>;
+    public:
+        using PointeeType = T;
+
+        CountedPtr() = default;
+
+        constexpr CountedPtr(CountedPtr const& other) noexcept
+            : m_box { other.m_box }
+        {
+            if (m_box)
+                m_box->header.strong.increment();
+        }
+        constexpr CountedPtr(CountedPtr&& other) noexcept
+            : m_box { BU exchange(other.m_box, nullptr) } {}
+
+        constexpr auto operator=(CountedPtr const& other) noexcept -> CountedPtr& {
+            CountedPtr copy = other;
+            swap(copy);
+            return *this;
+        }
+        constexpr auto operator=(CountedPtr&& other) noexcept -> CountedPtr& {
+            if (this != &other) {
+                reset();
+                m_box = BU exchange(other.m_box, nullptr);
+            }
+            return *this;
+        }
+
+        constexpr ~CountedPtr() {
+            reset();
+        }
+
+        // Releases this reference, destroying the value if it was the last one
+        constexpr auto reset() noexcept -> void {
+            if (Box* const box = BU exchange(m_box, nullptr)) {
+                Header& header = box->header;
+                if (!header.strong.decrement())
+                    return;
+                header.manage(&header, RcAction::destroy_value);
+                if constexpr (weakable) {
+                    if (!header.weak.decrement())
+                        return;
+                }
+                header.manage(&header, RcAction::deallocate);
+            }
+        }
+
+        [[nodiscard]]
+        constexpr auto operator*() const noexcept -> T& {
+            assert(m_box);
+            return m_box->value;
+        }
+        [[nodiscard]]
+        constexpr auto operator->() const noexcept -> T* {
+            assert(m_box);
+            return std::addressof(m_box->value);
+        }
+        [[nodiscard]]
+        constexpr auto get() const noexcept -> T* {
+            return m_box ? std::addressof(m_box->value) : nullptr;
+        }
+        [[nodiscard]]
+        constexpr explicit operator bool() const noexcept {
+            return m_box != nullptr;
+        }
+
+        // The number of strong references to the value, or zero if this is empty
+        [[nodiscard]]
+        constexpr auto use_count() const noexcept -> Usize {
+            return m_box ? m_box->header.strong.load() : 0;
+        }
+
+        [[nodiscard]]
+        constexpr auto downgrade() const noexcept -> WeakPtr<T, atomic, weakable>
+            requires weakable
+        {
+            if (m_box)
+                m_box->header.weak.increment();
+            return WeakPtr<T, atomic, weakable> { m_box };
+        }
+
+        constexpr auto swap(CountedPtr& other) noexcept -> void {
+            BU swap(m_box, other.m_box);
+        }
+
+        // Pointers compare by identity, like `bu::UniquePtr`
+        constexpr auto operator==(CountedPtr const& other) const noexcept -> bool {
+            return m_box == other.m_box;
+        }
+        constexpr auto operator==(std::nullptr_t) const noexcept -> bool {
+            return m_box == nullptr;
+        }
+    };
+
+    template <class T, bool atomic, bool weakable>
+    class [[nodiscard]] WeakPtr {
+        using Box = RcBox<T, atomic, weakable>;
+
+        Box* m_box = nullptr;
+
+        constexpr explicit WeakPtr(Box* const box) noexcept
+            : m_box { box } {}
+
+        friend class CountedPtr<T, atomic, weakable>;
+    public:
+        WeakPtr() = default;
+
+        constexpr WeakPtr(WeakPtr const& other) noexcept
+            : m_box { other.m_box }
+        {
+            if (m_box)
+                m_box->header.weak.increment();
+        }
+        constexpr WeakPtr(WeakPtr&& other) noexcept
+            : m_box { BU exchange(other.m_box, nullptr) } {}
+
+        constexpr auto operator=(WeakPtr const& other) noexcept -> WeakPtr& {
+            WeakPtr copy = other;
+            swap(copy);
+            return *this;
+        }
+        constexpr auto operator=(WeakPtr&& other) noexcept -> WeakPtr& {
+            if (this != &other) {
+                reset();
+                m_box = BU exchange(other.m_box, nullptr);
+            }
+            return *this;
+        }
+
+        constexpr ~WeakPtr() {
+            reset();
+        }
+
+        constexpr auto reset() noexcept -> void {
+            if (Box* const box = BU exchange(m_box, nullptr)) {
+                if (box->header.weak.decrement())
+                    box->header.manage(&box->header, RcAction::deallocate);
+            }
+        }
+
+        // Returns a strong reference, or nothing if the value has already been destroyed
+        [[nodiscard]]
+        constexpr auto upgrade() const noexcept -> Option<CountedPtr<T, atomic, weakable>> {
+            if (m_box && m_box->header.strong.increment_if_nonzero())
+                return CountedPtr<T, atomic, weakable> { m_box };
+            else
+                return nullopt;
+        }
+
+        [[nodiscard]]
+        constexpr auto is_expired() const noexcept -> bool {
+            return !m_box || m_box->header.strong.load() == 0;
+        }
+
+        constexpr auto swap(WeakPtr& other) noexcept -> void {
+            BU swap(m_box, other.m_box);
+        }
+    };
+
+    template <
+        class T,
+        bool atomic,
+        bool weakable,
+        template <class> class A,
+        class Stored,
+        class... Args
+    >
+    auto make_counted(Stored const& allocator, Args&&... args) -> CountedPtr<T, atomic, weakable> {
+        using Allocation = RcAllocation<T, atomic, weakable, Stored>;
+        static_assert(allocator_for<A<Allocation>, Allocation>);
+        static_assert(rc_allocator<Stored, A<Allocation>>);
+
+        A<Allocation>     rebound    = rebind_rc_allocator<A<Allocation>>(allocator);
+        Allocation* const allocation = rebound.allocate(1);
+        try {
+            auto const manage = &manage_rc_box<T, atomic, weakable, A, Stored>;
+            std::construct_at(allocation, allocator, manage, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            rebound.deallocate(allocation, 1);
+            throw;
+        }
+        return CountedPtr<T, atomic, weakable> { &allocation->box };
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     A reference-counted pointer for use within one thread. The
+     *     count and the value share a single allocation, and copying or
+     *     destroying an `Rc` is a plain increment or decrement. `Arc` is
+     *     the same with an atomic count, for values shared between
+     *     threads.
+     *
+     *     Weak references are opt-in through `weakable`, since they add
+     *     a second count to every allocation and a second decrement to
+     *     the destruction of the last strong reference:
+     *
+     *         bu::Rc<Node, true>   node   = bu::make_rc<Node, true>(...);
+     *         bu::WeakRc<Node>     parent = node.downgrade();
+     */
+    template <class T, bool weakable = false>
+    using Rc = dtl::CountedPtr<T, false, weakable>;
+
+    template <class T, bool weakable = false>
+    using Arc = dtl::CountedPtr<T, true, weakable>;
+
+    template <class T>
+    using WeakRc = dtl::WeakPtr<T, false, true>;
+
+    template <class T>
+    using WeakArc = dtl::WeakPtr<T, true, true>;
+
+    /* Description:
+     *     Allocates the count and a `T` constructed from `args` in one
+     *     block obtained from `A<Block>`. The overloads taking
+     *     `bu::allocator_arg, allocator` obtain the block from an
+     *     `A<Block>` constructed from `allocator`, and keep a copy of
+     *     `allocator` in the block to free it with, so stateful
+     *     allocators such as arenas can be used:
+     *
+     *         ArenaAllocator<Node> const allocator { arena };
+     *         auto node = bu::make_rc<Node>(bu::allocator_arg, allocator, ...);
+     *
+     *     A stateless allocator without such a conversion is
+     *     default-constructed instead, and takes no space in the block.
+     *     Either way the allocator does not appear in the pointer type.
+     *
+     * Exceptions:
+     *     Propagates exceptions from the allocator and the constructor,
+     *     in which case nothing is leaked.
+     */
+    template <
+        class T,
+        bool weakable = false,
+        template <class> class A = DefaultAllocator,
+        class... Args
+    >
+    auto make_rc(Args&&... args) -> Rc<T, weakable>
+        requires std::is_constructible_v<T, Args&&...>
+    {
+        return dtl::make_counted<T, false, weakable, A>(A<T> {}, std::forward<Args>(args)...);
+    }
+
+    template <class T, bool weakable = false, template <class> class A, class U, class... Args>
+    auto make_rc(AllocatorArg, A<U> const& allocator, Args&&... args) -> Rc<T, weakable>
+        requires std::is_constructible_v<T, Args&&...>
+    {
+        return dtl::make_counted<T, false, weakable, A>(allocator, std::forward<Args>(args)...);
+    }
+
+    template <
+        class T,
+        bool weakable = false,
+        template <class> class A = DefaultAllocator,
+        class... Args
+    >
+    auto make_arc(Args&&... args) -> Arc<T, weakable>
+        requires std::is_constructible_v<T, Args&&...>
+    {
+        return dtl::make_counted<T, true, weakable, A>(A<T> {}, std::forward<Args>(args)...);
+    }
+
+    template <class T, bool weakable = false, template <class> class A, class U, class... Args>
+    auto make_arc(AllocatorArg, A<U> const& allocator, Args&&... args) -> Arc<T, weakable>
+        requires std::is_constructible_v<T, Args&&...>
+    {
+        return dtl::make_counted<T, true, weakable, A>(allocator, std::forward<Args>(args)...);
+    }
+
+
+    /* Description:
+     *     A base for types which embed their own reference count, for
+     *     use with `bu::IntrusivePtr`. The count starts at zero and the
+     *     first `IntrusivePtr` to the object takes the first reference.
+     *     Copying the object does not copy its count.
+     */
+    template <bool atomic = false>
+    class [[nodiscard]] IntrusiveCount {
+        mutable dtl::RefCount<atomic> m_count { 0 };
+    public:
+        IntrusiveCount() = default;
+        constexpr IntrusiveCount(IntrusiveCount const&) noexcept {}
+        constexpr auto operator=(IntrusiveCount const&) noexcept -> IntrusiveCount& {
+            return *this;
+        }
+
+        constexpr auto retain() const noexcept -> void {
+            m_count.increment();
+        }
+        // Returns true if this released the last reference
+        [[nodiscard]]
+        constexpr auto release() const noexcept -> bool {
+            return m_count.decrement();
+        }
+        [[nodiscard]]
+        constexpr auto use_count() const noexcept -> Usize {
+            return m_count.load();
+        }
+    };
+
+    template <class T>
+    concept intrusively_counted = requires (T const& t) {
+        { t.retain() } noexcept;
+        { t.release() } noexcept -> std::same_as<bool>;
+    };
+
+    /* Description:
+     *     A reference-counted pointer to an object which holds its own
+     *     count, for example by deriving from `bu::IntrusiveCount`. It
+     *     is the size of a raw pointer, a new reference can be made from
+     *     a raw pointer to the object, and the object is allocated by
+     *     the user. When the last reference is released the object is
+     *     passed to `Deleter`.
+     */
+    template <intrusively_counted T, class Deleter = DefaultDeleter<T>>
+    class [[nodiscard]] IntrusivePtr {
+        [[no_unique_address]]
+        Deleter m_deleter;
+        T*      m_pointer = nullptr;
+    public:
+        using PointeeType = T;
+        using DeleterType = Deleter;
+
+        IntrusivePtr() = default;
+
+        // Takes a new reference to `*pointer`, which may be null
+        constexpr explicit IntrusivePtr(T* const pointer) noexcept
+            : m_pointer { pointer }
+        {
+            if (m_pointer)
+                m_pointer->retain();
+        }
+        constexpr IntrusivePtr(T* const pointer, Deleter deleter) noexcept
+            : m_deleter { std::move(deleter) }
+            , m_pointer { pointer }
+        {
+            if (m_pointer)
+                m_pointer->retain();
+        }
+
+        constexpr IntrusivePtr(IntrusivePtr const& other) noexcept
+            : m_deleter { other.m_deleter }
+            , m_pointer { other.m_pointer }
+        {
+            if (m_pointer)
+                m_pointer->retain();
+        }
+        constexpr IntrusivePtr(IntrusivePtr&& other) noexcept
+            : m_deleter { std::move(other.m_deleter) }
+            , m_pointer { BU exchange(other.m_pointer, nullptr) } {}
+
+        constexpr auto operator=(IntrusivePtr const& other) noexcept -> IntrusivePtr& {
+            IntrusivePtr copy = other;
+            swap(copy);
+            return *this;
+        }
+        constexpr auto operator=(IntrusivePtr&& other) noexcept -> IntrusivePtr& {
+            if (this != &other) {
+                reset();
+                m_pointer = BU exchange(other.m_pointer, nullptr);
+                if constexpr (std::is_move_assignable_v<Deleter>) {
+                    m_deleter = std::move(other.m_deleter);
+                }
+            }
+            return *this;
+        }
+
+        constexpr ~IntrusivePtr() {
+            reset();
+        }
+
+        constexpr auto reset() noexcept -> void {
+            if (T* const pointer = BU exchange(m_pointer, nullptr)) {
+                if (pointer->release())
+                    m_deleter(pointer);
+            }
+        }
+
+        [[nodiscard]]
+        constexpr auto operator*() const noexcept -> T& {
+            assert(m_pointer);
+            return *m_pointer;
+        }
+        [[nodiscard]]
+        constexpr auto operator->() const noexcept -> T* {
+            assert(m_pointer);
+            return m_pointer;
+        }
+        [[nodiscard]]
+        constexpr auto get() const noexcept -> T* {
+            return m_pointer;
+        }
+        [[nodiscard]]
+        constexpr explicit operator bool() const noexcept {
+            return m_pointer != nullptr;
+        }
+
+        constexpr auto swap(IntrusivePtr& other) noexcept -> void {
+            BU swap(m_pointer, other.m_pointer);
+            if constexpr (swappable<Deleter>) {
+                BU swap(m_deleter, other.m_deleter);
+            }
+        }
+
+        constexpr auto operator==(IntrusivePtr const& other) const noexcept -> bool {
+            return m_pointer == other.m_pointer;
+        }
+        constexpr auto operator==(std::nullptr_t) const noexcept -> bool {
+            return m_pointer == nullptr;
+        }
+    };
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "array.hpp"
+#include "option.hpp"
+#include "result.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+/* Binary format
+ *
+ * Values are encoded in native byte order. Every value is aligned to its
+ * natural alignment relative to the start of the buffer, so a buffer whose
+ * start is suitably aligned (heap storage, or a page-aligned mapping) can be
+ * viewed in place without decoding.
+ *
+ * - Trivially copyable types are written as their object representation,
+ *   except those which hold addresses, see `bu::is_bytewise_serializable`.
+ * - `Option<T>` is a one byte flag followed by the value, if present.
+ * - `Result<G, B>` is a one byte flag followed by either alternative.
+ * - `Vector<T>` of trivially copyable `T` is a 64-bit element count followed
+ *   by the elements, written with a single bulk copy.
+ * - `Vector<T>` of any other `T` is a 64-bit element count, the offset of an
+ *   offset table, the serialized elements, and the offset table itself. Each
+ *   offset is relative to the start of the vector, which gives views random
+ *   access to nested elements.
+ */
+
+
+namespace bu {
+    using BadSerialization = StatelessException<"bad serialization">;
+
+    class [[nodiscard]] SerialWriter {
+        Vector<std::byte>* m_buffer;
+    public:
+        constexpr explicit SerialWriter(Vector<std::byte>& buffer) noexcept
+            : m_buffer { &buffer } {}
+
+        [[nodiscard]]
+        constexpr auto position() const noexcept -> Usize {
+            return m_buffer->size();
+        }
+
+        // Pads the buffer with zero bytes until `position() % alignment == 0`
+        constexpr auto align(Usize const alignment) -> void {
+            while (position() % alignment != 0) {
+                m_buffer->append(std::byte {});
+            }
+        }
+
+        auto write_bytes(void const* const data, Usize const count) -> void {
+            m_buffer->extend(Span<std::byte const> { static_cast<std::byte const*>(data), count });
+        }
+
+        template <class T>
+        auto write(T const& value) -> void
+            requires std::is_trivially_copyable_v<T>
+        {
+            align(alignof(T));
+            write_bytes(std::addressof(value), sizeof value);
+        }
+
+        // Overwrites a value previously written at `where`
+        template <class T>
+        auto patch(Usize const where, T const& value) -> void
+            requires std::is_trivially_copyable_v<T>
+        {
+            assert(where + sizeof value <= position());
+            std::memcpy(m_buffer->data() + where, std::addressof(value), sizeof value);
+        }
+    };
+
+    class [[nodiscard]] SerialReader {
+        Span<std::byte const> m_buffer;
+        Usize                 m_position = 0;
+    public:
+        constexpr explicit SerialReader(Span<std::byte const> const buffer) noexcept
+            : m_buffer { buffer } {}
+
+        [[nodiscard]]
+        constexpr auto position() const noexcept -> Usize {
+            return m_position;
+        }
+        [[nodiscard]]
+        constexpr auto buffer() const noexcept -> Span<std::byte const> {
+            return m_buffer;
+        }
+
+        constexpr auto seek(Usize const where) -> void {
+            if (where > m_buffer.size())
+                throw BadSerialization {};
+            m_position = where;
+        }
+
+        constexpr auto align(Usize const alignment) -> void {
+            seek((m_position + alignment - 1) / alignment * alignment);
+        }
+
+        // Consumes `count` bytes and returns a pointer to them within the buffer
+        [[nodiscard]]
+        constexpr auto read_bytes(Usize const count) -> std::byte const* {
+            if (count > m_buffer.size() - m_position)
+                throw BadSerialization {};
+            return m_buffer.data() + std::exchange(m_position, m_position + count);
+        }
+
+        template <class T> [[nodiscard]]
+        auto read() -> T
+            requires std::is_trivially_copyable_v<T>
+        {
+            align(alignof(T));
+            T value;
+            std::memcpy(std::addressof(value), read_bytes(sizeof value), sizeof value);
+            return value;
+        }
+
+        /* Description:
+         *     Consumes `count` consecutive values of type `T` and returns
+         *     a pointer to the first one within the buffer.
+         *
+         * Exceptions:
+         *     Throws `bu::BadSerialization` if the buffer is too short, or
+         *     if the values are not suitably aligned in memory because the
+         *     buffer itself is misaligned.
+         */
+        template <class T> [[nodiscard]]
+        auto view(Usize const count = 1) -> T const*
+            requires std::is_trivially_copyable_v<T>
+        {
+            align(alignof(T));
+            if (count > (m_buffer.size() - m_position) / sizeof(T))
+                throw BadSerialization {};
+            std::byte const* const bytes = read_bytes(count * sizeof(T));
+            if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(T) != 0)
+                throw BadSerialization {};
+            return std::launder(reinterpret_cast<T const*>(bytes));
+        }
+    };
+
+
+    /* Specializations provide
+     *     static auto write(SerialWriter&, T const&) -> void;
+     *     static auto read(SerialReader&) -> T;
+     * and optionally, for zero-copy access,
+     *     static auto view(SerialReader&) -> <view type>;
+     */
+    template <class T>
+    struct Serializer;
+
+    template <class T>
+    concept serializable = requires (SerialWriter& writer, SerialReader& reader, T const& value) {
+        Serializer<T>::write(writer, value);
+        { Serializer<T>::read(reader) } -> std::same_as<T>;
+    };
+
+    template <class T>
+    concept viewable = serializable<T> && requires (SerialReader& reader) {
+        Serializer<T>::view(reader);
+    };
+
+    template <viewable T>
+    using SerialView = decltype(Serializer<T>::view(std::declval<SerialReader&>()));
+
+    /* Whether `T` is serialized as its object representation. Addresses are
+     * meaningless once written out, so pointers and the views of this
+     * library are excluded. Whether a trivially copyable class holds a
+     * pointer can not be detected, so such classes must opt out by
+     * specializing this as `false`.
+     */
+    template <class T>
+    constexpr bool is_bytewise_serializable = std::is_trivially_copyable_v<T>
+        && !std::is_pointer_v<T>
+        && !std::is_member_pointer_v<T>;
+
+    template <class T>
+    constexpr bool is_bytewise_serializable<Span<T>> = false;
+    template <class T, class S>
+    constexpr bool is_bytewise_serializable<Option<T&, S>> = false;
+    template <class T, Usize extent>
+    constexpr bool is_bytewise_serializable<Array<T, extent>> = is_bytewise_serializable<T>;
+
+    namespace dtl {
+        template <class T>
+        concept bulk_serializable = is_bytewise_serializable<T>;
+    }
+
+
+    template <dtl::bulk_serializable T>
+    struct Serializer<T> {
+        static auto write(SerialWriter& writer, T const& value) -> void {
+            writer.write(value);
+        }
+        static auto read(SerialReader& reader) -> T {
+            return reader.read<T>();
+        }
+        static auto view(SerialReader& reader) -> T const& {
+            return *reader.view<T>();
+        }
+    };
+
+    template <serializable T, Usize extent>
+        requires (!dtl::bulk_serializable<Array<T, extent>>)
+    struct Serializer<Array<T, extent>> {
+        static auto write(SerialWriter& writer, Array<T, extent> const& array) -> void {
+            for (T const& element : array) {
+                Serializer<T>::write(writer, element);
+            }
+        }
+        static auto read(SerialReader& reader) -> Array<T, extent> {
+            return [&]<Usize... indices>(std::index_sequence<indices...>) {
+                // Braced initialization guarantees left-to-right evaluation
+                return Array<T, extent> {
+                    (static_cast<void>(indices), Serializer<T>::read(reader))...
+                };
+            }(std::make_index_sequence<extent> {});
+        }
+    };
+
+    template <serializable T, std::integral S>
+    struct Serializer<Option<T, S>> {
+        static auto write(SerialWriter& writer, Option<T, S> const& option) -> void {
+            writer.write(static_cast<std::uint8_t>(option.has_value()));
+            if (option)
+                Serializer<T>::write(writer, option.value());
+        }
+        static auto read(SerialReader& reader) -> Option<T, S> {
+            if (reader.read<std::uint8_t>())
+                return Option<T, S> { in_place, Serializer<T>::read(reader) };
+            else
+                return nullopt;
+        }
+        static auto view(SerialReader& reader)
+            requires viewable<T>
+        {
+            if (reader.read<std::uint8_t>())
+                return Option<SerialView<T>> { Serializer<T>::view(reader) };
+            else
+                return Option<SerialView<T>> { nullopt };
+        }
+    };
+
+    template <serializable Good, serializable Bad, std::integral S>
+    struct Serializer<Result<Good, Bad, S>> {
+        static auto write(SerialWriter& writer, Result<Good, Bad, S> const& result) -> void {
+            writer.write(static_cast<std::uint8_t>(result.is_ok()));
+            if (result)
+                Serializer<Good>::write(writer, result.value());
+            else
+                Serializer<Bad>::write(writer, result.error());
+        }
+        static auto read(SerialReader& reader) -> Result<Good, Bad, S> {
+            if (reader.read<std::uint8_t>())
+                return Ok<Good> { Serializer<Good>::read(reader) };
+            else
+                return Err<Bad> { Serializer<Bad>::read(reader) };
+        }
+    };
+
+
+    // In-place view of a serialized `Vector<T>` whose elements are not trivially copyable
+    template <viewable T>
+    class [[nodiscard]] SerialVectorView {
+        Span<std::byte const>  m_buffer;
+        Usize                  m_start;
+        std::uint64_t const*   m_offsets;
+        Usize                  m_len;
+    public:
+        constexpr SerialVectorView(
+            Span<std::byte const> const buffer,
+            Usize                 const start,
+            std::uint64_t const*  const offsets,
+            Usize                 const length) noexcept
+            : m_buffer  { buffer }
+            , m_start   { start }
+            , m_offsets { offsets }
+            , m_len     { length } {}
+
+        [[nodiscard]]
+        constexpr auto size() const noexcept -> Usize {
+            return m_len;
+        }
+        [[nodiscard]]
+        constexpr auto is_empty() const noexcept -> bool {
+            return m_len == 0;
+        }
+        [[nodiscard]]
+        auto operator[](Usize const index) const -> SerialView<T> {
+            if (index >= m_len)
+                throw OutOfRange {};
+            SerialReader reader { m_buffer };
+            reader.seek(m_start + m_offsets[index]);
+            return Serializer<T>::view(reader);
+        }
+    };
+
+    template <serializable T, class A>
+    struct Serializer<Vector<T, A>> {
+        static auto write(SerialWriter& writer, Vector<T, A> const& vector) -> void {
+            writer.align(alignof(std::uint64_t));
+            Usize const start = writer.position();
+            writer.write(static_cast<std::uint64_t>(vector.size()));
+
+            if constexpr (dtl::bulk_serializable<T>) {
+                writer.align(alignof(T));
+                writer.write_bytes(vector.data(), vector.size() * sizeof(T));
+            }
+            else {
+                Usize const table_field = writer.position();
+                writer.write(std::uint64_t {});
+
+                Vector<std::uint64_t> offsets;
+                offsets.reserve(vector.size());
+                for (T const& element : vector) {
+                    offsets.append(writer.position() - start);
+                    Serializer<T>::write(writer, element);
+                }
+
+                writer.align(alignof(std::uint64_t));
+                writer.patch(table_field, static_cast<std::uint64_t>(writer.position() - start));
+                writer.write_bytes(offsets.data(), offsets.size() * sizeof(std::uint64_t));
+            }
+        }
+
+        static auto read(SerialReader& reader) -> Vector<T, A> {
+            auto const length = checked_length(reader.read<std::uint64_t>());
+
+            if constexpr (dtl::bulk_serializable<T>) {
+                // Copied bytewise rather than viewed, so the buffer need not be aligned in memory
+                reader.align(alignof(T));
+                if (length > (reader.buffer().size() - reader.position()) / sizeof(T))
+                    throw BadSerialization {};
+                Vector<T, A> vector;
+                vector.extend_bytes(reader.read_bytes(length * sizeof(T)), length);
+                return vector;
+            }
+            else {
+                (void)reader.read<std::uint64_t>(); // The offset table is only needed by views
+                // Every element has an entry in the offset table, which bounds a plausible length
+                if (length > (reader.buffer().size() - reader.position()) / sizeof(std::uint64_t))
+                    throw BadSerialization {};
+                Vector<T, A> vector;
+                vector.reserve(length);
+                for (Usize i = 0; i != length; ++i) {
+                    vector.append(Serializer<T>::read(reader));
+                }
+                reader.align(alignof(std::uint64_t));
+                (void)reader.read_bytes(length * sizeof(std::uint64_t));
+                return vector;
+            }
+        }
+
+        static auto view(SerialReader& reader)
+            requires dtl::bulk_serializable<T> || viewable<T>
+        {
+            if constexpr (dtl::bulk_serializable<T>) {
+                auto const length = checked_length(reader.read<std::uint64_t>());
+                return Span<T const> { reader.view<T>(length), length };
+            }
+            else {
+                reader.align(alignof(std::uint64_t));
+                Usize const start        = reader.position();
+                auto  const length       = checked_length(reader.read<std::uint64_t>());
+                auto  const table_offset = reader.read<std::uint64_t>();
+
+                reader.seek(start + static_cast<Usize>(table_offset));
+                std::uint64_t const* const offsets = reader.view<std::uint64_t>(length);
+                return SerialVectorView<T> { reader.buffer(), start, offsets, length };
+            }
+        }
+    private:
+        static auto checked_length(std::uint64_t const length) -> Usize {
+            if (length > maximum<Usize>)
+                throw BadSerialization {};
+            return static_cast<Usize>(length);
+        }
+    };
+
+
+    template <serializable T>
+    auto serialize(T const& value, Vector<std::byte>& buffer) -> void {
+        SerialWriter writer { buffer };
+        Serializer<T>::write(writer, value);
+    }
+
+    template <serializable T> [[nodiscard]]
+    auto serialize(T const& value) -> Vector<std::byte> {
+        Vector<std::byte> buffer;
+        serialize(value, buffer);
+        return buffer;
+    }
+
+    template <serializable T> [[nodiscard]]
+    auto deserialize(Span<std::byte const> const bytes) -> T {
+        SerialReader reader { bytes };
+        return Serializer<T>::read(reader);
+    }
+
+    /* Description:
+     *     Accesses a serialized value in place without decoding it. A
+     *     serialized `Vector<T>` of trivially copyable `T` is viewed as a
+     *     `bu::Span<T const>` directly over `bytes`, which may be a buffer
+     *     or a `bu::MappedFile`.
+     *
+     * Exceptions:
+     *     Throws `bu::BadSerialization` if `bytes` is truncated or is not
+     *     suitably aligned for the viewed types.
+     *
+     * Preconditions:
+     *     The returned view refers to `bytes`, which must outlive it.
+     */
+    template <viewable T> [[nodiscard]]
+    auto view_serialized(Span<std::byte const> const bytes) -> SerialView<T> {
+        SerialReader reader { bytes };
+        return Serializer<T>::view(reader);
+    }
+}
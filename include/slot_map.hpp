@@ -0,0 +1,239 @@
+#pragma once
+
+#include "utility.hpp"
+#include "allocator.hpp"
+#include "option.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+
+
+namespace bu {
+    /* Description:
+     *     A handle to a value of a `bu::SlotMap`. A key is invalidated
+     *     when its value is erased, and an invalidated key never refers
+     *     to another value, even if its slot is reused. A default
+     *     constructed key never refers to any value.
+     */
+    class [[nodiscard]] SlotMapKey {
+        std::uint32_t m_index      = 0;
+        std::uint32_t m_generation = 0;
+    public:
+        SlotMapKey() = default;
+
+        constexpr explicit SlotMapKey(std::uint32_t const index, std::uint32_t const generation)
+            noexcept
+            : m_index      { index }
+            , m_generation { generation } {}
+
+        [[nodiscard]]
+        constexpr auto index() const noexcept -> std::uint32_t {
+            return m_index;
+        }
+        [[nodiscard]]
+        constexpr auto generation() const noexcept -> std::uint32_t {
+            return m_generation;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(SlotMapKey const&) const noexcept -> bool = default;
+    };
+
+
+    /* Description:
+     *     An associative container which generates its own keys. Values
+     *     are stored contiguously in a `bu::Vector`, so iteration visits
+     *     only live values, without holes. Insertion, erasure and lookup
+     *     are O(1). Erasure moves the last value into the erased position,
+     *     so the order of iteration is unspecified.
+     *
+     *     Each slot carries a generation which is odd while the slot is
+     *     occupied, and which is advanced whenever the slot is vacated
+     *     or filled. A key matches its slot only if the generations are
+     *     equal, so stale keys are detected without any extra storage.
+     *     A slot whose generation wraps around when it is vacated is
+     *     retired rather than reused, so that keys issued before the
+     *     wrap can never match it again. This costs one `Slot` per
+     *     2^31 reuses of a slot.
+     */
+    template <class T, allocator_for<T> A = DefaultAllocator<T>>
+    class [[nodiscard]] SlotMap {
+        struct Slot {
+            // Index into the dense arrays if occupied, the next free slot otherwise
+            std::uint32_t position;
+            std::uint32_t generation; // Odd if occupied
+        };
+
+        static constexpr std::uint32_t no_free_slot = maximum<std::uint32_t>;
+
+        Vector<T, A>       m_values;
+        Vector<SlotMapKey> m_keys; // The key of each value, parallel to `m_values`
+        Vector<Slot>       m_slots;
+        std::uint32_t      m_free_head = no_free_slot;
+    public:
+        using ContainedType = T;
+        using AllocatorType = A;
+        using SizeType      = Usize;
+        using Key           = SlotMapKey;
+        using Iterator      = T*;
+        using Sentinel      = Iterator;
+        using ConstIterator = T const*;
+        using ConstSentinel = ConstIterator;
+
+        SlotMap() = default;
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_values.size();
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_values.is_empty();
+        }
+
+        auto reserve(Usize const capacity) -> void {
+            m_values.reserve(capacity);
+            m_keys.reserve(capacity);
+            m_slots.reserve(capacity);
+        }
+
+        /* Description:
+         *     Constructs a value in place and returns its key.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(Args&&...)
+         *     - A::allocate(bu::Usize)
+         *     The map is unchanged if an exception is thrown.
+         */
+        template <class... Args>
+        auto emplace(Args&&... args) -> Key
+            requires std::constructible_from<T, Args&&...>
+        {
+            auto const position = static_cast<std::uint32_t>(m_values.size());
+            reserve_one(m_keys);
+            if (m_free_head == no_free_slot)
+                reserve_one(m_slots);
+            m_values.append(std::forward<Args>(args)...);
+
+            // Nothing below can throw
+            std::uint32_t index;
+            if (m_free_head != no_free_slot) {
+                index       = m_free_head;
+                m_free_head = m_slots.data()[index].position;
+            }
+            else {
+                index = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.append(Slot { 0, 0 });
+            }
+            Slot& slot = m_slots.data()[index];
+            slot.position = position;
+            ++slot.generation;
+
+            Key const key { index, slot.generation };
+            m_keys.append(key);
+            return key;
+        }
+        auto insert(T value) -> Key {
+            return emplace(std::move(value));
+        }
+
+        /* Description:
+         *     Removes the value referred to by `key`, if `key` is valid.
+         *     The last value is moved into its position.
+         *
+         * Return value:
+         *     The removed value, if any.
+         */
+        auto erase(Key const key) -> Option<T> {
+            if (!contains(key))
+                return nullopt;
+
+            Slot& slot = m_slots.data()[key.index()];
+            std::uint32_t const position = slot.position;
+            std::uint32_t const last     = static_cast<std::uint32_t>(m_values.size() - 1);
+
+            Option<T> removed { in_place, std::move(m_values.data()[position]) };
+            if (position != last) {
+                m_values.data()[position] = std::move(m_values.data()[last]);
+                SlotMapKey const moved    = m_keys.data()[last];
+                m_keys.data()[position]   = moved;
+                m_slots.data()[moved.index()].position = position;
+            }
+            m_values.pop_back();
+            m_keys.pop_back();
+
+            vacate(key.index());
+            return removed;
+        }
+
+        // Removes every value, invalidating every key
+        auto clear() -> void {
+            for (SlotMapKey const key : m_keys) {
+                vacate(key.index());
+            }
+            m_values.clear();
+            m_keys.clear();
+        }
+
+        [[nodiscard]]
+        auto contains(Key const key) const noexcept -> bool {
+            return key.index() < m_slots.size()
+                && m_slots.data()[key.index()].generation == key.generation()
+                && (key.generation() & 1) != 0;
+        }
+
+        [[nodiscard]]
+        auto find(Key const key) const noexcept -> Option<T const&> {
+            if (contains(key))
+                return m_values.data()[m_slots.data()[key.index()].position];
+            else
+                return nullopt;
+        }
+        [[nodiscard]]
+        auto find(Key const key) noexcept -> Option<T&> {
+            if (contains(key))
+                return m_values.data()[m_slots.data()[key.index()].position];
+            else
+                return nullopt;
+        }
+
+        // The values, densely packed, in iteration order
+        [[nodiscard]]
+        auto values() const noexcept -> Span<T const> {
+            return Span<T const> { m_values.data(), m_values.size() };
+        }
+        [[nodiscard]]
+        auto values() noexcept -> Span<T> {
+            return Span<T> { m_values.data(), m_values.size() };
+        }
+
+        // The keys of the values, parallel to `values()`
+        [[nodiscard]]
+        auto keys() const noexcept -> Span<Key const> {
+            return Span<Key const> { m_keys.data(), m_keys.size() };
+        }
+
+        [[nodiscard]] auto begin() const noexcept -> ConstIterator { return m_values.begin(); }
+        [[nodiscard]] auto begin()       noexcept -> Iterator      { return m_values.begin(); }
+
+        [[nodiscard]] auto end() const noexcept -> ConstSentinel { return m_values.end(); }
+        [[nodiscard]] auto end()       noexcept -> Sentinel      { return m_values.end(); }
+    private:
+        // Invalidates the keys of a slot and returns it to the free list, unless its
+        // generation wrapped
+        auto vacate(std::uint32_t const index) noexcept -> void {
+            Slot& slot = m_slots.data()[index];
+            if (++slot.generation == 0)
+                return; // Retired, its generation stays even so that no key matches it
+            slot.position = m_free_head;
+            m_free_head   = index;
+        }
+
+        // Makes room for one more element, growing geometrically like `bu::Vector::append`
+        template <class U>
+        static auto reserve_one(Vector<U>& vector) -> void {
+            if (vector.size() == vector.capacity())
+                vector.reserve(vector.capacity() ? vector.capacity() * 2 : 4);
+        }
+    };
+}
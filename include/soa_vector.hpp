@@ -0,0 +1,521 @@
+#pragma once
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "allocator.hpp"
+#include "memory.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+    // The array of the field at position `index` of a `bu::BasicSoaVector`
+    template <Usize index, class T, class A>
+    struct SoaColumn {
+        [[no_unique_address]]
+        A  allocator;
+        T* pointer = nullptr;
+    };
+
+    template <class Indices, template <class> class Allocator, class... Fields>
+    struct SoaColumns;
+
+    template <Usize... indices, template <class> class Allocator, class... Fields>
+    struct SoaColumns<std::index_sequence<indices...>, Allocator, Fields...>
+        : SoaColumn<indices, Fields, Allocator<Fields>>... {};
+
+    // Selects the column at `index` by deducing the corresponding base of `bu::dtl::SoaColumns`
+    template <Usize index, class T, class A>
+    constexpr auto column_at(SoaColumn<index, T, A>& column) noexcept -> SoaColumn<index, T, A>& {
+        return column;
+    }
+    template <Usize index, class T, class A>
+    constexpr auto column_at(SoaColumn<index, T, A> const& column)
+        noexcept -> SoaColumn<index, T, A> const&
+    {
+        return column;
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     A reference to one row of a `bu::BasicSoaVector`, that is, to
+     *     the elements at the same position in each field array. Access
+     *     the fields with `row.get<i>()` or a structured binding:
+     *
+     *         for (auto [position, velocity] : particles)
+     *             position += velocity;
+     */
+    template <class Soa>
+    class SoaRow {
+        Soa*  m_soa;
+        Usize m_index;
+    public:
+        constexpr explicit SoaRow(Soa& soa, Usize const index) noexcept
+            : m_soa   { &soa }
+            , m_index { index } {}
+
+        template <Usize field>
+        [[nodiscard]]
+        constexpr auto get() const noexcept -> decltype(auto) {
+            return m_soa->template data<field>()[m_index];
+        }
+
+        [[nodiscard]]
+        constexpr auto index() const noexcept -> Usize {
+            return m_index;
+        }
+    };
+
+    namespace dtl {
+        template <class Soa>
+        class SoaIterator {
+            Soa*  m_soa   = nullptr;
+            Usize m_index = 0;
+        public:
+            using value_type      = SoaRow<Soa>;
+            using difference_type = Isize;
+
+            SoaIterator() = default;
+
+            constexpr explicit SoaIterator(Soa& soa, Usize const index) noexcept
+                : m_soa   { &soa }
+                , m_index { index } {}
+
+            [[nodiscard]]
+            constexpr auto operator*() const noexcept -> SoaRow<Soa> {
+                return SoaRow<Soa> { *m_soa, m_index };
+            }
+            [[nodiscard]]
+            constexpr auto operator[](Isize const offset) const noexcept -> SoaRow<Soa> {
+                return SoaRow<Soa> { *m_soa, m_index + offset };
+            }
+
+            constexpr auto operator++() noexcept -> SoaIterator& {
+                ++m_index;
+                return *this;
+            }
+            constexpr auto operator++(int) noexcept -> SoaIterator {
+                auto copy = *this;
+                ++m_index;
+                return copy;
+            }
+            constexpr auto operator--() noexcept -> SoaIterator& {
+                --m_index;
+                return *this;
+            }
+            constexpr auto operator--(int) noexcept -> SoaIterator {
+                auto copy = *this;
+                --m_index;
+                return copy;
+            }
+
+            constexpr auto operator+=(Isize const offset) noexcept -> SoaIterator& {
+                m_index += offset;
+                return *this;
+            }
+            constexpr auto operator-=(Isize const offset) noexcept -> SoaIterator& {
+                m_index -= offset;
+                return *this;
+            }
+
+            [[nodiscard]]
+            friend constexpr auto operator+(SoaIterator it, Isize const offset)
+                noexcept -> SoaIterator
+            {
+                return it += offset;
+            }
+            [[nodiscard]]
+            friend constexpr auto operator+(Isize const offset, SoaIterator it)
+                noexcept -> SoaIterator
+            {
+                return it += offset;
+            }
+            [[nodiscard]]
+            friend constexpr auto operator-(SoaIterator it, Isize const offset)
+                noexcept -> SoaIterator
+            {
+                return it -= offset;
+            }
+            [[nodiscard]]
+            friend constexpr auto operator-(SoaIterator const a, SoaIterator const b)
+                noexcept -> Isize
+            {
+                return static_cast<Isize>(a.m_index - b.m_index);
+            }
+
+            [[nodiscard]]
+            constexpr auto operator==(SoaIterator const& other) const noexcept -> bool {
+                return m_index == other.m_index;
+            }
+            [[nodiscard]]
+            constexpr auto operator<=>(SoaIterator const& other) const
+                noexcept -> std::strong_ordering
+            {
+                return m_index <=> other.m_index;
+            }
+
+            // Enable conversion of non-const to const iterators
+            [[nodiscard]]
+            constexpr operator SoaIterator<Soa const>() const
+                noexcept requires (!std::is_const_v<Soa>)
+            {
+                return SoaIterator<Soa const> { *m_soa, m_index };
+            }
+        };
+    } // namespace dtl
+
+
+    /* Description:
+     *     A vector of records whose fields are stored in separate arrays,
+     *     one per type in `Fields`, each obtained from `Allocator<Field>`.
+     *     A loop which reads only some of the fields streams through only
+     *     their arrays, so no cache line is wasted on the other fields,
+     *     and `field<i>()` exposes each array as a plain `bu::Span` for
+     *     vectorized kernels. Iteration yields `bu::SoaRow` proxies.
+     *
+     *     `bu::SoaVector` aligns every array to a cache line.
+     */
+    template <template <class> class Allocator, class... Fields>
+        requires (sizeof...(Fields) != 0) && (allocator_for<Allocator<Fields>, Fields> && ...)
+    class [[nodiscard]] BasicSoaVector {
+        using Columns = dtl::SoaColumns<std::index_sequence_for<Fields...>, Allocator, Fields...>;
+
+        Columns m_columns;
+        Usize   m_len = 0;
+        Usize   m_cap = 0;
+    public:
+        static constexpr Usize field_count = sizeof...(Fields);
+
+        template <Usize position>
+        using FieldType = typename Typelist<Fields...>::template At<position>;
+
+        using SizeType      = Usize;
+        using Row           = SoaRow<BasicSoaVector>;
+        using ConstRow      = SoaRow<BasicSoaVector const>;
+        using Iterator      = dtl::SoaIterator<BasicSoaVector>;
+        using Sentinel      = Iterator;
+        using ConstIterator = dtl::SoaIterator<BasicSoaVector const>;
+        using ConstSentinel = ConstIterator;
+
+        BasicSoaVector() = default;
+
+        // Delegates to the default constructor, so that the destructor frees the arrays
+        // if a copy throws
+        BasicSoaVector(BasicSoaVector const& other)
+            : BasicSoaVector {}
+        {
+            for_each_field([&](auto const field) {
+                column<field>().allocator = other.template column<field>().allocator;
+            });
+            reserve(other.m_len);
+            for_each_field_or_rollback(
+                [&](auto const field) {
+                    auto* const source      = other.template data<field>();
+                    auto* const destination = data<field>();
+                    Usize i = 0;
+                    try {
+                        for (; i != other.m_len; ++i) {
+                            std::construct_at(destination + i, source[i]);
+                        }
+                    }
+                    catch (...) {
+                        destroy(destination, destination + i);
+                        throw;
+                    }
+                },
+                [&](auto const field) { destroy(data<field>(), data<field>() + other.m_len); });
+            m_len = other.m_len;
+        }
+
+        BasicSoaVector(BasicSoaVector&& other) noexcept
+            : m_columns { other.m_columns }
+            , m_len     { BU exchange(other.m_len, 0) }
+            , m_cap     { BU exchange(other.m_cap, 0) }
+        {
+            for_each_field([&](auto const field) {
+                other.template column<field>().pointer = nullptr;
+            });
+        }
+
+        auto operator=(BasicSoaVector const& other) -> BasicSoaVector& {
+            if (this != &other) {
+                BasicSoaVector copy = other;
+                swap(copy);
+            }
+            return *this;
+        }
+
+        auto operator=(BasicSoaVector&& other) noexcept -> BasicSoaVector& {
+            if (this != &other) {
+                this->~BasicSoaVector();
+                std::construct_at(this, std::move(other));
+            }
+            return *this;
+        }
+
+        ~BasicSoaVector() {
+            clear();
+            for_each_field([&](auto const field) {
+                deallocate<field>(column<field>().pointer, m_cap);
+            });
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return m_len;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_len == 0;
+        }
+        [[nodiscard]]
+        auto capacity() const noexcept -> Usize {
+            return m_cap;
+        }
+
+        /* Description:
+         *     Ensures that every field array can hold at least
+         *     `new_capacity` elements without reallocating. Elements are
+         *     moved to the new arrays if every field is nothrow move
+         *     constructible, and copied otherwise.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - Allocator<Field>::allocate(bu::Usize)
+         *     - Field::Field(Field const&), if some field is not nothrow move constructible
+         *     The vector is unchanged if an exception is thrown.
+         */
+        auto reserve(Usize const new_capacity) -> void {
+            if (new_capacity <= m_cap)
+                return;
+
+            constexpr bool relocate_by_move = (std::is_nothrow_move_constructible_v<Fields> && ...);
+
+            Columns grown = m_columns;
+            for_each_field_or_rollback(
+                [&](auto const field) {
+                    auto& target   = column_at<field>(grown);
+                    target.pointer = target.allocator.allocate(new_capacity);
+                },
+                [&](auto const field) {
+                    auto& target = column_at<field>(grown);
+                    target.allocator.deallocate(target.pointer, new_capacity);
+                });
+
+            try {
+                for_each_field_or_rollback(
+                    [&](auto const field) {
+                        auto* const source      = data<field>();
+                        auto* const destination = column_at<field>(grown).pointer;
+                        Usize i = 0;
+                        try {
+                            for (; i != m_len; ++i) {
+                                if constexpr (relocate_by_move)
+                                    std::construct_at(destination + i, std::move(source[i]));
+                                else
+                                    std::construct_at(destination + i, std::as_const(source[i]));
+                            }
+                        }
+                        catch (...) {
+                            destroy(destination, destination + i);
+                            throw;
+                        }
+                    },
+                    [&](auto const field) {
+                        auto* const pointer = column_at<field>(grown).pointer;
+                        destroy(pointer, pointer + m_len);
+                    });
+            }
+            catch (...) {
+                for_each_field([&](auto const field) {
+                    auto& target = column_at<field>(grown);
+                    target.allocator.deallocate(target.pointer, new_capacity);
+                });
+                throw;
+            }
+
+            for_each_field([&](auto const field) {
+                destroy(data<field>(), data<field>() + m_len);
+                deallocate<field>(column<field>().pointer, m_cap);
+                column<field>().pointer = column_at<field>(grown).pointer;
+            });
+            m_cap = new_capacity;
+        }
+
+        /* Description:
+         *     Appends a row, constructing each field from the
+         *     corresponding element of `values`, and growing the
+         *     capacity geometrically if the vector is full.
+         *
+         * Return value:
+         *     Reference to the newly constructed row.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - Field::Field(Value&&)
+         *     - Allocator<Field>::allocate(bu::Usize)
+         *     The vector is unchanged if an exception is thrown.
+         *
+         * Preconditions:
+         *     `values` must not refer to elements of `this`.
+         */
+        template <class... Values>
+            requires (sizeof...(Values) == sizeof...(Fields))
+                  && (std::constructible_from<Fields, Values&&> && ...)
+        auto append(Values&&... values) -> Row {
+            if (m_len == m_cap)
+                reserve(m_cap ? m_cap * 2 : 4);
+
+            [&]<Usize... fields>(std::index_sequence<fields...>) {
+                Usize constructed = 0;
+                try {
+                    ((std::construct_at(data<fields>() + m_len, std::forward<Values>(values)),
+                        ++constructed), ...);
+                }
+                catch (...) {
+                    ((fields < constructed ? destroy(data<fields>()[m_len]) : void()), ...);
+                    throw;
+                }
+            }(std::index_sequence_for<Fields...> {});
+
+            return Row { *this, m_len++ };
+        }
+
+        auto pop_back() noexcept -> void {
+            assert(m_len != 0);
+            --m_len;
+            for_each_field([&](auto const field) { destroy(data<field>()[m_len]); });
+        }
+
+        auto clear() noexcept -> void {
+            for_each_field([&](auto const field) {
+                destroy(data<field>(), data<field>() + m_len);
+            });
+            m_len = 0;
+        }
+
+        // The array of the field at `position`
+        template <Usize position>
+        [[nodiscard]]
+        auto data() const noexcept -> FieldType<position> const* {
+            return column<position>().pointer;
+        }
+        template <Usize position>
+        [[nodiscard]]
+        auto data() noexcept -> FieldType<position>* {
+            return column<position>().pointer;
+        }
+
+        template <Usize position>
+        [[nodiscard]]
+        auto field() const noexcept -> Span<FieldType<position> const> {
+            return Span<FieldType<position> const> { data<position>(), m_len };
+        }
+        template <Usize position>
+        [[nodiscard]]
+        auto field() noexcept -> Span<FieldType<position>> {
+            return Span<FieldType<position>> { data<position>(), m_len };
+        }
+
+        [[nodiscard]]
+        auto operator[](Usize const index) const -> ConstRow {
+            if (index < m_len)
+                return ConstRow { *this, index };
+            else
+                throw OutOfRange {};
+        }
+        [[nodiscard]]
+        auto operator[](Usize const index) -> Row {
+            if (index < m_len)
+                return Row { *this, index };
+            else
+                throw OutOfRange {};
+        }
+
+        [[nodiscard]]
+        auto begin() const noexcept -> ConstIterator {
+            return ConstIterator { *this, 0 };
+        }
+        [[nodiscard]]
+        auto begin() noexcept -> Iterator {
+            return Iterator { *this, 0 };
+        }
+
+        [[nodiscard]]
+        auto end() const noexcept -> ConstSentinel {
+            return ConstSentinel { *this, m_len };
+        }
+        [[nodiscard]]
+        auto end() noexcept -> Sentinel {
+            return Sentinel { *this, m_len };
+        }
+
+        auto swap(BasicSoaVector& other) noexcept -> void {
+            BU swap(m_columns, other.m_columns);
+            BU swap(m_len, other.m_len);
+            BU swap(m_cap, other.m_cap);
+        }
+    private:
+        template <Usize position>
+        [[nodiscard]]
+        auto column() const noexcept -> auto const& {
+            return dtl::column_at<position>(m_columns);
+        }
+        template <Usize position>
+        [[nodiscard]]
+        auto column() noexcept -> auto& {
+            return dtl::column_at<position>(m_columns);
+        }
+
+        template <Usize position>
+        static auto column_at(Columns& columns) noexcept -> auto& {
+            return dtl::column_at<position>(columns);
+        }
+
+        template <Usize position>
+        auto deallocate(FieldType<position>* const pointer, Usize const count) noexcept -> void {
+            if (pointer)
+                column<position>().allocator.deallocate(pointer, count);
+        }
+
+        // Invokes `f(std::integral_constant<bu::Usize, field>)` for each field position
+        template <class F>
+        static auto for_each_field(F&& f) -> void {
+            [&]<Usize... fields>(std::index_sequence<fields...>) {
+                (f(std::integral_constant<Usize, fields> {}), ...);
+            }(std::index_sequence_for<Fields...> {});
+        }
+
+        // Like `for_each_field` with `apply`, but if it throws, invokes `undo` for the fields
+        // already applied
+        template <class Apply, class Undo>
+        static auto for_each_field_or_rollback(Apply&& apply, Undo&& undo) -> void {
+            [&]<Usize... fields>(std::index_sequence<fields...>) {
+                Usize applied = 0;
+                try {
+                    ((apply(std::integral_constant<Usize, fields> {}), ++applied), ...);
+                }
+                catch (...) {
+                    ((fields < applied
+                        ? undo(std::integral_constant<Usize, fields> {})
+                        : void()), ...);
+                    throw;
+                }
+            }(std::index_sequence_for<Fields...> {});
+        }
+    };
+
+    template <class... Fields>
+    using SoaVector = BasicSoaVector<AlignedAllocator, Fields...>;
+}
+
+
+template <class Soa>
+struct std::tuple_size<bu::SoaRow<Soa>>
+    : std::integral_constant<std::size_t, std::remove_const_t<Soa>::field_count> {};
+
+template <std::size_t field, class Soa>
+struct std::tuple_element<field, bu::SoaRow<Soa>> {
+    using type = decltype(std::declval<bu::SoaRow<Soa> const&>().template get<field>());
+};
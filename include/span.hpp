@@ -5,6 +5,16 @@
 
 
 namespace bu {
+    template <class T>
+    class Span;
+
+    namespace dtl {
+        template <class>
+        constexpr bool is_span = false;
+        template <class T>
+        constexpr bool is_span<Span<T>> = true;
+    }
+
     struct BadSlice : Exception {
         auto message() const noexcept -> char const* override {
             return "bad slice operation";
@@ -35,6 +45,45 @@ namespace bu {
             : m_ptr { array.data() }
             , m_len { n } {}
 
+        // View any contiguous container, such as `bu::Vector`
+        template <class C>
+            requires (!dtl::is_span<std::remove_cv_t<C>>)
+                  && requires (C& container) {
+                      { container.data() } -> std::convertible_to<T*>;
+                      { container.size() } -> std::convertible_to<Usize>;
+                  }
+        constexpr Span(C& container) noexcept
+            : m_ptr { container.data() }
+            , m_len { static_cast<Usize>(container.size()) } {}
+
+        // Enable conversion of mutable to const spans
+        template <class U>
+            requires std::same_as<T, U const>
+        constexpr Span(Span<U> const other) noexcept
+            : m_ptr { other.data() }
+            , m_len { other.size() } {}
+
+        [[nodiscard]]
+        constexpr auto size() const noexcept -> Usize {
+            return m_len;
+        }
+        [[nodiscard]]
+        constexpr auto is_empty() const noexcept -> bool {
+            return m_len == 0;
+        }
+        [[nodiscard]]
+        constexpr auto data() const noexcept -> T* {
+            return m_ptr;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator[](Usize const index) const -> T& {
+            if (index < m_len)
+                return m_ptr[index];
+            else
+                throw OutOfRange {};
+        }
+
         constexpr auto remove_prefix(Usize const off) -> void {
             if (m_len < off) {
                 throw BadSlice {};
@@ -66,4 +115,7 @@ namespace bu {
             return m_ptr + m_len;
         }
     };
+
+    template <class C>
+    Span(C&) -> Span<std::remove_pointer_t<decltype(std::declval<C&>().data())>>;
 }
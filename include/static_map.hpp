@@ -0,0 +1,218 @@
+#pragma once
+
+#include "utility.hpp"
+#include "array.hpp"
+#include "option.hpp"
+#include "string.hpp"
+#include "hash.hpp"
+
+
+namespace bu {
+    // An entry of a `bu::StaticMap`, associating the literal `key_text` with `entry_value`
+    template <Metastring key_text, auto entry_value>
+    struct StaticEntry {
+        static constexpr StringView key { key_text.string(), key_text.size() };
+        static constexpr auto       value = entry_value;
+    };
+}
+
+
+namespace bu::dtl {
+    [[nodiscard]]
+    constexpr auto perfect_hash_bucket_count(Usize const key_count) noexcept -> Usize {
+        return (key_count + 1) / 2; // Two keys per bucket keeps the compile-time search short
+    }
+
+    [[nodiscard]]
+    constexpr auto perfect_hash_slot(
+        std::uint64_t const hash,
+        std::uint32_t const displacement,
+        Usize         const key_count) noexcept -> Usize
+    {
+        return reduce_range(mix64(hash + displacement * 0x9e3779b97f4a7c15), key_count);
+    }
+
+    template <Usize n>
+    struct PerfectHash {
+        static constexpr Usize bucket_count = perfect_hash_bucket_count(n);
+
+        std::uint64_t                      seed = 0;
+        Array<std::uint32_t, bucket_count> displacements {};
+        Array<std::uint32_t, n>            entry_of_slot {}; // The entry stored in each slot
+    };
+
+    /* Description:
+     *     Builds a minimal perfect hash function for `keys` with the
+     *     hash-and-displace method. Keys are first hashed into buckets,
+     *     then, from the largest bucket down, each bucket is assigned the
+     *     first displacement which moves all of its keys to free slots.
+     *     If a bucket can not be placed, or two keys share a 64-bit hash,
+     *     the search restarts with the next seed.
+     */
+    template <Usize n>
+    consteval auto build_perfect_hash(Array<StringView, n> const& keys) -> PerfectHash<n> {
+        constexpr Usize bucket_count       = PerfectHash<n>::bucket_count;
+        constexpr Usize displacement_tries = 1 << 16;
+
+        for (Usize i = 0; i != n; ++i) {
+            for (Usize j = i + 1; j != n; ++j) {
+                if (keys[i] == keys[j])
+                    throw "bu::StaticMap keys must be distinct";
+            }
+        }
+
+        for (std::uint64_t seed = 0;; ++seed) {
+            PerfectHash<n> result { .seed = seed };
+
+            Array<std::uint64_t, n>    hashes {};
+            Array<Usize, n>            bucket_of {};
+            Array<Usize, bucket_count> bucket_sizes {};
+            bool collision = false;
+            for (Usize i = 0; i != n; ++i) {
+                hashes[i]    = wyhash(keys[i], seed);
+                bucket_of[i] = reduce_range(hashes[i], bucket_count);
+                ++bucket_sizes[bucket_of[i]];
+                for (Usize j = 0; j != i; ++j) {
+                    collision |= hashes[i] == hashes[j];
+                }
+            }
+            if (collision)
+                continue;
+
+            Array<bool, n> taken {};
+            bool placed_all = true;
+            for (Usize size = n; size != 0 && placed_all; --size) {
+                for (Usize bucket = 0; bucket != bucket_count && placed_all; ++bucket) {
+                    if (bucket_sizes[bucket] != size)
+                        continue;
+
+                    bool placed = false;
+                    for (std::uint32_t displacement = 0;
+                        displacement != displacement_tries && !placed;
+                        ++displacement)
+                    {
+                        Array<Usize, n> slots {};
+                        Usize           count = 0;
+                        bool            fits  = true;
+                        for (Usize i = 0; i != n && fits; ++i) {
+                            if (bucket_of[i] != bucket)
+                                continue;
+                            Usize const slot = perfect_hash_slot(hashes[i], displacement, n);
+                            fits = !taken[slot];
+                            for (Usize j = 0; j != count && fits; ++j) {
+                                fits = slots[j] != slot;
+                            }
+                            slots[count++] = slot;
+                        }
+                        if (!fits)
+                            continue;
+
+                        count = 0;
+                        for (Usize i = 0; i != n; ++i) {
+                            if (bucket_of[i] != bucket)
+                                continue;
+                            taken[slots[count]] = true;
+                            result.entry_of_slot[slots[count++]] = static_cast<std::uint32_t>(i);
+                        }
+                        result.displacements[bucket] = displacement;
+                        placed = true;
+                    }
+                    placed_all = placed;
+                }
+            }
+            if (placed_all)
+                return result;
+        }
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     An immutable map from string literals to values, built entirely
+     *     at compile time:
+     *
+     *         using Verbs = bu::StaticMap<
+     *             bu::StaticEntry<"GET",  Verb::get>,
+     *             bu::StaticEntry<"POST", Verb::post>>;
+     *
+     *         bu::Option<Verb> verb = Verbs::find(request_line);
+     *
+     *     The keys are arranged by a minimal perfect hash function, so a
+     *     lookup hashes the key once, reads one displacement and one
+     *     slot, and compares the key against the single candidate in
+     *     that slot, independently of the number of entries.
+     */
+    template <class... Entries>
+    class StaticMap {
+        static_assert(sizeof...(Entries) != 0, "a bu::StaticMap must have at least one entry");
+
+        static constexpr Usize key_count = sizeof...(Entries);
+    public:
+        using ValueType = std::common_type_t<std::remove_cv_t<decltype(Entries::value)>...>;
+    private:
+        static constexpr Array<StringView, key_count> keys   { Entries::key... };
+        static constexpr Array<ValueType, key_count>  values {
+            static_cast<ValueType>(Entries::value)...
+        };
+
+        static constexpr dtl::PerfectHash<key_count> layout = dtl::build_perfect_hash(keys);
+
+        struct Slot {
+            StringView key;
+            ValueType  value;
+            Usize      index;
+        };
+
+        // The entries in slot order, so that a lookup touches a single slot
+        static constexpr Array<Slot, key_count> slots = []<Usize... i>(std::index_sequence<i...>) {
+            return Array<Slot, key_count> {
+                Slot {
+                    keys[layout.entry_of_slot[i]],
+                    values[layout.entry_of_slot[i]],
+                    layout.entry_of_slot[i]
+                }...
+            };
+        }(std::make_index_sequence<key_count> {});
+
+        [[nodiscard]]
+        static constexpr auto candidate(StringView const key) noexcept -> Slot const& {
+            std::uint64_t const hash         = wyhash(key, layout.seed);
+            std::uint32_t const displacement =
+                layout.displacements.data()[dtl::reduce_range(hash, layout.bucket_count)];
+            return slots.data()[dtl::perfect_hash_slot(hash, displacement, key_count)];
+        }
+    public:
+        StaticMap() = delete;
+
+        [[nodiscard]]
+        static constexpr auto size() noexcept -> Usize {
+            return key_count;
+        }
+
+        // The value associated with `key`, if any
+        [[nodiscard]]
+        static constexpr auto find(StringView const key) noexcept -> Option<ValueType> {
+            Slot const& slot = candidate(key);
+            if (slot.key == key)
+                return slot.value;
+            else
+                return nullopt;
+        }
+
+        // The position of `key` within `Entries`, if it is one of the keys
+        [[nodiscard]]
+        static constexpr auto index_of(StringView const key) noexcept -> Option<Usize> {
+            Slot const& slot = candidate(key);
+            if (slot.key == key)
+                return slot.index;
+            else
+                return nullopt;
+        }
+
+        [[nodiscard]]
+        static constexpr auto contains(StringView const key) noexcept -> bool {
+            return candidate(key).key == key;
+        }
+    };
+}
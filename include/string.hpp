@@ -0,0 +1,672 @@
+#pragma once
+
+#include <bit>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "utility.hpp"
+#include "allocator.hpp"
+#include "option.hpp"
+#include "span.hpp"
+
+
+namespace bu::dtl {
+#ifdef __SSE2__
+    [[nodiscard]]
+    inline auto load_block(char const* const bytes) noexcept -> __m128i {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes));
+    }
+#endif
+
+    // The position of the first `byte` in `[data, data + size)`, scanning 16 bytes at a
+    // time where SSE2 is available
+    constexpr auto find_byte(char const* const data, Usize const size, char const byte)
+        noexcept -> Option<Usize>
+    {
+        Usize i = 0;
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated()) {
+            __m128i const pattern = _mm_set1_epi8(byte);
+            for (; i + 16 <= size; i += 16) {
+                __m128i const chunk = load_block(data + i);
+                if (int const mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)))
+                    return i + static_cast<Usize>(std::countr_zero(static_cast<unsigned>(mask)));
+            }
+        }
+#endif
+        for (; i != size; ++i) {
+            if (data[i] == byte)
+                return i;
+        }
+        return nullopt;
+    }
+
+    /* Description:
+     *     The position of the first occurrence of the needle in the
+     *     haystack. With SSE2, 16 candidate positions are tested at a
+     *     time by comparing the first and the last byte of the needle,
+     *     and only positions matching both are compared in full.
+     */
+    constexpr auto find_substring(
+        char const* const haystack,
+        Usize       const haystack_size,
+        char const* const needle,
+        Usize       const needle_size) noexcept -> Option<Usize>
+    {
+        if (needle_size == 0)
+            return Usize { 0 };
+        if (needle_size > haystack_size)
+            return nullopt;
+        if (needle_size == 1)
+            return find_byte(haystack, haystack_size, needle[0]);
+
+        Usize const last_start = haystack_size - needle_size;
+        Usize i = 0;
+#ifdef __SSE2__
+        if (!std::is_constant_evaluated()) {
+            __m128i const first = _mm_set1_epi8(needle[0]);
+            __m128i const last  = _mm_set1_epi8(needle[needle_size - 1]);
+            for (; i + 16 <= last_start + 1; i += 16) {
+                __m128i const block_first = load_block(haystack + i);
+                __m128i const block_last  = load_block(haystack + i + needle_size - 1);
+                __m128i const matches     = _mm_and_si128(
+                    _mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last));
+                auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+                for (; mask != 0; mask &= mask - 1) {
+                    Usize const candidate = i + static_cast<Usize>(std::countr_zero(mask));
+                    if (std::memcmp(haystack + candidate + 1, needle + 1, needle_size - 2) == 0)
+                        return candidate;
+                }
+            }
+        }
+#endif
+        for (; i <= last_start; ++i) {
+            if (haystack[i] != needle[0])
+                continue;
+            Usize j = 1;
+            while (j != needle_size && haystack[i + j] == needle[j]) {
+                ++j;
+            }
+            if (j == needle_size)
+                return i;
+        }
+        return nullopt;
+    }
+
+    constexpr auto compare_bytes(char const* const a, char const* const b, Usize const size)
+        noexcept -> int
+    {
+        if (std::is_constant_evaluated()) {
+            for (Usize i = 0; i != size; ++i) {
+                auto const x = static_cast<unsigned char>(a[i]);
+                auto const y = static_cast<unsigned char>(b[i]);
+                if (x != y)
+                    return x < y ? -1 : 1;
+            }
+            return 0;
+        }
+        return size ? std::memcmp(a, b, size) : 0;
+    }
+
+    class StringSplit;
+}
+
+
+namespace bu {
+    /* Description:
+     *     A non-owning view of a contiguous sequence of characters, which
+     *     need not be null-terminated. Interchangeable with
+     *     `bu::Span<char const>`.
+     */
+    class [[nodiscard]] StringView {
+        char const* m_ptr = nullptr;
+        Usize       m_len = 0;
+    public:
+        StringView() = default;
+
+        constexpr explicit StringView(char const* const start, Usize const length) noexcept
+            : m_ptr { start }
+            , m_len { length } {}
+
+        // Precondition: `string` is null-terminated
+        constexpr StringView(char const* const string) noexcept
+            : m_ptr { string }
+        {
+            if (std::is_constant_evaluated()) {
+                while (string[m_len] != '\0')
+                    ++m_len;
+            }
+            else {
+                m_len = std::strlen(string);
+            }
+        }
+
+        constexpr StringView(Span<char const> const span) noexcept
+            : m_ptr { span.data() }
+            , m_len { span.size() } {}
+
+        [[nodiscard]]
+        constexpr auto size() const noexcept -> Usize {
+            return m_len;
+        }
+        [[nodiscard]]
+        constexpr auto is_empty() const noexcept -> bool {
+            return m_len == 0;
+        }
+        [[nodiscard]]
+        constexpr auto data() const noexcept -> char const* {
+            return m_ptr;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator[](Usize const index) const -> char const& {
+            if (index < m_len)
+                return m_ptr[index];
+            else
+                throw OutOfRange {};
+        }
+
+        // The subview `[begin, end)`. Throws `bu::BadSlice` if the range is out of bounds
+        [[nodiscard]]
+        constexpr auto slice(Usize const begin, Usize const end) const -> StringView {
+            if (begin > end || end > m_len)
+                throw BadSlice {};
+            return StringView { m_ptr + begin, end - begin };
+        }
+
+        constexpr auto remove_prefix(Usize const off) -> void {
+            if (m_len < off)
+                throw BadSlice {};
+            m_ptr += off;
+            m_len -= off;
+        }
+        constexpr auto without_prefix(Usize const off) const -> StringView {
+            StringView copy = *this;
+            copy.remove_prefix(off);
+            return copy;
+        }
+        constexpr auto remove_suffix(Usize const off) -> void {
+            if (m_len < off)
+                throw BadSlice {};
+            m_len -= off;
+        }
+        constexpr auto without_suffix(Usize const off) const -> StringView {
+            StringView copy = *this;
+            copy.remove_suffix(off);
+            return copy;
+        }
+
+        [[nodiscard]]
+        constexpr auto find(char const character) const noexcept -> Option<Usize> {
+            return dtl::find_byte(m_ptr, m_len, character);
+        }
+        [[nodiscard]]
+        constexpr auto find(StringView const needle) const noexcept -> Option<Usize> {
+            return dtl::find_substring(m_ptr, m_len, needle.m_ptr, needle.m_len);
+        }
+        [[nodiscard]]
+        constexpr auto contains(StringView const needle) const noexcept -> bool {
+            return find(needle).has_value();
+        }
+        [[nodiscard]]
+        constexpr auto starts_with(StringView const prefix) const noexcept -> bool {
+            return prefix.m_len <= m_len
+                && dtl::compare_bytes(m_ptr, prefix.m_ptr, prefix.m_len) == 0;
+        }
+        [[nodiscard]]
+        constexpr auto ends_with(StringView const suffix) const noexcept -> bool {
+            return suffix.m_len <= m_len
+                && dtl::compare_bytes(
+                    m_ptr + m_len - suffix.m_len, suffix.m_ptr, suffix.m_len) == 0;
+        }
+
+        // Lazily splits the view on every `delimiter`, yielding empty pieces between
+        // adjacent delimiters
+        [[nodiscard]]
+        constexpr auto split(char delimiter) const noexcept -> dtl::StringSplit;
+
+        [[nodiscard]]
+        constexpr auto operator==(StringView const other) const noexcept -> bool {
+            return m_len == other.m_len && dtl::compare_bytes(m_ptr, other.m_ptr, m_len) == 0;
+        }
+        [[nodiscard]]
+        constexpr auto operator<=>(StringView const other) const noexcept -> std::strong_ordering {
+            Usize const common = m_len < other.m_len ? m_len : other.m_len;
+            int   const result = dtl::compare_bytes(m_ptr, other.m_ptr, common);
+            if (result != 0)
+                return result < 0 ? std::strong_ordering::less : std::strong_ordering::greater;
+            return m_len <=> other.m_len;
+        }
+
+        constexpr auto begin() const noexcept -> char const* {
+            return m_ptr;
+        }
+        constexpr auto end() const noexcept -> char const* {
+            return m_ptr + m_len;
+        }
+    };
+}
+
+
+namespace bu::dtl {
+    struct StringSplitSentinel {};
+
+    class StringSplitIterator {
+        StringView m_piece;
+        StringView m_rest;
+        char       m_delimiter = '\0';
+        bool       m_has_rest  = true;  // False once the final piece has been produced
+        bool       m_is_done   = false;
+    public:
+        using value_type      = StringView;
+        using difference_type = Isize;
+
+        StringSplitIterator() = default;
+
+        constexpr explicit StringSplitIterator(StringView const string, char const delimiter)
+            noexcept
+            : m_rest      { string }
+            , m_delimiter { delimiter }
+        {
+            ++*this;
+        }
+
+        constexpr auto operator++() noexcept -> StringSplitIterator& {
+            if (!m_has_rest) {
+                m_is_done = true;
+                return *this;
+            }
+            if (Option<Usize> const position = m_rest.find(m_delimiter)) {
+                Usize const index = position.value();
+                m_piece = StringView { m_rest.data(), index };
+                m_rest  = StringView { m_rest.data() + index + 1, m_rest.size() - index - 1 };
+            }
+            else {
+                m_piece    = m_rest;
+                m_has_rest = false;
+            }
+            return *this;
+        }
+        constexpr auto operator++(int) noexcept -> StringSplitIterator {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator*() const noexcept -> StringView const& {
+            return m_piece;
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(StringSplitSentinel) const noexcept -> bool {
+            return m_is_done;
+        }
+    };
+
+    class [[nodiscard]] StringSplit {
+        StringView m_string;
+        char       m_delimiter;
+    public:
+        using Iterator = StringSplitIterator;
+        using Sentinel = StringSplitSentinel;
+
+        constexpr explicit StringSplit(StringView const string, char const delimiter) noexcept
+            : m_string    { string }
+            , m_delimiter { delimiter } {}
+
+        [[nodiscard]]
+        constexpr auto begin() const noexcept -> Iterator {
+            return Iterator { m_string, m_delimiter };
+        }
+        [[nodiscard]]
+        constexpr auto end() const noexcept -> Sentinel {
+            return Sentinel {};
+        }
+    };
+}
+
+
+namespace bu {
+    constexpr auto StringView::split(char const delimiter) const noexcept -> dtl::StringSplit {
+        return dtl::StringSplit { *this, delimiter };
+    }
+
+
+    /* Description:
+     *     An owning, null-terminated string with the small string
+     *     optimization. With a stateless allocator the string occupies
+     *     24 bytes, and strings of up to 23 characters are stored
+     *     inline without allocating.
+     *
+     *     The last byte of the object tells the representations apart.
+     *     Inline strings store their unused capacity there, which for a
+     *     full inline string doubles as the null terminator, while heap
+     *     strings set its high bit through the encoded capacity.
+     */
+    template <allocator_for<char> A = DefaultAllocator<char>>
+    class [[nodiscard]] BasicString {
+        struct Heap {
+            char* ptr;
+            Usize size;
+            Usize capacity; // Encoded, see `encode_capacity`
+        };
+
+        static constexpr Usize inline_capacity = sizeof(Heap) - 1;
+
+        union {
+            Heap m_heap;
+            char m_inline[sizeof(Heap)];
+        };
+        [[no_unique_address]]
+        A m_allocator;
+    public:
+        using ContainedType = char;
+        using AllocatorType = A;
+        using SizeType      = Usize;
+
+        BasicString() noexcept {
+            set_empty();
+        }
+
+        BasicString(StringView const string)
+            noexcept(nothrow_alloc<A>)
+        {
+            initialize(string);
+        }
+        BasicString(char const* const string)
+            noexcept(nothrow_alloc<A>)
+            : BasicString { StringView { string } } {}
+
+        BasicString(BasicString const& other)
+            noexcept(nothrow_alloc<A>)
+            : m_allocator { other.m_allocator }
+        {
+            initialize(other.view());
+        }
+
+        BasicString(BasicString&& other) noexcept
+            : m_allocator { std::move(other.m_allocator) }
+        {
+            take(other);
+        }
+
+        auto operator=(BasicString const& other)
+            noexcept(nothrow_alloc<A> && nothrow_dealloc<A>) -> BasicString&
+        {
+            if (this != &other) {
+                if constexpr (AllocatorTraits<A>::propagate_on_copy_assign) {
+                    BasicString copy { other };
+                    swap(copy);
+                }
+                else if (other.size() <= capacity()) {
+                    std::memcpy(data(), other.data(), other.size());
+                    set_size(other.size());
+                }
+                else {
+                    BasicString copy { other.view() };
+                    swap(copy);
+                }
+            }
+            return *this;
+        }
+
+        auto operator=(BasicString&& other)
+            noexcept(nothrow_dealloc<A>) -> BasicString&
+        {
+            if (this != &other) {
+                release();
+                if constexpr (AllocatorTraits<A>::propagate_on_move_assign) {
+                    m_allocator = std::move(other.m_allocator);
+                }
+                take(other);
+            }
+            return *this;
+        }
+
+        ~BasicString() {
+            release();
+        }
+
+        [[nodiscard]]
+        auto size() const noexcept -> Usize {
+            return is_inline() ? inline_capacity - tag() : m_heap.size;
+        }
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return size() == 0;
+        }
+        [[nodiscard]]
+        auto capacity() const noexcept -> Usize {
+            return is_inline() ? inline_capacity : decode_capacity(m_heap.capacity);
+        }
+
+        [[nodiscard]]
+        auto data() const noexcept -> char const* {
+            return is_inline() ? m_inline : m_heap.ptr;
+        }
+        [[nodiscard]]
+        auto data() noexcept -> char* {
+            return is_inline() ? m_inline : m_heap.ptr;
+        }
+
+        // The contents are always followed by a null character
+        [[nodiscard]]
+        auto c_str() const noexcept -> char const* {
+            return data();
+        }
+
+        [[nodiscard]]
+        auto view() const noexcept -> StringView {
+            return StringView { data(), size() };
+        }
+        [[nodiscard]]
+        operator StringView() const noexcept {
+            return view();
+        }
+
+        /* Description:
+         *     Ensures that the string can hold at least `new_capacity`
+         *     characters without reallocating.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - A::allocate(bu::Usize)
+         */
+        auto reserve(Usize const new_capacity)
+            noexcept(nothrow_alloc<A> && nothrow_dealloc<A>) -> void
+        {
+            if (new_capacity <= capacity())
+                return;
+            Usize const length = size();
+            char* const buffer = m_allocator.allocate(new_capacity + 1);
+            std::memcpy(buffer, data(), length + 1);
+            release();
+            m_heap = Heap { buffer, length, encode_capacity(new_capacity) };
+        }
+
+        auto append(char const character)
+            noexcept(nothrow_alloc<A> && nothrow_dealloc<A>) -> void
+        {
+            Usize const length = size();
+            if (length == capacity())
+                reserve(length * 2);
+            data()[length] = character;
+            set_size(length + 1);
+        }
+
+        // Appends `string`, which may be a view of `this`
+        auto extend(StringView const string)
+            noexcept(nothrow_alloc<A> && nothrow_dealloc<A>) -> void
+        {
+            Usize const length   = size();
+            Usize const required = length + string.size();
+            if (required > capacity()) {
+                // Copy before releasing the old buffer, `string` may point into it
+                Usize const new_capacity = required > length * 2 ? required : length * 2;
+                char* const buffer = m_allocator.allocate(new_capacity + 1);
+                std::memcpy(buffer, data(), length);
+                std::memcpy(buffer + length, string.data(), string.size());
+                release();
+                m_heap = Heap { buffer, length, encode_capacity(new_capacity) };
+            }
+            else if (!string.is_empty()) {
+                std::memcpy(data() + length, string.data(), string.size());
+            }
+            set_size(required);
+        }
+
+        auto operator+=(char const character) -> BasicString& {
+            append(character);
+            return *this;
+        }
+        auto operator+=(StringView const string) -> BasicString& {
+            extend(string);
+            return *this;
+        }
+
+        auto pop_back() noexcept -> void {
+            assert(!is_empty());
+            set_size(size() - 1);
+        }
+        auto clear() noexcept -> void {
+            set_size(0);
+        }
+
+        [[nodiscard]]
+        auto operator[](Usize const index) const -> char const& {
+            if (index < size())
+                return data()[index];
+            else
+                throw OutOfRange {};
+        }
+        [[nodiscard]]
+        auto operator[](Usize const index) -> char& {
+            return const_cast<char&>(const_cast<BasicString const&>(*this)[index]);
+        }
+
+        [[nodiscard]]
+        auto find(char const character) const noexcept -> Option<Usize> {
+            return view().find(character);
+        }
+        [[nodiscard]]
+        auto find(StringView const needle) const noexcept -> Option<Usize> {
+            return view().find(needle);
+        }
+        [[nodiscard]]
+        auto contains(StringView const needle) const noexcept -> bool {
+            return view().contains(needle);
+        }
+        [[nodiscard]]
+        auto starts_with(StringView const prefix) const noexcept -> bool {
+            return view().starts_with(prefix);
+        }
+        [[nodiscard]]
+        auto ends_with(StringView const suffix) const noexcept -> bool {
+            return view().ends_with(suffix);
+        }
+        [[nodiscard]]
+        auto split(char const delimiter) const noexcept -> dtl::StringSplit {
+            return view().split(delimiter);
+        }
+
+        [[nodiscard]]
+        auto operator==(StringView const other) const noexcept -> bool {
+            return view() == other;
+        }
+        [[nodiscard]]
+        auto operator<=>(StringView const other) const noexcept -> std::strong_ordering {
+            return view() <=> other;
+        }
+
+        [[nodiscard]] auto begin() const noexcept -> char const* { return data(); }
+        [[nodiscard]] auto begin()       noexcept -> char      * { return data(); }
+
+        [[nodiscard]] auto end() const noexcept -> char const* { return data() + size(); }
+        [[nodiscard]] auto end()       noexcept -> char      * { return data() + size(); }
+
+        auto swap(BasicString& other) noexcept -> void {
+            if constexpr (AllocatorTraits<A>::propagate_on_swap) {
+                BU swap(m_allocator, other.m_allocator);
+            }
+            // Both representations are trivially relocatable
+            alignas(Heap) unsigned char buffer[sizeof(Heap)];
+            std::memcpy(buffer, std::addressof(m_heap), sizeof(Heap));
+            std::memcpy(std::addressof(m_heap), std::addressof(other.m_heap), sizeof(Heap));
+            std::memcpy(std::addressof(other.m_heap), buffer, sizeof(Heap));
+        }
+    private:
+        static constexpr auto encode_capacity(Usize const capacity) noexcept -> Usize {
+            if constexpr (std::endian::native == std::endian::little)
+                return capacity | Usize { 0x80 } << (8 * (sizeof(Usize) - 1));
+            else
+                return capacity << 8 | 0x80;
+        }
+        static constexpr auto decode_capacity(Usize const encoded) noexcept -> Usize {
+            if constexpr (std::endian::native == std::endian::little)
+                return encoded & ~(Usize { 0x80 } << (8 * (sizeof(Usize) - 1)));
+            else
+                return encoded >> 8;
+        }
+
+        // The last byte of the representation, inspected through a character type
+        [[nodiscard]]
+        auto tag() const noexcept -> unsigned char {
+            return reinterpret_cast<unsigned char const*>(std::addressof(m_heap))[sizeof(Heap) - 1];
+        }
+        [[nodiscard]]
+        auto is_inline() const noexcept -> bool {
+            return tag() <= inline_capacity;
+        }
+
+        auto set_empty() noexcept -> void {
+            m_inline[0]               = '\0';
+            m_inline[inline_capacity] = static_cast<char>(inline_capacity);
+        }
+
+        auto set_size(Usize const length) noexcept -> void {
+            if (is_inline()) {
+                m_inline[length]          = '\0';
+                m_inline[inline_capacity] = static_cast<char>(inline_capacity - length);
+            }
+            else {
+                m_heap.ptr[length] = '\0';
+                m_heap.size        = length;
+            }
+        }
+
+        auto initialize(StringView const string) -> void {
+            Usize const length = string.size();
+            if (length <= inline_capacity) {
+                set_empty();
+                if (length)
+                    std::memcpy(m_inline, string.data(), length);
+                set_size(length);
+            }
+            else {
+                char* const buffer = m_allocator.allocate(length + 1);
+                std::memcpy(buffer, string.data(), length);
+                buffer[length] = '\0';
+                m_heap = Heap { buffer, length, encode_capacity(length) };
+            }
+        }
+
+        // Steals the representation of `other`, which must use an equal allocator, and empties it
+        auto take(BasicString& other) noexcept -> void {
+            std::memcpy(std::addressof(m_heap), std::addressof(other.m_heap), sizeof(Heap));
+            other.set_empty();
+        }
+
+        auto release() noexcept(nothrow_dealloc<A>) -> void {
+            if (!is_inline())
+                m_allocator.deallocate(m_heap.ptr, decode_capacity(m_heap.capacity) + 1);
+            set_empty();
+        }
+    };
+
+    using String = BasicString<>;
+
+    static_assert(sizeof(String) == 3 * sizeof(void*));
+}
@@ -0,0 +1,957 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "result.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+#include "any.hpp"
+#include "function.hpp"
+
+
+namespace bu::dtl {
+    struct Job {
+        void (*execute)(Job*) = nullptr;
+        Job*  next            = nullptr; // Intrusive link used by queues
+    };
+
+    // Blocks waiting threads until it has been counted down to zero
+    class [[nodiscard]] Latch {
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+        Usize                   m_count;
+    public:
+        explicit Latch(Usize const count) noexcept
+            : m_count { count } {}
+
+        auto count_down() -> void {
+            // Notify while holding the lock, the waiter may destroy `this` once it is released
+            std::scoped_lock const lock { m_mutex };
+            if (--m_count == 0)
+                m_condition.notify_all();
+        }
+        auto wait() -> void {
+            std::unique_lock lock { m_mutex };
+            m_condition.wait(lock, [this] { return m_count == 0; });
+        }
+    };
+
+    // A job that lives on the stack of the thread that waits for it
+    template <class F>
+    class [[nodiscard]] StackJob : public Job {
+        F*                 m_function = nullptr;
+        Latch*             m_latch    = nullptr;
+        std::exception_ptr m_exception;
+        std::atomic<bool>  m_done     = false;
+    public:
+        StackJob() noexcept
+            : Job { .execute = &run } {}
+
+        explicit StackJob(F& function, Latch* const latch = nullptr) noexcept
+            : Job { .execute = &run }
+            , m_function { std::addressof(function) }
+            , m_latch    { latch } {}
+
+        auto bind(F& function, Latch* const latch = nullptr) noexcept -> void {
+            m_function = std::addressof(function);
+            m_latch    = latch;
+        }
+
+        [[nodiscard]]
+        auto is_done() const noexcept -> bool {
+            return m_done.load(std::memory_order_acquire);
+        }
+        auto rethrow_if_failed() const -> void {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+        }
+    private:
+        static auto run(Job* const job) -> void {
+            auto* const self = static_cast<StackJob*>(job);
+            try {
+                (*self->m_function)();
+            }
+            catch (...) {
+                self->m_exception = std::current_exception();
+            }
+            // Once `m_done` is set the job may be destroyed, so it must be the last access
+            Latch* const latch = self->m_latch;
+            self->m_done.store(true, std::memory_order_release);
+            if (latch)
+                latch->count_down();
+        }
+    };
+
+
+    /* Description:
+     *     The Chase-Lev work-stealing deque, as formulated for the C11
+     *     memory model by Lê, Pop, Cohen and Zappa Nardelli. The owning
+     *     worker pushes and pops at the bottom, other workers steal from
+     *     the top. Outgrown buffers are retired rather than freed, since
+     *     a concurrent thief may still be reading from them.
+     *
+     * Preconditions:
+     *     `push` and `pop` may only be called by the owning thread.
+     */
+    class [[nodiscard]] WorkStealingDeque {
+        struct Buffer {
+            Isize                         capacity;
+            UniquePtr<std::atomic<Job*>[]> slots;
+
+            explicit Buffer(Isize const capacity)
+                : capacity { capacity }
+                , slots    { make_unique<std::atomic<Job*>[]>(static_cast<Usize>(capacity)) } {}
+
+            auto get(Isize const index) const noexcept -> Job* {
+                return slot(index).load(std::memory_order_relaxed);
+            }
+            auto put(Isize const index, Job* const job) const noexcept -> void {
+                slot(index).store(job, std::memory_order_relaxed);
+            }
+            auto slot(Isize const index) const noexcept -> std::atomic<Job*>& {
+                return slots[static_cast<Usize>(index & (capacity - 1))];
+            }
+        };
+
+        alignas(64) std::atomic<Isize> m_top    = 0;
+        alignas(64) std::atomic<Isize> m_bottom = 0;
+        std::atomic<Buffer*>           m_buffer;
+        Vector<UniquePtr<Buffer>>      m_buffers;
+    public:
+        explicit WorkStealingDeque(Isize const initial_capacity = 256) {
+            m_buffers.append(make_unique<Buffer>(initial_capacity));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        auto push(Job* const job) -> void {
+            Isize const bottom = m_bottom.load(std::memory_order_relaxed);
+            Isize const top    = m_top.load(std::memory_order_acquire);
+            Buffer*     buffer = m_buffer.load(std::memory_order_relaxed);
+
+            if (bottom - top > buffer->capacity - 1) {
+                buffer = grow(buffer, top, bottom);
+            }
+            buffer->put(bottom, job);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        auto pop() noexcept -> Job* {
+            Isize const bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* const buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Isize top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom) { // Empty
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Job* job = buffer->get(bottom);
+            if (top == bottom) { // Last element, race against thieves
+                if (!m_top.compare_exchange_strong(top, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    job = nullptr;
+                }
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        [[nodiscard]]
+        auto steal() noexcept -> Job* {
+            Isize top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Isize const bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+                return nullptr;
+
+            Job* const job = m_buffer.load(std::memory_order_acquire)->get(top);
+            if (!m_top.compare_exchange_strong(top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr; // Lost the race to another thief or the owner
+            }
+            return job;
+        }
+
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            Isize const bottom = m_bottom.load(std::memory_order_relaxed);
+            return bottom <= m_top.load(std::memory_order_relaxed);
+        }
+    private:
+        auto grow(Buffer* const old_buffer, Isize const top, Isize const bottom) -> Buffer* {
+            m_buffers.append(make_unique<Buffer>(old_buffer->capacity * 2));
+            Buffer* const new_buffer = m_buffers.back().get();
+            for (Isize i = top; i != bottom; ++i) {
+                new_buffer->put(i, old_buffer->get(i));
+            }
+            m_buffer.store(new_buffer, std::memory_order_release);
+            return new_buffer;
+        }
+    };
+
+
+    // Mutex-protected intrusive FIFO of jobs
+    class [[nodiscard]] JobQueue {
+        std::mutex m_mutex;
+        Job*       m_head = nullptr;
+        Job*       m_tail = nullptr;
+    public:
+        auto push(Job* const job) -> void {
+            std::scoped_lock const lock { m_mutex };
+            job->next = nullptr;
+            if (m_tail)
+                m_tail->next = job;
+            else
+                m_head = job;
+            m_tail = job;
+        }
+        [[nodiscard]]
+        auto pop() -> Job* {
+            std::scoped_lock const lock { m_mutex };
+            Job* const job = m_head;
+            if (job) {
+                m_head = job->next;
+                if (!m_head)
+                    m_tail = nullptr;
+            }
+            return job;
+        }
+    };
+
+
+    /* Description:
+     *     Dmitry Vyukov's bounded multi-producer multi-consumer queue.
+     *     Each cell carries a sequence number which tells producers and
+     *     consumers whether it is free for the lap they are on, so both
+     *     ends only contend on a single atomic increment.
+     */
+    class [[nodiscard]] InjectorQueue {
+        struct Cell {
+            std::atomic<Usize> sequence;
+            Job*               job;
+        };
+
+        UniquePtr<Cell[]>              m_cells;
+        Usize                          m_mask;
+        alignas(64) std::atomic<Usize> m_enqueue_position = 0;
+        alignas(64) std::atomic<Usize> m_dequeue_position = 0;
+    public:
+        // Precondition: `capacity` is a power of two
+        explicit InjectorQueue(Usize const capacity = Usize { 1 } << 16)
+            : m_cells { make_unique<Cell[]>(capacity) }
+            , m_mask  { capacity - 1 }
+        {
+            assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+            for (Usize i = 0; i != capacity; ++i) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Returns false if the queue is full
+        [[nodiscard]]
+        auto try_push(Job* const job) noexcept -> bool {
+            Usize position = m_enqueue_position.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &m_cells[position & m_mask];
+                Usize const sequence = cell->sequence.load(std::memory_order_acquire);
+                auto  const delta    = static_cast<Isize>(sequence) - static_cast<Isize>(position);
+                if (delta == 0) {
+                    if (m_enqueue_position.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (delta < 0) {
+                    return false;
+                }
+                else {
+                    position = m_enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+            cell->job = job;
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        [[nodiscard]]
+        auto pop() noexcept -> Job* {
+            Usize position = m_dequeue_position.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &m_cells[position & m_mask];
+                Usize const sequence = cell->sequence.load(std::memory_order_acquire);
+                auto  const delta    = static_cast<Isize>(sequence - (position + 1));
+                if (delta == 0) {
+                    if (m_dequeue_position.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (delta < 0) {
+                    return nullptr;
+                }
+                else {
+                    position = m_dequeue_position.load(std::memory_order_relaxed);
+                }
+            }
+            Job* const job = cell->job;
+            cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+            return job;
+        }
+    };
+
+
+    // Restricts `thread` to the `index`-th processor the process may run on
+    inline auto pin_thread(std::thread& thread, Usize const index) noexcept -> void {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (::sched_getaffinity(0, sizeof allowed, &allowed) != 0)
+            return;
+
+        auto const available = static_cast<Usize>(CPU_COUNT(&allowed));
+        if (available == 0)
+            return;
+        Usize remaining = index % available;
+        for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &allowed))
+                continue;
+            if (remaining-- == 0) {
+                cpu_set_t chosen;
+                CPU_ZERO(&chosen);
+                CPU_SET(cpu, &chosen);
+                (void)::pthread_setaffinity_np(thread.native_handle(), sizeof chosen, &chosen);
+                return;
+            }
+        }
+#else
+        (void)thread;
+        (void)index;
+#endif
+    }
+
+
+    class ThreadPoolWorker;
+    inline thread_local ThreadPoolWorker* current_worker = nullptr;
+}
+
+
+namespace bu {
+    // The failure of a task spawned on a `bu::ThreadPool`, holding the exception it threw
+    class [[nodiscard]] TaskError {
+        std::exception_ptr m_exception;
+    public:
+        explicit TaskError(std::exception_ptr exception) noexcept
+            : m_exception { std::move(exception) } {}
+
+        [[nodiscard]]
+        auto exception() const noexcept -> std::exception_ptr const& {
+            return m_exception;
+        }
+        [[noreturn]]
+        auto rethrow() const -> void {
+            std::rethrow_exception(m_exception);
+        }
+    };
+
+    template <class R>
+    using TaskResult = Result<std::conditional_t<std::is_void_v<R>, Unit, R>, TaskError>;
+
+    template <class R>
+    class TaskHandle;
+
+    struct ThreadPoolOptions {
+        Usize thread_count = std::thread::hardware_concurrency();
+        bool  pin_threads  = false; // Pin worker `i` to the `i`-th available processor
+    };
+}
+
+
+namespace bu::dtl {
+    /* Description:
+     *     The shared state of a spawned task. It is owned jointly by the
+     *     pool, until the task has run, and by its `bu::TaskHandle`, and
+     *     is returned to the cache of whichever thread drops the last
+     *     reference.
+     */
+    struct TaskState : Job {
+        UniqueFunction<void(MoveOnlyAny&)> body;
+        MoveOnlyAny                        result;
+        std::atomic<int>                   references = 2;
+        std::atomic<bool>                  done       = false;
+
+        TaskState() noexcept
+            : Job { .execute = &run } {}
+
+        auto release() noexcept -> void;
+    private:
+        static auto run(Job* const job) -> void {
+            auto* const state = static_cast<TaskState*>(job);
+            state->body(state->result); // The body captures its own exceptions
+            state->body.reset();
+            state->done.store(true, std::memory_order_release);
+            state->done.notify_all();
+            state->release();
+        }
+    };
+
+    // A bounded per-thread free list of task states, so that spawning does not allocate
+    // in the steady state
+    class [[nodiscard]] TaskStateCache {
+        TaskState* m_head = nullptr;
+        Usize      m_size = 0;
+    public:
+        static constexpr Usize capacity = 256;
+
+        TaskStateCache() = default;
+        TaskStateCache(TaskStateCache const&) = delete;
+        auto operator=(TaskStateCache const&) -> TaskStateCache& = delete;
+
+        ~TaskStateCache() {
+            while (m_head) {
+                delete BU exchange(m_head, static_cast<TaskState*>(m_head->next));
+            }
+        }
+
+        [[nodiscard]]
+        auto acquire() -> TaskState* {
+            if (!m_head)
+                return new TaskState;
+            TaskState* const state = BU exchange(m_head, static_cast<TaskState*>(m_head->next));
+            --m_size;
+            state->next = nullptr;
+            state->references.store(2, std::memory_order_relaxed);
+            state->done.store(false, std::memory_order_relaxed);
+            return state;
+        }
+        auto recycle(TaskState* const state) noexcept -> void {
+            if (m_size == capacity) {
+                delete state;
+                return;
+            }
+            state->next = m_head;
+            m_head      = state;
+            ++m_size;
+        }
+    };
+
+    inline thread_local TaskStateCache task_state_cache;
+
+    inline auto TaskState::release() noexcept -> void {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            result.reset();
+            task_state_cache.recycle(this);
+        }
+    }
+}
+
+
+namespace bu {
+    /* Description:
+     *     A fixed-size pool of worker threads scheduling fork/join jobs
+     *     by work stealing. Each worker owns a deque of jobs; it pushes
+     *     and pops its own jobs in LIFO order and, when out of work,
+     *     steals the oldest job of a randomly chosen victim.
+     *
+     *     Jobs submitted by `join` live on the stack of the forking
+     *     thread, so forking does not allocate. Tasks submitted by
+     *     `spawn` store their closure in a small buffer and their state
+     *     is recycled through a per-thread cache, so spawning a small
+     *     closure does not allocate in the steady state either.
+     *
+     *     Work submitted from outside of the pool goes through a shared
+     *     lock-free injection queue. On destruction, the pool finishes
+     *     all submitted work before joining its threads.
+     */
+    class [[nodiscard]] ThreadPool {
+        friend class dtl::ThreadPoolWorker;
+
+        UniquePtr<dtl::ThreadPoolWorker[]> m_workers;
+        Usize                              m_worker_count = 0;
+        Vector<std::thread>                m_threads;
+        dtl::InjectorQueue                 m_injector;
+        std::atomic<std::uint32_t>         m_work_epoch = 0;
+        std::atomic<Usize>                 m_sleepers   = 0;
+        std::atomic<bool>                  m_stopping   = false;
+    public:
+        explicit ThreadPool(ThreadPoolOptions options = {});
+
+        explicit ThreadPool(Usize const thread_count)
+            : ThreadPool { ThreadPoolOptions { .thread_count = thread_count } } {}
+
+        ThreadPool(ThreadPool const&) = delete;
+        auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+        ~ThreadPool();
+
+        // The pool used by `bu::parallel` algorithms when none is given
+        [[nodiscard]]
+        static auto global() -> ThreadPool& {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        [[nodiscard]]
+        auto thread_count() const noexcept -> Usize {
+            return m_worker_count;
+        }
+
+        // The index of the calling thread within this pool, if it is one of its workers
+        [[nodiscard]]
+        auto current_worker_index() const noexcept -> Option<Usize>;
+
+        /* Description:
+         *     Invokes `a` and `b`, potentially in parallel, and returns
+         *     once both have completed. If called from outside of the
+         *     pool, the calling thread blocks while a worker runs the
+         *     fork.
+         *
+         * Exceptions:
+         *     If either function throws, the exception is rethrown
+         *     after both have completed. If both throw, the exception
+         *     thrown by `a` is propagated.
+         */
+        template <std::invocable A, std::invocable B>
+        auto join(A&& a, B&& b) -> void;
+
+        /* Description:
+         *     Invokes `function(worker_index)` once on every worker of
+         *     the pool and returns once all invocations have completed.
+         *     Worker `i` always runs invocation `i`, which lets callers
+         *     assign the same data to the same thread across calls.
+         *
+         * Exceptions:
+         *     Rethrows the first exception thrown by an invocation, after
+         *     all invocations have completed.
+         */
+        template <std::invocable<Usize> F>
+        auto broadcast(F&& function) -> void;
+
+        // Runs `function` on a worker of the pool and waits for it to complete
+        template <std::invocable F>
+        auto run(F&& function) -> void;
+
+        /* Description:
+         *     Schedules `function` to run on the pool. Tasks spawned by a
+         *     worker are pushed to its own deque, others are injected.
+         *     The task runs to completion even if its handle is dropped.
+         *
+         * Return value:
+         *     A handle through which the `bu::TaskResult` of the task can
+         *     be awaited. Exceptions thrown by `function` are captured
+         *     in a `bu::TaskError`.
+         */
+        template <std::invocable F>
+        auto spawn(F&& function) -> TaskHandle<std::invoke_result_t<std::decay_t<F>&>>;
+    private:
+        auto inject(dtl::Job* job) -> void;
+        auto submit(dtl::Job* job) -> void;
+        auto notify_workers() noexcept -> void;
+    };
+}
+
+
+namespace bu::dtl {
+    class [[nodiscard]] ThreadPoolWorker {
+        WorkStealingDeque m_deque;
+        JobQueue          m_mailbox;
+        ThreadPool*       m_pool  = nullptr;
+        Usize             m_index = 0;
+        std::uint64_t     m_rng   = 0;
+    public:
+        auto initialize(ThreadPool& pool, Usize const index) noexcept -> void {
+            m_pool  = &pool;
+            m_index = index;
+            m_rng   = 0x9e3779b97f4a7c15ull * (index + 1);
+        }
+
+        [[nodiscard]]
+        auto pool() const noexcept -> ThreadPool& {
+            return *m_pool;
+        }
+        [[nodiscard]]
+        auto index() const noexcept -> Usize {
+            return m_index;
+        }
+
+        auto push(Job* const job) -> void {
+            m_deque.push(job);
+            m_pool->notify_workers();
+        }
+        [[nodiscard]]
+        auto pop() noexcept -> Job* {
+            return m_deque.pop();
+        }
+        auto deliver(Job* const job) -> void {
+            m_mailbox.push(job);
+        }
+
+        // Looks for a job in the local deque, the mailbox, the injector, then other workers
+        [[nodiscard]]
+        auto find_job() -> Job* {
+            if (Job* const job = m_deque.pop())
+                return job;
+            if (Job* const job = m_mailbox.pop())
+                return job;
+            if (Job* const job = m_pool->m_injector.pop())
+                return job;
+            return steal();
+        }
+
+        // Executes other jobs until `job` is done
+        template <class F>
+        auto wait_until_done(StackJob<F> const& job) -> void {
+            wait_until([&] { return job.is_done(); });
+        }
+
+        // Executes other jobs until `predicate()` holds
+        template <std::predicate Predicate>
+        auto wait_until(Predicate const predicate) -> void {
+            for (Usize idle_rounds = 0; !predicate();) {
+                if (Job* const other = find_job()) {
+                    other->execute(other);
+                    idle_rounds = 0;
+                }
+                else if (++idle_rounds > 64) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        auto main_loop() -> void {
+            current_worker = this;
+            for (;;) {
+                if (Job* const job = find_job()) {
+                    job->execute(job);
+                    continue;
+                }
+                // Only stop once out of work, so that submitted work always completes
+                if (m_pool->m_stopping.load(std::memory_order_acquire))
+                    break;
+                sleep();
+            }
+            current_worker = nullptr;
+        }
+    private:
+        [[nodiscard]]
+        auto steal() noexcept -> Job* {
+            Usize const count = m_pool->m_worker_count;
+            if (count < 2)
+                return nullptr;
+
+            // xorshift64
+            m_rng ^= m_rng << 13;
+            m_rng ^= m_rng >> 7;
+            m_rng ^= m_rng << 17;
+
+            Usize const start = static_cast<Usize>(m_rng % count);
+            for (Usize i = 0; i != count; ++i) {
+                Usize const victim = (start + i) % count;
+                if (victim == m_index)
+                    continue;
+                if (Job* const job = m_pool->m_workers[victim].m_deque.steal())
+                    return job;
+            }
+            return nullptr;
+        }
+
+        auto sleep() -> void {
+            std::uint32_t const epoch = m_pool->m_work_epoch.load();
+
+            // Spin briefly before blocking, new work tends to arrive in bursts
+            for (Usize i = 0; i != 128; ++i) {
+                if (Job* const job = find_job()) {
+                    job->execute(job);
+                    return;
+                }
+            }
+            if (m_pool->m_stopping.load())
+                return;
+
+            ++m_pool->m_sleepers;
+            m_pool->m_work_epoch.wait(epoch);
+            --m_pool->m_sleepers;
+        }
+    };
+}
+
+
+namespace bu {
+    inline ThreadPool::ThreadPool(ThreadPoolOptions const options)
+        : m_workers      { make_unique<dtl::ThreadPoolWorker[]>(
+                               options.thread_count ? options.thread_count : 1) }
+        , m_worker_count { options.thread_count ? options.thread_count : 1 }
+    {
+        m_threads.reserve(m_worker_count);
+        for (Usize i = 0; i != m_worker_count; ++i) {
+            m_workers[i].initialize(*this, i);
+        }
+        for (Usize i = 0; i != m_worker_count; ++i) {
+            std::thread& thread = m_threads.append(
+                [worker = &m_workers[i]] { worker->main_loop(); });
+            if (options.pin_threads)
+                dtl::pin_thread(thread, i);
+        }
+    }
+
+    inline ThreadPool::~ThreadPool() {
+        m_stopping.store(true);
+        m_work_epoch.fetch_add(1);
+        m_work_epoch.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    inline auto ThreadPool::current_worker_index() const noexcept -> Option<Usize> {
+        if (dtl::current_worker && &dtl::current_worker->pool() == this)
+            return dtl::current_worker->index();
+        else
+            return nullopt;
+    }
+
+    inline auto ThreadPool::inject(dtl::Job* const job) -> void {
+        // The queue is bounded, a full queue applies backpressure to the submitter
+        while (!m_injector.try_push(job)) {
+            std::this_thread::yield();
+        }
+        notify_workers();
+    }
+
+    inline auto ThreadPool::submit(dtl::Job* const job) -> void {
+        dtl::ThreadPoolWorker* const worker = dtl::current_worker;
+        if (worker && &worker->pool() == this)
+            worker->push(job);
+        else
+            inject(job);
+    }
+
+    inline auto ThreadPool::notify_workers() noexcept -> void {
+        m_work_epoch.fetch_add(1);
+        if (m_sleepers.load() != 0)
+            m_work_epoch.notify_all();
+    }
+
+    template <std::invocable A, std::invocable B>
+    auto ThreadPool::join(A&& a, B&& b) -> void {
+        dtl::ThreadPoolWorker* const worker = dtl::current_worker;
+        if (!worker || &worker->pool() != this) {
+            run([&] { join(a, b); });
+            return;
+        }
+
+        dtl::StackJob job_b { b };
+        worker->push(&job_b);
+
+        std::exception_ptr exception_a;
+        try {
+            std::invoke(a);
+        }
+        catch (...) {
+            exception_a = std::current_exception();
+        }
+
+        // Every fork made by `a` has been joined, but tasks it spawned may
+        // still be above `job_b`. Run those too, `job_b` is next in line.
+        for (;;) {
+            dtl::Job* const job = worker->pop();
+            if (!job) { // `job_b` was stolen
+                worker->wait_until_done(job_b);
+                break;
+            }
+            job->execute(job);
+            if (job == &job_b)
+                break;
+        }
+
+        if (exception_a)
+            std::rethrow_exception(exception_a);
+        job_b.rethrow_if_failed();
+    }
+
+    template <std::invocable<Usize> F>
+    auto ThreadPool::broadcast(F&& function) -> void {
+        struct Call {
+            std::remove_reference_t<F>* function = nullptr;
+            Usize                       index    = 0;
+
+            auto operator()() const -> void {
+                std::invoke(*function, index);
+            }
+        };
+
+        dtl::ThreadPoolWorker* const worker = dtl::current_worker;
+        bool const is_internal = worker && &worker->pool() == this;
+
+        auto  calls = make_unique<Call[]>(m_worker_count);
+        auto  jobs  = make_unique<dtl::StackJob<Call>[]>(m_worker_count);
+        dtl::Latch latch { m_worker_count };
+
+        for (Usize i = 0; i != m_worker_count; ++i) {
+            calls[i] = Call { std::addressof(function), i };
+            jobs[i].bind(calls[i], is_internal ? nullptr : &latch);
+            m_workers[i].deliver(&jobs[i]);
+        }
+        m_work_epoch.fetch_add(1);
+        m_work_epoch.notify_all(); // Every worker has a job, wake all of them
+
+        if (is_internal) {
+            for (Usize i = 0; i != m_worker_count; ++i) {
+                worker->wait_until_done(jobs[i]);
+            }
+        }
+        else {
+            latch.wait();
+        }
+        for (Usize i = 0; i != m_worker_count; ++i) {
+            jobs[i].rethrow_if_failed();
+        }
+    }
+
+    template <std::invocable F>
+    auto ThreadPool::run(F&& function) -> void {
+        dtl::ThreadPoolWorker* const worker = dtl::current_worker;
+        if (worker && &worker->pool() == this) {
+            std::invoke(function);
+            return;
+        }
+        dtl::Latch    latch { 1 };
+        dtl::StackJob job   { function, &latch };
+        inject(&job);
+        latch.wait();
+        job.rethrow_if_failed();
+    }
+
+    template <std::invocable F>
+    auto ThreadPool::spawn(F&& function) -> TaskHandle<std::invoke_result_t<std::decay_t<F>&>> {
+        using R = std::invoke_result_t<std::decay_t<F>&>;
+
+        dtl::TaskState* const state = dtl::task_state_cache.acquire();
+        try {
+            state->body = [function = std::forward<F>(function)](MoveOnlyAny& result) mutable {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        std::invoke(function);
+                        result.emplace<TaskResult<R>>(Ok<Unit> {});
+                    }
+                    else {
+                        result.emplace<TaskResult<R>>(Ok<R> { std::invoke(function) });
+                    }
+                }
+                catch (...) {
+                    TaskError error { std::current_exception() };
+                    result.emplace<TaskResult<R>>(Err<TaskError> { std::move(error) });
+                }
+            };
+        }
+        catch (...) {
+            dtl::task_state_cache.recycle(state);
+            throw;
+        }
+        submit(state);
+        return TaskHandle<R> { *this, *state };
+    }
+
+
+    /* Description:
+     *     A move-only handle to a task spawned with `bu::ThreadPool::spawn`.
+     *     Dropping the handle detaches the task, which still runs to
+     *     completion.
+     */
+    template <class R>
+    class [[nodiscard]] TaskHandle {
+        ThreadPool*      m_pool  = nullptr;
+        dtl::TaskState*  m_state = nullptr;
+
+        TaskHandle(ThreadPool& pool, dtl::TaskState& state) noexcept
+            : m_pool  { &pool }
+            , m_state { &state } {}
+
+        friend class ThreadPool;
+    public:
+        TaskHandle() = default;
+
+        TaskHandle(TaskHandle&& other) noexcept
+            : m_pool  { BU exchange(other.m_pool, nullptr) }
+            , m_state { BU exchange(other.m_state, nullptr) } {}
+
+        auto operator=(TaskHandle&& other) noexcept -> TaskHandle& {
+            if (this != &other) {
+                reset();
+                m_pool  = BU exchange(other.m_pool, nullptr);
+                m_state = BU exchange(other.m_state, nullptr);
+            }
+            return *this;
+        }
+
+        ~TaskHandle() {
+            reset();
+        }
+
+        [[nodiscard]]
+        auto is_empty() const noexcept -> bool {
+            return m_state == nullptr;
+        }
+
+        // Precondition: `!is_empty()`
+        [[nodiscard]]
+        auto is_done() const noexcept -> bool {
+            assert(m_state);
+            return m_state->done.load(std::memory_order_acquire);
+        }
+
+        /* Description:
+         *     Waits for the task to complete and takes its result. A
+         *     worker of the same pool executes other jobs while it waits,
+         *     other threads block. The handle is empty afterwards.
+         *
+         * Preconditions:
+         *     `!is_empty()`
+         */
+        auto join() -> TaskResult<R> {
+            assert(m_state);
+            dtl::ThreadPoolWorker* const worker = dtl::current_worker;
+            if (worker && &worker->pool() == m_pool) {
+                worker->wait_until([state = m_state] {
+                    return state->done.load(std::memory_order_acquire);
+                });
+            }
+            else {
+                m_state->done.wait(false, std::memory_order_acquire);
+            }
+            TaskResult<R> result = std::move(m_state->result.unchecked_cast<TaskResult<R>>());
+            reset();
+            return result;
+        }
+
+        // Detaches the task, which still runs to completion
+        auto reset() noexcept -> void {
+            if (m_state) {
+                dtl::TaskState* const state = BU exchange(m_state, nullptr);
+                state->release();
+                m_pool = nullptr;
+            }
+        }
+    };
+}
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "utility.hpp"
+#include "exception.hpp"
+#include "memory.hpp"
+#include "vector.hpp"
+#include "span.hpp"
+#include "perf.hpp"
+
+
+namespace bu::trace {
+    enum class Phase : std::uint32_t {
+        begin,
+        end,
+        instant,
+        counter,
+    };
+
+    // One recorded event. Names point to the static storage of a `bu::Metastring` template
+    // argument.
+    struct Event {
+        std::uint64_t timestamp = 0; // Timestamp counter ticks
+        char const*   name      = nullptr;
+        std::uint64_t payload   = 0;
+        Phase         phase     = Phase::instant;
+        std::uint32_t thread    = 0; // Sequential id of the recording thread, starting from 1
+    };
+
+    static_assert(sizeof(Event) == 32);
+
+    class [[nodiscard]] TraceError : public Exception {
+        char const* m_message;
+        int         m_error_code;
+    public:
+        constexpr TraceError(char const* const msg, int const error_code) noexcept
+            : m_message    { msg }
+            , m_error_code { error_code } {}
+        constexpr auto message() const noexcept -> char const* override {
+            return m_message;
+        }
+        // The `errno` value reported by the failing call
+        [[nodiscard]]
+        constexpr auto error_code() const noexcept -> int {
+            return m_error_code;
+        }
+    };
+}
+
+
+namespace bu::trace::dtl {
+    /* Description:
+     *     A single-producer single-consumer ring of events. The recording
+     *     thread writes a slot and then publishes it by advancing `head`,
+     *     the flusher reads published slots and then releases them by
+     *     advancing `tail`. The producer keeps its own copy of `tail` and
+     *     only reloads it when the ring looks full, so recording does not
+     *     touch the flusher's cache line. Events that do not fit are
+     *     dropped and counted rather than blocking the recording thread.
+     */
+    class [[nodiscard]] RingBuffer {
+    public:
+        static constexpr Usize capacity = 4096;
+    private:
+        alignas(64) std::atomic<Usize> m_head = 0;
+        Usize                          m_cached_tail = 0;
+        std::atomic<Usize>             m_dropped = 0;
+        alignas(64) std::atomic<Usize> m_tail = 0;
+        std::atomic<bool>              m_closed = false;
+        std::uint32_t                  m_thread;
+        Event                          m_events[capacity];
+    public:
+        explicit RingBuffer(std::uint32_t const thread) noexcept
+            : m_thread { thread } {}
+
+        auto push(
+            std::uint64_t const timestamp,
+            char const*   const name,
+            std::uint64_t const payload,
+            Phase         const phase) noexcept -> void
+        {
+            Usize const head = m_head.load(std::memory_order_relaxed);
+            if (head - m_cached_tail == capacity) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head - m_cached_tail == capacity) {
+                    Usize const dropped = m_dropped.load(std::memory_order_relaxed);
+                    m_dropped.store(dropped + 1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            m_events[head % capacity] = Event { timestamp, name, payload, phase, m_thread };
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        // Invokes `f` with every published event, oldest first, and returns how many there were
+        template <class F>
+        auto drain(F&& f) -> Usize {
+            Usize const tail = m_tail.load(std::memory_order_relaxed);
+            Usize const head = m_head.load(std::memory_order_acquire);
+            for (Usize i = tail; i != head; ++i) {
+                f(m_events[i % capacity]);
+            }
+            m_tail.store(head, std::memory_order_release);
+            return head - tail;
+        }
+
+        [[nodiscard]]
+        auto dropped() const noexcept -> Usize {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+        auto close() noexcept -> void {
+            m_closed.store(true, std::memory_order_release);
+        }
+        [[nodiscard]]
+        auto is_closed() const noexcept -> bool {
+            return m_closed.load(std::memory_order_acquire);
+        }
+    };
+
+    // Every live ring, plus the rings of exited threads until they have been drained
+    class [[nodiscard]] Registry {
+        std::mutex                    m_mutex;
+        Vector<UniquePtr<RingBuffer>> m_buffers;
+        Usize                         m_dropped = 0; // Dropped by threads whose rings are released
+        std::uint32_t                 m_next_thread = 1;
+    public:
+        auto add() -> RingBuffer* {
+            std::scoped_lock const lock { m_mutex };
+            return m_buffers.append(make_unique<RingBuffer>(m_next_thread++)).get();
+        }
+
+        template <class F>
+        auto drain(F&& f) -> Usize {
+            std::scoped_lock const lock { m_mutex };
+            Usize count = 0;
+            for (Usize i = 0; i != m_buffers.size();) {
+                RingBuffer& buffer = *m_buffers[i];
+                // Observe the close before draining, so no event published before it is missed
+                bool const closed = buffer.is_closed();
+                count += buffer.drain(f);
+                if (closed) {
+                    m_dropped += buffer.dropped();
+                    if (i != m_buffers.size() - 1)
+                        m_buffers[i].swap(m_buffers.back());
+                    m_buffers.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+            return count;
+        }
+
+        [[nodiscard]]
+        auto dropped() -> Usize {
+            std::scoped_lock const lock { m_mutex };
+            Usize dropped = m_dropped;
+            for (UniquePtr<RingBuffer> const& buffer : m_buffers) {
+                dropped += buffer->dropped();
+            }
+            return dropped;
+        }
+    };
+
+    [[nodiscard]]
+    inline auto registry() -> Registry& {
+        static Registry registry;
+        return registry;
+    }
+
+    // Registers the calling thread's ring on first use and closes it when the thread exits
+    class [[nodiscard]] ThreadBuffer {
+        RingBuffer* m_buffer = nullptr;
+    public:
+        ThreadBuffer() noexcept {
+            try {
+                m_buffer = registry().add();
+            }
+            catch (...) {} // Without a ring this thread's events are not recorded
+        }
+        ThreadBuffer(ThreadBuffer const&) = delete;
+        auto operator=(ThreadBuffer const&) -> ThreadBuffer& = delete;
+        ~ThreadBuffer() {
+            if (m_buffer)
+                m_buffer->close();
+        }
+
+        [[nodiscard]]
+        auto get() const noexcept -> RingBuffer* {
+            return m_buffer;
+        }
+    };
+
+    inline auto record(char const* const name, std::uint64_t const payload, Phase const phase)
+        noexcept -> void
+    {
+        std::uint64_t const timestamp = perf::dtl::read_timestamp();
+        thread_local ThreadBuffer const buffer;
+        if (RingBuffer* const ring = buffer.get())
+            ring->push(timestamp, name, payload, phase);
+    }
+
+    struct FileCloser {
+        auto operator()(std::FILE* const file) const noexcept -> void {
+            std::fclose(file);
+        }
+    };
+
+    // The relation between timestamp counter ticks and wall-clock microseconds
+    struct Calibration {
+        std::uint64_t origin = 0;
+        double        ticks_per_microsecond = 1;
+    };
+
+    // Measures the timestamp counter against the steady clock once, over about ten milliseconds
+    [[nodiscard]]
+    inline auto calibration() -> Calibration const& {
+        static Calibration const calibration = [] {
+            auto const          clock_start = std::chrono::steady_clock::now();
+            std::uint64_t const ticks_start = perf::dtl::read_timestamp();
+            std::this_thread::sleep_for(std::chrono::milliseconds { 10 });
+            auto const          clock_end   = std::chrono::steady_clock::now();
+            std::uint64_t const ticks_end   = perf::dtl::read_timestamp();
+            std::chrono::duration<double, std::micro> const elapsed = clock_end - clock_start;
+            auto const ticks = static_cast<double>(ticks_end - ticks_start);
+            return Calibration { ticks_start, ticks / elapsed.count() };
+        }();
+        return calibration;
+    }
+}
+
+
+namespace bu::trace {
+    /* Description:
+     *     Records an instantaneous event named `name` with an optional
+     *     payload, which is exported as the event's arguments. Recording
+     *     reads the timestamp counter and writes one slot of the calling
+     *     thread's ring without locking or allocating, except for the
+     *     thread's first event, which registers its ring.
+     */
+    template <Metastring name>
+    inline auto instant(std::uint64_t const payload = 0) noexcept -> void {
+        dtl::record(name.string(), payload, Phase::instant);
+    }
+
+    // Records a sample of the counter `name`, which is exported as a counter track
+    template <Metastring name>
+    inline auto counter(std::uint64_t const value) noexcept -> void {
+        dtl::record(name.string(), value, Phase::counter);
+    }
+
+    /* Description:
+     *     Records a begin event on construction and an end event on
+     *     destruction, which are exported as one slice:
+     *
+     *         {
+     *             bu::trace::Scope<"decode_frame"> const scope { frame.id };
+     *             decode(frame);
+     *         }
+     */
+    template <Metastring name>
+    class [[nodiscard]] Scope {
+    public:
+        explicit Scope(std::uint64_t const payload = 0) noexcept {
+            dtl::record(name.string(), payload, Phase::begin);
+        }
+        Scope(Scope const&) = delete;
+        auto operator=(Scope const&) -> Scope& = delete;
+        ~Scope() {
+            dtl::record(name.string(), 0, Phase::end);
+        }
+    };
+
+    /* Description:
+     *     Removes every pending event from the rings of all threads and
+     *     invokes `f` with each of them. Events of one thread arrive in
+     *     the order they were recorded, events of different threads are
+     *     not ordered relative to each other.
+     *
+     * Return value:
+     *     The number of events passed to `f`.
+     */
+    template <class F>
+    auto drain(F&& f) -> Usize {
+        return dtl::registry().drain(f);
+    }
+
+    // The number of events dropped so far because a thread's ring was full
+    [[nodiscard]]
+    inline auto dropped_count() -> Usize {
+        return dtl::registry().dropped();
+    }
+
+
+    /* Description:
+     *     Writes events as a Chrome trace in the JSON object format,
+     *     which chrome://tracing and Perfetto open directly. The closing
+     *     brackets are written on destruction, but both viewers also
+     *     accept a file cut short by a crash.
+     *
+     * Exceptions:
+     *     The constructor throws `bu::trace::TraceError` if the file can
+     *     not be opened.
+     */
+    class [[nodiscard]] ChromeTraceWriter {
+        UniquePtr<std::FILE, dtl::FileCloser> m_file;
+        dtl::Calibration                      m_calibration;
+        bool                                  m_first = true;
+    public:
+        explicit ChromeTraceWriter(char const* const path)
+            : m_calibration { dtl::calibration() }
+        {
+            std::FILE* const file = std::fopen(path, "w");
+            if (!file)
+                throw TraceError { "could not open trace file", errno };
+            m_file.reset(file);
+            std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+        }
+        ChromeTraceWriter(ChromeTraceWriter const&) = delete;
+        auto operator=(ChromeTraceWriter const&) -> ChromeTraceWriter& = delete;
+        ~ChromeTraceWriter() {
+            std::fputs("\n]}\n", m_file.get());
+        }
+
+        auto write(Event const& event) -> void {
+            std::FILE* const file = m_file.get();
+            // Events recorded before calibration have negative times
+            double const microseconds
+                = (static_cast<double>(event.timestamp) - static_cast<double>(m_calibration.origin))
+                / m_calibration.ticks_per_microsecond;
+
+            std::fputs(m_first ? "\n{\"name\":" : ",\n{\"name\":", file);
+            m_first = false;
+            write_string(event.name);
+            std::fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                phase_code(event.phase), microseconds, event.thread);
+            auto const payload = static_cast<unsigned long long>(event.payload);
+            switch (event.phase) {
+            case Phase::instant:
+                std::fprintf(file, ",\"s\":\"t\",\"args\":{\"payload\":%llu}}", payload);
+                break;
+            case Phase::counter:
+                std::fputs(",\"args\":{", file);
+                write_string(event.name);
+                std::fprintf(file, ":%llu}}", payload);
+                break;
+            case Phase::begin:
+                std::fprintf(file, ",\"args\":{\"payload\":%llu}}", payload);
+                break;
+            case Phase::end:
+                std::fputc('}', file);
+                break;
+            }
+        }
+
+        auto flush() -> void {
+            std::fflush(m_file.get());
+        }
+    private:
+        static constexpr auto phase_code(Phase const phase) noexcept -> char {
+            switch (phase) {
+            case Phase::begin:   return 'B';
+            case Phase::end:     return 'E';
+            case Phase::instant: return 'i';
+            case Phase::counter: return 'C';
+            }
+            unreachable();
+        }
+        auto write_string(char const* string) -> void {
+            std::FILE* const file = m_file.get();
+            std::fputc('"', file);
+            for (; *string; ++string) {
+                auto const character = static_cast<unsigned char>(*string);
+                if (character == '"' || character == '\\')
+                    std::fprintf(file, "\\%c", character);
+                else if (character < 0x20)
+                    std::fprintf(file, "\\u%04x", character);
+                else
+                    std::fputc(character, file);
+            }
+            std::fputc('"', file);
+        }
+    };
+
+
+    /* Description:
+     *     Drains the rings of all threads into a Chrome trace file on a
+     *     background thread every `interval`, and once more on
+     *     destruction. Rings hold 4096 events per thread, so the interval
+     *     bounds the event rate a thread can sustain without drops.
+     *
+     * Exceptions:
+     *     The constructor throws `bu::trace::TraceError` if the file can
+     *     not be opened.
+     */
+    class [[nodiscard]] Flusher {
+        ChromeTraceWriter           m_writer;
+        std::mutex                  m_mutex;
+        std::condition_variable_any m_condition;
+        std::jthread                m_thread;
+    public:
+        explicit Flusher(
+            char const*               const path,
+            std::chrono::milliseconds const interval = std::chrono::milliseconds { 50 })
+            : m_writer { path }
+            , m_thread { [this, interval](std::stop_token const stop) { run(stop, interval); } } {}
+
+        Flusher(Flusher const&) = delete;
+        auto operator=(Flusher const&) -> Flusher& = delete;
+        ~Flusher() {
+            m_thread.request_stop();
+            m_thread.join();
+            flush();
+        }
+    private:
+        auto run(std::stop_token const stop, std::chrono::milliseconds const interval) -> void {
+            std::unique_lock lock { m_mutex };
+            while (!stop.stop_requested()) {
+                (void)m_condition.wait_for(lock, stop, interval, [] { return false; });
+                flush();
+            }
+        }
+        auto flush() -> void {
+            (void)drain([this](Event const& event) { m_writer.write(event); });
+            m_writer.flush();
+        }
+    };
+}
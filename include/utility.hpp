@@ -40,6 +40,12 @@ namespace bu {
     constexpr bool always_false = false;
 
 
+    // The type with a single value, used where a value is required but `void` would be meaningful
+    struct Unit {
+        constexpr auto operator==(Unit const&) const noexcept -> bool = default;
+    };
+
+
     template <class T>
     concept nothrow_movable = std::is_nothrow_move_constructible_v<T>
         && std::is_nothrow_move_assignable_v<T>;
@@ -115,12 +121,76 @@ namespace bu {
         constexpr auto string() const noexcept -> char const* {
             return m_buffer;
         }
+        // The length of the string, excluding the null terminator
+        constexpr auto size() const noexcept -> Usize {
+            return n - 1;
+        }
     };
 
     template <Usize n>
     Metastring(char const(&)[n]) -> Metastring<n>;
 
 
+    template <class... Ts>
+    struct Typelist;
+
+}
+
+
+namespace bu::dtl {
+    template <Usize index, class T>
+    struct TypelistLeaf {};
+
+    template <class Indices, class... Ts>
+    struct TypelistLeaves;
+
+    template <Usize... indices, class... Ts>
+    struct TypelistLeaves<std::index_sequence<indices...>, Ts...>
+        : TypelistLeaf<indices, Ts>... {};
+
+    template <class... Ts>
+    using TypelistLeavesOf = TypelistLeaves<std::index_sequence_for<Ts...>, Ts...>;
+
+    // Selects the type at `index` by deducing the corresponding base of
+    // `bu::dtl::TypelistLeaves`, which avoids recursive instantiation
+    template <Usize index, class T>
+    auto typelist_at(TypelistLeaf<index, T> const*) -> std::type_identity<T>;
+
+    // Positions computed by a constant expression, from which `bu::dtl::TypelistSelect`
+    // builds a new list
+    template <Usize capacity>
+    struct TypelistIndices {
+        Usize m_indices[capacity + 1] {};
+        Usize m_size = 0;
+
+        constexpr auto push(Usize const index) noexcept -> void {
+            m_indices[m_size++] = index;
+        }
+    };
+
+    template <class List, auto indices, class = std::make_index_sequence<indices.m_size>>
+    struct TypelistSelect;
+
+    template <class List, auto indices, Usize... positions>
+    struct TypelistSelect<List, indices, std::index_sequence<positions...>> {
+        using Type = Typelist<typename List::template At<indices.m_indices[positions]>...>;
+    };
+}
+
+
+namespace bu {
+
+    /* Description:
+     *     A list of types for compile-time computation. Queries are
+     *     constant expressions over arrays of traits rather than
+     *     recursive instantiations, so they stay cheap to compile for
+     *     long lists. The type-producing members return new lists:
+     *
+     *         // Orders fields by decreasing alignment to eliminate padding
+     *         using Fields = Typelist<char, double, int>
+     *             ::SortBy<std::alignment_of, std::greater<>>;
+     *         static_assert(std::is_same_v<Fields, Typelist<double, int, char>>);
+     */
     template <class... Ts>
     struct Typelist {
         static constexpr Usize size = sizeof...(Ts);
@@ -135,7 +205,98 @@ namespace bu {
 
         template <template <class...> class Trait>
         static constexpr bool none =
-            std::conjunction_v<std::negate<Trait<Ts>>...>;
+            std::conjunction_v<std::negation<Trait<Ts>>...>;
+
+        // The number of occurrences of `T`
+        template <class T>
+        static constexpr Usize count_of = (Usize { std::is_same_v<T, Ts> } + ... + 0);
+
+        template <class T>
+        static constexpr bool contains = count_of<T> != 0;
+
+        // The position of the first occurrence of `T`, or `size` if there is none
+        template <class T>
+        static constexpr Usize index_of = [] {
+            bool const matches[] { std::is_same_v<T, Ts>..., true };
+            Usize index = 0;
+            while (!matches[index]) {
+                ++index;
+            }
+            return index;
+        }();
+
+        // The largest `sizeof` and `alignof` of the types, or 0 if the list is empty
+        static constexpr Usize max_size = [] {
+            Usize max = 0;
+            ((max = sizeof(Ts) > max ? sizeof(Ts) : max), ...);
+            return max;
+        }();
+        static constexpr Usize max_align = [] {
+            Usize max = 0;
+            ((max = alignof(Ts) > max ? alignof(Ts) : max), ...);
+            return max;
+        }();
+
+        template <Usize index>
+            requires (index < size)
+        using At = typename decltype(
+            dtl::typelist_at<index>(static_cast<dtl::TypelistLeavesOf<Ts...>*>(nullptr)))::type;
+
+        // Instantiates `Template` with the types, for example
+        // `Typelist<int, float>::Into<bu::Variant>`
+        template <template <class...> class Template>
+        using Into = Template<Ts...>;
+
+        // Applies a type transformation, such as `std::add_pointer_t`, to each type
+        template <template <class> class F>
+        using Map = Typelist<F<Ts>...>;
+
+        // The types for which `Trait<T>::value` is true, in their original order
+        template <template <class> class Trait>
+        using Filter = typename dtl::TypelistSelect<Typelist, [] {
+            bool const keep[] { Trait<Ts>::value..., false };
+            dtl::TypelistIndices<size> indices;
+            for (Usize i = 0; i != size; ++i) {
+                if (keep[i])
+                    indices.push(i);
+            }
+            return indices;
+        }()>::Type;
+
+        // The first occurrence of each type, in their original order
+        using Unique = typename dtl::TypelistSelect<Typelist, [] {
+            Usize const first[] { index_of<Ts>..., 0 };
+            dtl::TypelistIndices<size> indices;
+            for (Usize i = 0; i != size; ++i) {
+                if (first[i] == i)
+                    indices.push(i);
+            }
+            return indices;
+        }()>::Type;
+
+        /* Description:
+         *     Stably sorts the types by `Key<T>::value`, ordered by
+         *     `Compare`. `SortBy<std::alignment_of, std::greater<>>`
+         *     orders the types so that consecutive members are never
+         *     separated by padding.
+         */
+        template <template <class> class Key, class Compare = std::less<>>
+        using SortBy = typename dtl::TypelistSelect<Typelist, [] {
+            using KeyType = typename std::conditional_t<size == 0,
+                std::type_identity<Usize>,
+                std::common_type<std::remove_cv_t<decltype(Key<Ts>::value)>...>>::type;
+            KeyType const keys[] { static_cast<KeyType>(Key<Ts>::value)..., KeyType {} };
+            dtl::TypelistIndices<size> indices;
+            for (Usize i = 0; i != size; ++i) {
+                Usize j = indices.m_size;
+                indices.push(i);
+                for (; j != 0 && Compare {}(keys[i], keys[indices.m_indices[j - 1]]); --j) {
+                    indices.m_indices[j] = indices.m_indices[j - 1];
+                }
+                indices.m_indices[j] = i;
+            }
+            return indices;
+        }()>::Type;
     };
 
 }
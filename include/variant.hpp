@@ -0,0 +1,509 @@
+#pragma once
+
+#include "utility.hpp"
+#include "option.hpp"
+#include "exception.hpp"
+
+
+namespace bu {
+    template <class... Ts>
+    class Variant;
+
+    using BadVariantAccess = StatelessException<"bad variant access">;
+
+
+    /* Description:
+     *     Describes object representations which no value of `T` uses.
+     *     `bu::Variant` stores its discriminant in them when every other
+     *     alternative is empty, so `Variant<bool, Unit>` occupies a single
+     *     byte. A specialization provides `count` such states along with
+     *     `store(storage, state)`, which writes the state `state < count`
+     *     over `storage`, and `load(storage)`, which returns the state held
+     *     by `storage` or `count` if it holds a value of `T`. Variants
+     *     with such a layout can not be inspected in constant expressions.
+     */
+    template <class T>
+    struct Niche {
+        static constexpr Usize count = 0;
+    };
+
+    template <>
+    struct Niche<bool> {
+        static_assert(sizeof(bool) == 1);
+
+        static constexpr Usize count = 254;
+
+        static auto store(void* const storage, Usize const state) noexcept -> void {
+            auto const byte = static_cast<unsigned char>(state + 2);
+            std::memcpy(storage, &byte, 1);
+        }
+        static auto load(void const* const storage) noexcept -> Usize {
+            unsigned char byte;
+            std::memcpy(&byte, storage, 1);
+            return byte < 2 ? count : byte - 2u;
+        }
+    };
+}
+
+
+namespace bu::dtl {
+    template <class... Ts>
+    union VariantStorage {};
+
+    template <class T, class... Ts>
+    union VariantStorage<T, Ts...> {
+        T                     m_head;
+        VariantStorage<Ts...> m_tail;
+
+        constexpr VariantStorage() noexcept {}
+
+        ~VariantStorage()
+            requires std::is_trivially_destructible_v<T>
+                  && (std::is_trivially_destructible_v<Ts> && ...) = default;
+
+        // The active alternative is destroyed by the owning `bu::Variant`
+        constexpr ~VariantStorage() {}
+    };
+
+    template <Usize i, class S> [[nodiscard]]
+    constexpr auto storage_get(S&& storage) noexcept -> auto&& {
+        if constexpr (i == 0)
+            return std::forward<S>(storage).m_head;
+        else
+            return storage_get<i - 1>(std::forward<S>(storage).m_tail);
+    }
+
+    // The smallest unsigned type able to hold every index in `[0, n)`
+    template <Usize n>
+    using VariantIndex =
+        std::conditional_t<n - 1 <= maximum<std::uint8_t>,  std::uint8_t,
+        std::conditional_t<n - 1 <= maximum<std::uint16_t>, std::uint16_t,
+            std::uint32_t>>;
+
+    // Takes the place of the index when the discriminant is stored in a niche
+    struct VariantNicheIndex {};
+
+    // The index of the alternative whose niche can hold the discriminant, or `sizeof...(Ts)`
+    // if there is none
+    template <class... Ts>
+    constexpr Usize variant_niche_index = [] {
+        constexpr Usize n = sizeof...(Ts);
+        if (n < 2)
+            return n;
+
+        bool const fits[]  { (Niche<Ts>::count >= n - 1)... };
+        bool const empty[] { std::is_empty_v<Ts>... };
+
+        Usize empty_count = 0;
+        for (bool const is_empty : empty) {
+            empty_count += is_empty;
+        }
+        for (Usize i = 0; i != n; ++i) {
+            if (fits[i] && !empty[i] && empty_count == n - 1)
+                return i;
+        }
+        return n;
+    }();
+
+    // Alternatives which can replace the active one without leaving the variant empty if
+    // construction throws
+    template <class T, class... Args>
+    concept variant_emplaceable = std::is_constructible_v<T, Args...>
+        && (std::is_nothrow_constructible_v<T, Args...> || std::is_nothrow_move_constructible_v<T>);
+
+
+    // Up to this many alternatives are dispatched with a chain of comparisons, more with
+    // `switch` statements
+    inline constexpr Usize variant_branch_limit = 8;
+
+    template <Usize i, Usize n, class R, class F>
+    constexpr auto visit_index_chain(Usize const index, F& f) -> R {
+        if constexpr (i + 1 == n) {
+            return f(std::integral_constant<Usize, i> {});
+        }
+        else {
+            if (index == i)
+                return f(std::integral_constant<Usize, i> {});
+            else
+                return visit_index_chain<i + 1, n, R>(index, f);
+        }
+    }
+
+    // Cases past the last index repeat it, so the compiler merges them with the default case
+    template <Usize i, Usize n, class R, class F>
+    constexpr auto visit_index_case(F& f) -> R {
+        return f(std::integral_constant<Usize, (i < n ? i : n - 1)> {});
+    }
+
+    // Dispatches indices from `offset` in blocks of 16, each of which is lowered to a jump table
+    template <Usize offset, Usize n, class R, class F>
+    constexpr auto visit_index_switch(Usize const index, F& f) -> R {
+        switch (index - offset) {
+            case 0:  return visit_index_case<offset + 0, n, R>(f);
+            case 1:  return visit_index_case<offset + 1, n, R>(f);
+            case 2:  return visit_index_case<offset + 2, n, R>(f);
+            case 3:  return visit_index_case<offset + 3, n, R>(f);
+            case 4:  return visit_index_case<offset + 4, n, R>(f);
+            case 5:  return visit_index_case<offset + 5, n, R>(f);
+            case 6:  return visit_index_case<offset + 6, n, R>(f);
+            case 7:  return visit_index_case<offset + 7, n, R>(f);
+            case 8:  return visit_index_case<offset + 8, n, R>(f);
+            case 9:  return visit_index_case<offset + 9, n, R>(f);
+            case 10: return visit_index_case<offset + 10, n, R>(f);
+            case 11: return visit_index_case<offset + 11, n, R>(f);
+            case 12: return visit_index_case<offset + 12, n, R>(f);
+            case 13: return visit_index_case<offset + 13, n, R>(f);
+            case 14: return visit_index_case<offset + 14, n, R>(f);
+            case 15: return visit_index_case<offset + 15, n, R>(f);
+            default:
+                if constexpr (offset + 16 < n)
+                    return visit_index_switch<offset + 16, n, R>(index, f);
+                else
+                    return visit_index_case<n - 1, n, R>(f);
+        }
+    }
+
+    /* Description:
+     *     Invokes `f(std::integral_constant<Usize, index> {})`. `index`
+     *     must be below `n`. The return type is that of the invocation
+     *     with index 0, to which the other results must be convertible.
+     *     `f` is inlined into every branch, and a short chain of
+     *     comparisons may be turned into conditional moves.
+     */
+    template <Usize n, class F>
+    constexpr auto visit_index(Usize const index, F&& f)
+        -> decltype(f(std::integral_constant<Usize, 0> {}))
+    {
+        using R = decltype(f(std::integral_constant<Usize, 0> {}));
+        if constexpr (n <= variant_branch_limit)
+            return visit_index_chain<0, n, R>(index, f);
+        else
+            return visit_index_switch<0, n, R>(index, f);
+    }
+
+
+    struct VariantAccess {
+        template <class V> [[nodiscard]]
+        static constexpr auto storage(V&& variant) noexcept -> auto&& {
+            return std::forward<V>(variant).m_storage;
+        }
+    };
+
+    template <class>
+    constexpr bool is_variant = false;
+    template <class... Ts>
+    constexpr bool is_variant<Variant<Ts...>> = true;
+}
+
+
+namespace bu {
+
+    /* Description:
+     *     Holds a value of exactly one of `Ts`, and is never empty.
+     *     The discriminant is the smallest unsigned integer able to
+     *     represent every index, or occupies no space at all when it fits
+     *     in a `bu::Niche` of the only non-empty alternative. Copying,
+     *     moving and destruction are trivial when they are trivial for
+     *     every alternative.
+     */
+    template <class... Ts>
+    class [[nodiscard]] Variant {
+        static_assert(sizeof...(Ts) != 0);
+        static_assert((std::is_object_v<Ts> && ...) && !(std::is_array_v<Ts> || ...));
+
+        static constexpr Usize alternative_count = sizeof...(Ts);
+        static constexpr Usize niche_index       = dtl::variant_niche_index<Ts...>;
+        static constexpr bool  has_niche         = niche_index != alternative_count;
+
+        template <Usize i>
+        using Alternative = typename Typelist<Ts...>::template At<i>;
+
+        using IndexType = std::conditional_t<has_niche,
+            dtl::VariantNicheIndex, dtl::VariantIndex<alternative_count>>;
+
+        dtl::VariantStorage<Ts...>  m_storage;
+        [[no_unique_address]] IndexType m_index;
+
+        friend struct dtl::VariantAccess;
+
+        constexpr auto set_index(Usize const index) noexcept -> void {
+            if constexpr (has_niche) {
+                if (index != niche_index) {
+                    Niche<Alternative<niche_index>>::store(
+                        std::addressof(m_storage), index < niche_index ? index : index - 1);
+                }
+            }
+            else {
+                m_index = static_cast<IndexType>(index);
+            }
+        }
+
+        template <Usize i, class... Args>
+        constexpr auto construct(Args&&... args) -> void {
+            auto* const storage = std::addressof(dtl::storage_get<i>(m_storage));
+            std::construct_at(storage, std::forward<Args>(args)...);
+            set_index(i);
+        }
+
+        constexpr auto destroy() noexcept -> void {
+            if constexpr (!Typelist<Ts...>::template all<std::is_trivially_destructible>) {
+                dtl::visit_index<alternative_count>(index(), [&](auto const i) {
+                    constexpr Usize index = decltype(i)::value;
+                    std::destroy_at(std::addressof(dtl::storage_get<index>(m_storage)));
+                });
+            }
+        }
+
+        // Replaces the active alternative, constructing the new one before destroying the old
+        // one if the construction may throw
+        template <Usize i, class... Args>
+        constexpr auto replace(Args&&... args)
+            noexcept(std::is_nothrow_constructible_v<Alternative<i>, Args&&...>) -> void
+        {
+            using T = Alternative<i>;
+            if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+                destroy();
+                construct<i>(std::forward<Args>(args)...);
+            }
+            else {
+                T temporary(std::forward<Args>(args)...);
+                destroy();
+                construct<i>(std::move(temporary));
+            }
+        }
+    public:
+        using Alternatives = Typelist<Ts...>;
+
+        template <class T>
+        static constexpr Usize index_of = Alternatives::template index_of<T>;
+
+        constexpr Variant()
+            noexcept(std::is_nothrow_default_constructible_v<Alternative<0>>)
+            requires std::is_default_constructible_v<Alternative<0>>
+        {
+            construct<0>();
+        }
+
+        template <class T, class... Args>
+            requires (Alternatives::template count_of<T> == 1)
+                  && std::is_constructible_v<T, Args&&...>
+        constexpr explicit Variant(InPlaceType<T>, Args&&... args)
+            noexcept(std::is_nothrow_constructible_v<T, Args&&...>)
+        {
+            construct<index_of<T>>(std::forward<Args>(args)...);
+        }
+
+        // Only converts from the alternatives themselves, other types must be constructed with
+        // `bu::in_place_type`
+        template <class U>
+            requires (Alternatives::template count_of<std::remove_cvref_t<U>> == 1)
+                  && std::is_constructible_v<std::remove_cvref_t<U>, U&&>
+        constexpr Variant(U&& value)
+            noexcept(std::is_nothrow_constructible_v<std::remove_cvref_t<U>, U&&>)
+        {
+            construct<index_of<std::remove_cvref_t<U>>>(std::forward<U>(value));
+        }
+
+        Variant(Variant const&)
+            requires Alternatives::template all<std::is_trivially_copy_constructible> = default;
+
+        constexpr Variant(Variant const& other)
+            noexcept(Alternatives::template all<std::is_nothrow_copy_constructible>)
+            requires Alternatives::template all<std::is_copy_constructible>
+                && (!Alternatives::template all<std::is_trivially_copy_constructible>)
+        {
+            dtl::visit_index<alternative_count>(other.index(), [&](auto const i) {
+                constexpr Usize index = decltype(i)::value;
+                construct<index>(dtl::storage_get<index>(other.m_storage));
+            });
+        }
+
+        Variant(Variant&&)
+            requires Alternatives::template all<std::is_trivially_move_constructible> = default;
+
+        constexpr Variant(Variant&& other)
+            noexcept(Alternatives::template all<std::is_nothrow_move_constructible>)
+            requires Alternatives::template all<std::is_move_constructible>
+                && (!Alternatives::template all<std::is_trivially_move_constructible>)
+        {
+            dtl::visit_index<alternative_count>(other.index(), [&](auto const i) {
+                constexpr Usize index = decltype(i)::value;
+                construct<index>(std::move(dtl::storage_get<index>(other.m_storage)));
+            });
+        }
+
+        auto operator=(Variant const&) -> Variant&
+            requires Alternatives::template all<std::is_trivially_copy_constructible>
+                  && Alternatives::template all<std::is_trivially_copy_assignable>
+                  && Alternatives::template all<std::is_trivially_destructible> = default;
+
+        constexpr auto operator=(Variant const& other)
+            noexcept(Alternatives::template all<std::is_nothrow_copy_constructible>
+                  && Alternatives::template all<std::is_nothrow_copy_assignable>) -> Variant&
+            requires (dtl::variant_emplaceable<Ts, Ts const&> && ...)
+                  && Alternatives::template all<std::is_copy_assignable>
+                  && (!(Alternatives::template all<std::is_trivially_copy_constructible>
+                     && Alternatives::template all<std::is_trivially_copy_assignable>
+                     && Alternatives::template all<std::is_trivially_destructible>))
+        {
+            if (this != &other) {
+                dtl::visit_index<alternative_count>(other.index(), [&](auto const i) {
+                    constexpr Usize index = decltype(i)::value;
+                    auto const& source = dtl::storage_get<index>(other.m_storage);
+                    if (this->index() == index)
+                        dtl::storage_get<index>(m_storage) = source;
+                    else
+                        replace<index>(source);
+                });
+            }
+            return *this;
+        }
+
+        auto operator=(Variant&&) -> Variant&
+            requires Alternatives::template all<std::is_trivially_move_constructible>
+                  && Alternatives::template all<std::is_trivially_move_assignable>
+                  && Alternatives::template all<std::is_trivially_destructible> = default;
+
+        constexpr auto operator=(Variant&& other)
+            noexcept(Alternatives::template all<std::is_nothrow_move_constructible>
+                  && Alternatives::template all<std::is_nothrow_move_assignable>) -> Variant&
+            requires (dtl::variant_emplaceable<Ts, Ts&&> && ...)
+                  && Alternatives::template all<std::is_move_assignable>
+                  && (!(Alternatives::template all<std::is_trivially_move_constructible>
+                     && Alternatives::template all<std::is_trivially_move_assignable>
+                     && Alternatives::template all<std::is_trivially_destructible>))
+        {
+            if (this != &other) {
+                dtl::visit_index<alternative_count>(other.index(), [&](auto const i) {
+                    constexpr Usize index = decltype(i)::value;
+                    auto& source = dtl::storage_get<index>(other.m_storage);
+                    if (this->index() == index)
+                        dtl::storage_get<index>(m_storage) = std::move(source);
+                    else
+                        replace<index>(std::move(source));
+                });
+            }
+            return *this;
+        }
+
+        ~Variant()
+            requires Alternatives::template all<std::is_trivially_destructible> = default;
+
+        constexpr ~Variant()
+            noexcept(Alternatives::template all<std::is_nothrow_destructible>)
+        {
+            destroy();
+        }
+
+        // The position of the active alternative in `Ts`
+        [[nodiscard]]
+        constexpr auto index() const noexcept -> Usize {
+            if constexpr (has_niche) {
+                using Traits = Niche<Alternative<niche_index>>;
+                Usize const state = Traits::load(std::addressof(m_storage));
+                if (state == Traits::count)
+                    return niche_index;
+                else
+                    return state < niche_index ? state : state + 1;
+            }
+            else {
+                return m_index;
+            }
+        }
+
+        template <class T> [[nodiscard]]
+        constexpr auto is() const noexcept -> bool
+            requires (Alternatives::template count_of<T> == 1)
+        {
+            return index() == index_of<T>;
+        }
+
+        template <class T> [[nodiscard]]
+        constexpr auto get() const -> T const&
+            requires (Alternatives::template count_of<T> == 1)
+        {
+            if (is<T>())
+                return dtl::storage_get<index_of<T>>(m_storage);
+            else
+                throw BadVariantAccess {};
+        }
+        template <class T> [[nodiscard]]
+        constexpr auto get() -> T&
+            requires (Alternatives::template count_of<T> == 1)
+        {
+            return const_cast<T&>(const_cast<Variant const*>(this)->template get<T>());
+        }
+
+        template <class T> [[nodiscard]]
+        constexpr auto get_if() const noexcept -> Option<T const&>
+            requires (Alternatives::template count_of<T> == 1)
+        {
+            if (is<T>())
+                return dtl::storage_get<index_of<T>>(m_storage);
+            else
+                return nullopt;
+        }
+        template <class T> [[nodiscard]]
+        constexpr auto get_if() noexcept -> Option<T&>
+            requires (Alternatives::template count_of<T> == 1)
+        {
+            if (is<T>())
+                return dtl::storage_get<index_of<T>>(m_storage);
+            else
+                return nullopt;
+        }
+
+        /* Description:
+         *     Replaces the active alternative with a `T` constructed from
+         *     `args`. If the construction may throw, the new value is
+         *     constructed before the old one is destroyed.
+         *
+         * Return value:
+         *     A reference to the new value
+         */
+        template <class T, class... Args>
+            requires (Alternatives::template count_of<T> == 1)
+                  && dtl::variant_emplaceable<T, Args&&...>
+        constexpr auto emplace(Args&&... args)
+            noexcept(std::is_nothrow_constructible_v<T, Args&&...>) -> T&
+        {
+            replace<index_of<T>>(std::forward<Args>(args)...);
+            return dtl::storage_get<index_of<T>>(m_storage);
+        }
+
+        [[nodiscard]]
+        constexpr auto operator==(Variant const& other) const -> bool
+            requires (std::equality_comparable<Ts> && ...)
+        {
+            if (index() != other.index())
+                return false;
+            return dtl::visit_index<alternative_count>(index(), [&](auto const i) -> bool {
+                constexpr Usize index = decltype(i)::value;
+                return dtl::storage_get<index>(m_storage)
+                    == dtl::storage_get<index>(other.m_storage);
+            });
+        }
+    };
+
+
+    /* Description:
+     *     Invokes `f` with the active alternative of `variant`, forwarded
+     *     with the value category of `variant`. Variants with up to
+     *     `bu::dtl::variant_branch_limit` alternatives are dispatched with
+     *     comparisons, others with jump tables.
+     *
+     * Return value:
+     *     The result of the invocation, converted to the type returned
+     *     for the first alternative
+     */
+    template <class F, class V>
+        requires dtl::is_variant<std::remove_cvref_t<V>>
+    constexpr auto visit(F&& f, V&& variant) -> decltype(auto) {
+        return dtl::visit_index<std::remove_cvref_t<V>::Alternatives::size>(variant.index(),
+            [&](auto const i) -> decltype(auto) {
+                auto&& storage = dtl::VariantAccess::storage(std::forward<V>(variant));
+                return std::invoke(std::forward<F>(f),
+                    dtl::storage_get<decltype(i)::value>(std::forward<decltype(storage)>(storage)));
+            });
+    }
+}
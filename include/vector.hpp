@@ -4,7 +4,9 @@
 #include "option.hpp"
 #include "exception.hpp"
 #include "allocator.hpp"
+#include "perf_fwd.hpp"
 #include "memory.hpp"
+#include "span.hpp"
 
 
 namespace bu {
@@ -35,8 +37,17 @@ namespace bu {
             if (!count)
                 return;
             m_ptr = allocate(count);
-            for (T* ptr = m_ptr; ptr != m_ptr + m_len; ++ptr) {
-                std::construct_at(ptr);
+            if constexpr (std::is_nothrow_default_constructible_v<T>) {
+                uninitialized_value_construct(m_ptr, m_ptr + m_len);
+            }
+            else {
+                try {
+                    uninitialized_value_construct(m_ptr, m_ptr + m_len);
+                }
+                catch (...) {
+                    deallocate(m_ptr, m_cap);
+                    throw;
+                }
             }
         }
 
@@ -45,12 +56,21 @@ namespace bu {
                 && nothrow_alloc<A>)
             : m_allocator { other.m_allocator }
             , m_len { other.m_len }
-            , m_cap { other.m_cap }
+            , m_cap { other.m_len }
         {
             if (m_len) {
                 m_ptr = allocate(m_len);
-                for (Usize i = 0; i != m_len; ++i) {
-                    std::construct_at(m_ptr + i, other.m_ptr[i]);
+                if constexpr (std::is_nothrow_copy_constructible_v<T>) {
+                    uninitialized_copy(other.m_ptr, other.m_ptr + m_len, m_ptr);
+                }
+                else {
+                    try {
+                        uninitialized_copy(other.m_ptr, other.m_ptr + m_len, m_ptr);
+                    }
+                    catch (...) {
+                        deallocate(m_ptr, m_cap);
+                        throw;
+                    }
                 }
             }
         }
@@ -63,31 +83,44 @@ namespace bu {
 
         constexpr auto operator=(Vector const& other)
             noexcept(nothrow_copyable<T>
-                && std::is_nothrow_copy_assignable_v<A>) -> Vector&
+                && std::is_nothrow_copy_assignable_v<A>
+                && nothrow_alloc<A>) -> Vector&
         {
             // TODO: Allocator equality
-            if (m_len == other.m_len) {
-                for (Usize i = 0; i != m_len; ++i) {
-                    m_ptr[i] = other.m_ptr[i];
-                }
+            if (this == &other)
+                return *this;
+
+            if (other.m_len > m_cap) {
+                Vector copy = other;
+                swap(copy);
+                return *this;
             }
-            else if (m_len >= other.m_len) {
-                Usize i = 0;
-                for (; i != m_len; ++i) {
-                    m_ptr[i] = other.m_ptr[i];
-                }
-                for (; i != other.m_len; ++i) {
-                    m_ptr[i].~T();
+
+            Usize const common = m_len < other.m_len ? m_len : other.m_len;
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                if (!std::is_constant_evaluated()) {
+                    if (other.m_len)
+                        std::memcpy(m_ptr, other.m_ptr, other.m_len * sizeof(T));
+                    m_len = other.m_len;
+                    return *this;
                 }
-                m_len = other.m_len;
             }
-            else {
-                std::terminate();
+            for (Usize i = 0; i != common; ++i) {
+                m_ptr[i] = other.m_ptr[i];
             }
+            uninitialized_copy(other.m_ptr + common, other.m_ptr + other.m_len, m_ptr + common);
+            destroy(m_ptr + common, m_ptr + m_len);
+            m_len = other.m_len;
             return *this;
         }
 
-        constexpr auto operator=(Vector&&) noexcept -> Vector&;
+        constexpr auto operator=(Vector&& other) noexcept -> Vector& {
+            if (this != &other) {
+                this->~Vector();
+                std::construct_at(this, std::move(other));
+            }
+            return *this;
+        }
 
         constexpr ~Vector()
             noexcept(std::is_nothrow_destructible_v<T>
@@ -105,6 +138,163 @@ namespace bu {
         constexpr auto is_empty() const noexcept -> bool {
             return m_len == 0;
         }
+        [[nodiscard]]
+        constexpr auto capacity() const noexcept -> Usize {
+            return m_cap;
+        }
+
+        /* Description:
+         *     Ensures that the vector can hold at least `new_capacity`
+         *     elements without reallocating. Existing elements are
+         *     moved to the new storage if their move constructor is
+         *     `noexcept`, and copied otherwise. Trivially relocatable
+         *     elements are moved with a single `memcpy`.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - A::allocate(bu::Usize)
+         *     - T::T(T const&), if T is not nothrow move constructible
+         */
+        constexpr auto reserve(Usize const new_capacity)
+            noexcept(nothrow_alloc<A>
+                && std::is_nothrow_move_constructible_v<T>) -> void
+        {
+            if (new_capacity <= m_cap)
+                return;
+
+            [[maybe_unused]]
+            perf::Scope<"bu::Vector::reserve", perf::hooks_enabled> const probe;
+            T* const new_ptr = allocate(new_capacity);
+            if constexpr (is_trivially_relocatable<T> || std::is_nothrow_move_constructible_v<T>) {
+                uninitialized_relocate(m_ptr, m_ptr + m_len, new_ptr);
+            }
+            else {
+                try {
+                    uninitialized_copy(m_ptr, m_ptr + m_len, new_ptr);
+                }
+                catch (...) {
+                    deallocate(new_ptr, new_capacity);
+                    throw;
+                }
+                destroy(m_ptr, m_ptr + m_len);
+            }
+            deallocate(m_ptr, m_cap);
+
+            m_ptr = new_ptr;
+            m_cap = new_capacity;
+        }
+
+        /* Description:
+         *     Constructs a new element at the end of the vector with
+         *     `T(std::forward<Args>(args)...)`, growing the capacity
+         *     geometrically if the vector is full.
+         *
+         * Return value:
+         *     Reference to the newly constructed element.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(Args&&...)
+         *     - A::allocate(bu::Usize)
+         */
+        template <class... Args>
+        constexpr auto append(Args&&... args)
+            noexcept(std::is_nothrow_constructible_v<T, Args&&...>
+                && std::is_nothrow_move_constructible_v<T>
+                && nothrow_alloc<A>) -> T&
+        {
+            if (m_len == m_cap) {
+                // Construct into a temporary first, `args` may refer to an element of `this`
+                T element(std::forward<Args>(args)...);
+                reserve(m_cap ? m_cap * 2 : 4);
+                return *std::construct_at(m_ptr + m_len++, std::move(element));
+            }
+            return *std::construct_at(m_ptr + m_len++, std::forward<Args>(args)...);
+        }
+
+        /* Description:
+         *     Appends copies of `elements` to the end of the vector,
+         *     reallocating at most once. Trivially copyable elements
+         *     are copied with a single `memcpy`.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - T::T(T const&)
+         *     - A::allocate(bu::Usize)
+         *
+         * Preconditions:
+         *     `elements` must not refer to elements of `this`.
+         */
+        constexpr auto extend(Span<T const> const elements)
+            noexcept(std::is_nothrow_copy_constructible_v<T>
+                && std::is_nothrow_move_constructible_v<T>
+                && nothrow_alloc<A>) -> void
+        {
+            Usize const count = elements.size();
+            if (m_len + count > m_cap) {
+                reserve(m_len + count > m_cap * 2 ? m_len + count : m_cap * 2);
+            }
+            uninitialized_copy(elements.begin(), elements.end(), m_ptr + m_len);
+            m_len += count;
+        }
+
+        /* Description:
+         *     Appends `count` elements whose object representations are
+         *     copied from `bytes`, reallocating at most once. `bytes`
+         *     need not be aligned for `T`, and the new elements are
+         *     written only once.
+         *
+         * Exceptions:
+         *     Invokes potentially throwing operations:
+         *     - A::allocate(bu::Usize)
+         */
+        auto extend_bytes(std::byte const* const bytes, Usize const count)
+            noexcept(nothrow_alloc<A>) -> void
+            requires std::is_trivially_copyable_v<T>
+        {
+            if (count == 0)
+                return;
+            if (m_len + count > m_cap) {
+                reserve(m_len + count > m_cap * 2 ? m_len + count : m_cap * 2);
+            }
+            std::memcpy(m_ptr + m_len, bytes, count * sizeof(T));
+            m_len += count;
+        }
+
+        constexpr auto pop_back()
+            noexcept(std::is_nothrow_destructible_v<T>) -> void
+        {
+            assert(m_len != 0);
+            destroy(m_ptr[--m_len]);
+        }
+
+        constexpr auto clear()
+            noexcept(std::is_nothrow_destructible_v<T>) -> void
+        {
+            destroy(m_ptr, m_ptr + m_len);
+            m_len = 0;
+        }
+
+        [[nodiscard]]
+        constexpr auto front() const noexcept -> T const& {
+            assert(m_len != 0);
+            return m_ptr[0];
+        }
+        [[nodiscard]]
+        constexpr auto front() noexcept -> T& {
+            assert(m_len != 0);
+            return m_ptr[0];
+        }
+        [[nodiscard]]
+        constexpr auto back() const noexcept -> T const& {
+            assert(m_len != 0);
+            return m_ptr[m_len - 1];
+        }
+        [[nodiscard]]
+        constexpr auto back() noexcept -> T& {
+            assert(m_len != 0);
+            return m_ptr[m_len - 1];
+        }
 
         [[nodiscard]] constexpr auto data() const noexcept -> T const* { return m_ptr; }
         [[nodiscard]] constexpr auto data()       noexcept -> T      * { return m_ptr; }
@@ -144,14 +334,12 @@ namespace bu {
         constexpr auto operator==(Vector<T2, A2> const& other) const
             noexcept(noexcept(std::declval<T>() != std::declval<T2>())) -> bool
         {
-            if (m_len != other.m_len)
+            if (m_len != other.size())
                 return false;
 
-            auto* const a = m_ptr;
-            auto* const b = other.m_ptr;
-            auto* const c = m_ptr + m_len;
-
-            for (; a != c; ++a, ++b) {
+            T const*  a = m_ptr;
+            T2 const* b = other.data();
+            for (; a != m_ptr + m_len; ++a, ++b) {
                 if (*a != *b)
                     return false;
             }
@@ -160,11 +348,11 @@ namespace bu {
 
         constexpr auto swap(Vector& other) noexcept -> void {
             if constexpr (AllocatorTraits<A>::propagate_on_swap) {
-                swap(m_allocator, other.m_allocator);
+                BU swap(m_allocator, other.m_allocator);
             }
-            swap(m_ptr, other.m_ptr);
-            swap(m_len, other.m_len);
-            swap(m_cap, other.m_cap);
+            BU swap(m_ptr, other.m_ptr);
+            BU swap(m_len, other.m_len);
+            BU swap(m_cap, other.m_cap);
         }
     private:
         [[nodiscard]]